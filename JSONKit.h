@@ -112,6 +112,15 @@ typedef NSUInteger JKFlags;
   JKParseOptionLooseUnicode    : Normally the decoder will stop with an error at any malformed Unicode.
                                  This option allows JSON with malformed Unicode to be parsed without reporting an error.
                                  Any malformed Unicode is replaced with \uFFFD, or "REPLACEMENT CHARACTER".
+  JKParseOptionNoCopyStrings   : Only used by the NSData methods.  Strings that contain no \ escapes are created with
+                                 CFStringCreateWithBytesNoCopy() and point directly in to the NSData's bytes, which is retained
+                                 until the last such string is deallocated.  The NSData MUST NOT be mutated after parsing.
+
+  JKSerializeOptionParallel    : Large top level NSArray / NSDictionary objects are split in to chunks that are serialized
+                                 concurrently on a global dispatch queue, then joined in order.  The output is byte for byte
+                                 identical to the serial encoder.  Ignored when an unsupported class delegate or block is
+                                 used, on single CPU hardware, or when blocks are not available.  The collection, and every
+                                 object it contains, MUST NOT be mutated while it is being serialized.
  */
 
 enum {
@@ -121,7 +130,8 @@ enum {
   JKParseOptionUnicodeNewlines          = (1 << 1),
   JKParseOptionLooseUnicode             = (1 << 2),
   JKParseOptionPermitTextAfterValidJSON = (1 << 3),
-  JKParseOptionValidFlags               = (JKParseOptionComments | JKParseOptionUnicodeNewlines | JKParseOptionLooseUnicode | JKParseOptionPermitTextAfterValidJSON),
+  JKParseOptionNoCopyStrings            = (1 << 4),
+  JKParseOptionValidFlags               = (JKParseOptionComments | JKParseOptionUnicodeNewlines | JKParseOptionLooseUnicode | JKParseOptionPermitTextAfterValidJSON | JKParseOptionNoCopyStrings),
 };
 typedef JKFlags JKParseOptionFlags;
 
@@ -130,13 +140,15 @@ enum {
   JKSerializeOptionPretty               = (1 << 0),
   JKSerializeOptionEscapeUnicode        = (1 << 1),
   JKSerializeOptionEscapeForwardSlashes = (1 << 4),
-  JKSerializeOptionValidFlags           = (JKSerializeOptionPretty | JKSerializeOptionEscapeUnicode | JKSerializeOptionEscapeForwardSlashes),
+  JKSerializeOptionParallel             = (1 << 5),
+  JKSerializeOptionValidFlags           = (JKSerializeOptionPretty | JKSerializeOptionEscapeUnicode | JKSerializeOptionEscapeForwardSlashes | JKSerializeOptionParallel),
 };
 typedef JKFlags JKSerializeOptionFlags;
 
 #ifdef    __OBJC__
 
 typedef struct JKParseState JKParseState; // Opaque internal, private type.
+typedef struct JKDocument   JKDocument;   // Opaque, see "Read-only document methods" below.
 
 // As a general rule of thumb, if you use a method that doesn't accept a JKParseOptionFlags argument, it defaults to JKParseOptionStrict
 
@@ -169,6 +181,13 @@ typedef struct JKParseState JKParseState; // Opaque internal, private type.
 - (id)mutableObjectWithData:(NSData *)jsonData;
 - (id)mutableObjectWithData:(NSData *)jsonData error:(NSError **)error;
 
+// Methods that return a read-only, arena allocated JKDocument.  The caller must free the result with JKDocumentRelease().
+// Strings that contain no \ escapes are not copied, they point directly in to the JSON bytes.  The bytes passed to
+// documentWithUTF8String:length:error: MUST remain valid until the document is released.  documentWithData:error: retains jsonData.
+- (JKDocument *)documentWithUTF8String:(const unsigned char *)string length:(NSUInteger)length error:(NSError **)error;
+// The NSData MUST be UTF8 encoded JSON.
+- (JKDocument *)documentWithData:(NSData *)jsonData error:(NSError **)error;
+
 @end
 
 ////////////
@@ -192,8 +211,70 @@ typedef struct JKParseState JKParseState; // Opaque internal, private type.
 - (id)mutableObjectFromJSONData;
 - (id)mutableObjectFromJSONDataWithParseOptions:(JKParseOptionFlags)parseOptionFlags;
 - (id)mutableObjectFromJSONDataWithParseOptions:(JKParseOptionFlags)parseOptionFlags error:(NSError **)error;
+// Returns a JKDocument that retains the receiver.  The caller must free the result with JKDocumentRelease().
+- (JKDocument *)JSONDocumentWithParseOptions:(JKParseOptionFlags)parseOptionFlags error:(NSError **)error;
 @end
 
+////////////
+#pragma mark Read-only document methods
+////////////
+
+/*
+  A JKDocument is an alternative decode target for JSON that is only going to be read.  Instead of creating an Objective-C object
+  for every value, the parser appends a small, tagged value to a single contiguous array.  Values are referred to by their index
+  (a JKDocumentValueRef) in that array, and are laid out in document order, with the children of an array or dictionary immediately
+  following it.  The children of a dictionary alternate key, value, key, value...
+ 
+  Foundation objects are only created, on demand, for the values that are passed to JKDocumentValueGetObject().  They are owned by
+  the document and remain valid until JKDocumentRelease(), which frees the entire tree and everything created from it in one go.
+ 
+  A JKDocument is not thread safe.
+ */
+
+enum {
+  JKDocumentValueTypeInvalid          = 0,
+  JKDocumentValueTypeNull             = 1,
+  JKDocumentValueTypeFalse            = 2,
+  JKDocumentValueTypeTrue             = 3,
+  JKDocumentValueTypeString           = 4,
+  JKDocumentValueTypeLongLong         = 5,
+  JKDocumentValueTypeUnsignedLongLong = 6,
+  JKDocumentValueTypeDouble           = 7,
+  JKDocumentValueTypeArray            = 8,
+  JKDocumentValueTypeDictionary       = 9,
+};
+typedef JKFlags JKDocumentValueType;
+
+typedef size_t JKDocumentValueRef;
+#define JKDocumentValueNotFound ((JKDocumentValueRef)SIZE_MAX)
+
+void                JKDocumentRelease(JKDocument *document);
+size_t              JKDocumentGetValueCount(JKDocument *document);
+JKDocumentValueRef  JKDocumentGetRoot(JKDocument *document);
+
+JKDocumentValueType JKDocumentValueGetType(JKDocument *document, JKDocumentValueRef value);
+// The number of elements in an array, or the number of key / value pairs in a dictionary.  0 for everything else.
+size_t              JKDocumentValueGetCount(JKDocument *document, JKDocumentValueRef value);
+// The first element of an array, or the first key of a dictionary.  Use JKDocumentValueGetNextSibling() to walk the rest.
+JKDocumentValueRef  JKDocumentValueGetFirstChild(JKDocument *document, JKDocumentValueRef value);
+JKDocumentValueRef  JKDocumentValueGetNextSibling(JKDocument *document, JKDocumentValueRef parent, JKDocumentValueRef value);
+
+JKDocumentValueRef  JKDocumentArrayGetValueAtIndex(JKDocument *document, JKDocumentValueRef array, size_t index);
+JKDocumentValueRef  JKDocumentDictionaryGetValueForKey(JKDocument *document, JKDocumentValueRef dictionary, const char *key);
+JKDocumentValueRef  JKDocumentDictionaryGetValueForKeyBytes(JKDocument *document, JKDocumentValueRef dictionary, const unsigned char *keyBytes, size_t keyLength);
+
+// Returns the UTF8 bytes of a string value, which are NOT NULL terminated, or NULL if the value is not a string.
+const unsigned char *JKDocumentValueGetUTF8Bytes(JKDocument *document, JKDocumentValueRef value, size_t *length);
+// Numeric accessors convert between the number types like NSNumber does.  true is 1, everything else that is not a number is 0.
+long long           JKDocumentValueGetLongLongValue(JKDocument *document, JKDocumentValueRef value);
+unsigned long long  JKDocumentValueGetUnsignedLongLongValue(JKDocument *document, JKDocumentValueRef value);
+double              JKDocumentValueGetDoubleValue(JKDocument *document, JKDocumentValueRef value);
+BOOL                JKDocumentValueGetBoolValue(JKDocument *document, JKDocumentValueRef value);
+
+// Lazily bridges a value, and for arrays and dictionaries everything they contain, to immutable Foundation objects.
+// The returned object is owned by the document, -retain it if it needs to outlive JKDocumentRelease().
+id                  JKDocumentValueGetObject(JKDocument *document, JKDocumentValueRef value);
+
 ////////////
 #pragma mark Serializing methods
 ////////////
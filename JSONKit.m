@@ -105,7 +105,9 @@
 #include <sys/errno.h>
 #include <math.h>
 #include <limits.h>
+#include <unistd.h>
 #include <objc/runtime.h>
+#include <libkern/OSAtomic.h>
 
 #import "JSONKit.h"
 
@@ -124,6 +126,10 @@
 #import <Foundation/NSNull.h>
 #import <Foundation/NSObjCRuntime.h>
 
+#ifdef __BLOCKS__
+#include <dispatch/dispatch.h>
+#endif
+
 #ifndef __has_feature
 #define __has_feature(x) 0
 #endif
@@ -189,6 +195,16 @@
 
 #define JK_ENCODE_CACHE_SLOTS  (1024UL)
 
+// JK_SMALL_NUMBERS is the number of immortal NSNumbers, for the integers 0 .. JK_SMALL_NUMBERS - 1, that are shared by all decoders.
+#define JK_SMALL_NUMBERS       (1024UL)
+// JK_FAST_INTEGER_DIGITS is the maximum number of digits handled by the integer fast path.  10^18 - 1 fits in both a long long and an unsigned long long.
+#define JK_FAST_INTEGER_DIGITS (18L)
+
+// JKSerializeOptionParallel: top level collections with at least JK_PARALLEL_ENCODE_MIN_COUNT items are split in to chunks of at least
+// JK_PARALLEL_ENCODE_MIN_CHUNK items.  JK_PARALLEL_ENCODE_MIN_COUNT must be > 1020 so that the serial encoder enumerates dictionaries in the same order.
+#define JK_PARALLEL_ENCODE_MIN_COUNT (1024UL * 4UL)
+#define JK_PARALLEL_ENCODE_MIN_CHUNK (512UL)
+
 
 #if       defined (__GNUC__) && (__GNUC__ >= 4)
 #define JK_ATTRIBUTES(attr, ...)        __attribute__((attr, ##__VA_ARGS__))
@@ -286,6 +302,12 @@ enum {
 };
 typedef JKFlags JKManagedBufferFlags;
 
+enum {
+  JKDocumentSlotStringInSource  = 0,
+  JKDocumentSlotStringInArena   = (1 << 0),
+};
+typedef uint32_t JKDocumentSlotFlags;
+
 enum {
   JKObjectStackOnStack        = 1,
   JKObjectStackOnHeap         = 2,
@@ -352,6 +374,7 @@ typedef struct JKEncodeCache     JKEncodeCache;
 typedef struct JKEncodeState     JKEncodeState;
 typedef struct JKObjCImpCache    JKObjCImpCache;
 typedef struct JKHashTableEntry  JKHashTableEntry;
+typedef struct JKDocumentSlot    JKDocumentSlot;
 
 typedef id (*NSNumberAllocImp)(id receiver, SEL selector);
 typedef id (*NSNumberInitWithUnsignedLongLongImp)(id receiver, SEL selector, unsigned long long value);
@@ -446,11 +469,38 @@ struct JKParseState {
   JKObjectStack       objectStack;
   JKTokenCache        cache;
   JKObjCImpCache      objCImpCache;
+  CFAllocatorRef      noCopyDeallocator;
   NSError            *error;
   int                 errorIsPrev;
   BOOL                mutableCollections;
 };
 
+// A JKDocumentSlot is one tagged value in a JKDocument.  Strings are (offset, length) slices in to either the source
+// JSON bytes or, if they contained \ escapes, the documents string arena.  Arrays and dictionaries record the index
+// one past their last descendant in `end`, which makes skipping over an entire subtree O(1).
+struct JKDocumentSlot {
+  uint32_t            type;
+  JKDocumentSlotFlags flags;
+  union {
+    struct { size_t offset, length; } string;
+    struct { size_t count,  end;    } container;
+    long long          longLongValue;
+    unsigned long long unsignedLongLongValue;
+    double             doubleValue;
+  } u;
+};
+
+struct JKDocument {
+  JKDocumentSlot      *slots;
+  size_t               count, capacity;
+  JKManagedBuffer      arena;
+  size_t               arenaIndex;
+  const unsigned char *sourceBytes;
+  size_t               sourceLength;
+  id                   sourceData;
+  void               **bridgedObjects;
+};
+
 struct JKFastClassLookup {
   void *stringClass;
   void *numberClass;
@@ -579,6 +629,8 @@ static int  jk_objectStack_resize(JKObjectStack *objectStack, size_t newCount);
 static void   jk_error(JKParseState *parseState, NSString *format, ...);
 static int    jk_parse_string(JKParseState *parseState);
 static int    jk_parse_number(JKParseState *parseState);
+static int    jk_parse_double_fast(const unsigned char *numberPtr, size_t length, double *doubleValue);
+JK_STATIC_INLINE void *jk_smallNumber(unsigned long long value);
 static size_t jk_parse_is_newline(JKParseState *parseState, const unsigned char *atCharacterPtr);
 JK_STATIC_INLINE int jk_parse_skip_newline(JKParseState *parseState);
 JK_STATIC_INLINE void jk_parse_skip_whitespace(JKParseState *parseState);
@@ -592,6 +644,11 @@ static void  *jk_cachedObjects(JKParseState *parseState);
 JK_STATIC_INLINE void jk_cache_age(JKParseState *parseState);
 JK_STATIC_INLINE void jk_set_parsed_token(JKParseState *parseState, const unsigned char *ptr, size_t length, JKTokenType type, size_t advanceBy);
 
+static int    jk_document_add_token(JKParseState *parseState, JKDocument *document);
+static int    jk_document_parse_array(JKParseState *parseState, JKDocument *document, size_t arraySlotIndex);
+static int    jk_document_parse_dictionary(JKParseState *parseState, JKDocument *document, size_t dictionarySlotIndex);
+static void  *jk_document_bridge(JKDocument *document, JKDocumentValueRef value);
+
 
 static void jk_encode_error(JKEncodeState *encodeState, NSString *format, ...);
 static int jk_encode_printf(JKEncodeState *encodeState, JKEncodeCache *cacheSlot, size_t startingAtIndex, id object, const char *format, ...);
@@ -603,6 +660,10 @@ static int jk_encode_writen(JKEncodeState *encodeState, JKEncodeCache *cacheSlot
 JK_STATIC_INLINE JKHash jk_encode_object_hash(void *objectPtr);
 JK_STATIC_INLINE void jk_encode_updateCache(JKEncodeState *encodeState, JKEncodeCache *cacheSlot, size_t startingAtIndex, id object);
 static int jk_encode_add_atom_to_buffer(JKEncodeState *encodeState, void *objectPtr);
+#ifdef __BLOCKS__
+static size_t jk_encode_parallel_chunk_count(JKEncodeState *encodeState, id object);
+static int jk_encode_add_collection_in_parallel(JKEncodeState *encodeState, id object, size_t chunkCount);
+#endif
 
 #define jk_encode_write1(es, dc, f)  (JK_EXPECT_F(_jk_encode_prettyPrint) ? jk_encode_write1slow(es, dc, f) : jk_encode_write1fast(es, dc, f))
 
@@ -1627,6 +1688,66 @@ finishedParsing:
   return(JK_EXPECT_T(stringState == JSONStringStateFinished) ? 0 : 1);
 }
 
+// Clinger's fast path.  When the decimal significand fits in 53 bits and the power of ten is exactly representable as a double, a single
+// IEEE multiply or divide is correctly rounded, and gives exactly the same result as strtod().  Returns 0 for the hard cases, which are
+// left to strtod().
+static int jk_parse_double_fast(const unsigned char *numberPtr, size_t length, double *doubleValue) {
+  static const double powersOfTen[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  const unsigned char *atNumberCharacter = numberPtr, *endOfNumber = numberPtr + length;
+  unsigned long long   significand       = 0ULL;
+  long                 significantDigits = 0L, exponent = 0L, explicitExponent = 0L, exponentDigits = 0L;
+  int                  isNegative        = 0, isNegativeExponent = 0;
+
+  NSCParameterAssert((numberPtr != NULL) && (doubleValue != NULL));
+
+  if((atNumberCharacter < endOfNumber) && (*atNumberCharacter == '-')) { isNegative = 1; atNumberCharacter++; }
+  for(; (atNumberCharacter < endOfNumber) && ((unsigned char)(*atNumberCharacter - '0') < 10U); atNumberCharacter++) {
+    if((significand != 0ULL) || (*atNumberCharacter != '0')) { if(JK_EXPECT_F(++significantDigits > 19L)) { return(0); } significand = (significand * 10ULL) + (*atNumberCharacter - '0'); }
+  }
+  if((atNumberCharacter < endOfNumber) && (*atNumberCharacter == '.')) {
+    for(atNumberCharacter++; (atNumberCharacter < endOfNumber) && ((unsigned char)(*atNumberCharacter - '0') < 10U); atNumberCharacter++) {
+      if((significand != 0ULL) || (*atNumberCharacter != '0')) { if(JK_EXPECT_F(++significantDigits > 19L)) { return(0); } significand = (significand * 10ULL) + (*atNumberCharacter - '0'); }
+      exponent--;
+    }
+  }
+  if((atNumberCharacter < endOfNumber) && ((*atNumberCharacter | 0x20) == 'e')) {
+    atNumberCharacter++;
+    if((atNumberCharacter < endOfNumber) && ((*atNumberCharacter == '+') || (*atNumberCharacter == '-'))) { isNegativeExponent = (*atNumberCharacter == '-'); atNumberCharacter++; }
+    for(; (atNumberCharacter < endOfNumber) && ((unsigned char)(*atNumberCharacter - '0') < 10U); atNumberCharacter++) { if(JK_EXPECT_F(++exponentDigits > 4L)) { return(0); } explicitExponent = (explicitExponent * 10L) + (*atNumberCharacter - '0'); }
+    exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+  }
+  if(JK_EXPECT_F(atNumberCharacter != endOfNumber)) { return(0); }
+
+  double value = 0.0;
+       if(significand == 0ULL)                                 { value = 0.0; }
+  else if(JK_EXPECT_F(significand > (1ULL << 53)))             { return(0); }
+  else if(exponent == 0L)                                      { value = (double)significand; }
+  else if((exponent > 0L)  && (exponent <= 22L))               { value = (double)significand * powersOfTen[exponent];  }
+  else if((exponent < 0L)  && (exponent >= -22L))              { value = (double)significand / powersOfTen[-exponent]; }
+  else                                                         { return(0); }
+
+  *doubleValue = isNegative ? -value : value;
+  return(1);
+}
+
+// Integers 0 .. JK_SMALL_NUMBERS - 1 (widths, heights, counts, ...) skip the object cache and return a shared, immortal, NSNumber.
+// They are created on first use.  The loser of a creation race releases its copy.
+static CFNumberRef jk_smallNumbers[JK_SMALL_NUMBERS];
+
+JK_STATIC_INLINE void *jk_smallNumber(unsigned long long value) {
+  NSCParameterAssert(value < JK_SMALL_NUMBERS);
+  CFNumberRef number = jk_smallNumbers[value];
+  if(JK_EXPECT_F(number == NULL)) {
+    long long   longLongValue = (long long)value;
+    CFNumberRef newNumber     = CFNumberCreate(NULL, kCFNumberLongLongType, &longLongValue);
+    if(JK_EXPECT_F(newNumber == NULL)) { return(NULL); }
+    if(OSAtomicCompareAndSwapPtrBarrier(NULL, (void *)newNumber, (void * volatile *)&jk_smallNumbers[value])) { number = newNumber; }
+    else { CFRelease(newNumber); number = jk_smallNumbers[value]; }
+  }
+  return((void *)CFRetain(number));
+}
+
 static int jk_parse_number(JKParseState *parseState) {
   NSCParameterAssert((parseState != NULL) && (JK_AT_STRING_PTR(parseState) <= JK_END_STRING_PTR(parseState)));
   const unsigned char *numberStart       = JK_AT_STRING_PTR(parseState);
@@ -1634,6 +1755,43 @@ static int jk_parse_number(JKParseState *parseState) {
   const unsigned char *atNumberCharacter = NULL;
   int                  numberState       = JSONNumberStateWholeNumberStart, isFloatingPoint = 0, isNegative = 0, backup = 0;
   size_t               startingIndex     = parseState->atIndex;
+
+  // Fast path for the common case: an integer with no leading zero and at most JK_FAST_INTEGER_DIGITS digits, followed by a character that
+  // can not be part of a number.  Everything else, including "-0", numbers that run to the end of the buffer, and errors, takes the slow path.
+  {
+    const unsigned char *digitStart  = numberStart + (JK_EXPECT_T(numberStart < endOfBuffer) && (*numberStart == '-'));
+    unsigned long long   accumulator = 0ULL;
+
+    for(atNumberCharacter = digitStart; JK_EXPECT_T(atNumberCharacter < endOfBuffer) && ((unsigned char)(*atNumberCharacter - '0') < 10U) && JK_EXPECT_T((atNumberCharacter - digitStart) < JK_FAST_INTEGER_DIGITS); atNumberCharacter++) { accumulator = (accumulator * 10ULL) + (*atNumberCharacter - '0'); }
+
+    if(JK_EXPECT_T(atNumberCharacter > digitStart) && JK_EXPECT_T(atNumberCharacter < endOfBuffer) && JK_EXPECT_T((*digitStart != '0') || ((atNumberCharacter == (digitStart + 1)) && (digitStart == numberStart)))) {
+      unsigned long terminatingChar = (unsigned long)(*atNumberCharacter);
+      if(JK_EXPECT_T((terminatingChar - '0') >= 10UL) && JK_EXPECT_T(terminatingChar != '.') && JK_EXPECT_T((terminatingChar | 0x20UL) != 'e')) {
+        parseState->token.tokenPtrRange.ptr    = numberStart;
+        parseState->token.tokenPtrRange.length = atNumberCharacter - numberStart;
+        parseState->atIndex                    = startingIndex + parseState->token.tokenPtrRange.length;
+
+        if(digitStart != numberStart) {
+          parseState->token.value.number.longLongValue = -(long long)accumulator;
+          parseState->token.value.type                 = JKValueTypeLongLong;
+          parseState->token.value.ptrRange.ptr         = (const unsigned char *)&parseState->token.value.number.longLongValue;
+          parseState->token.value.ptrRange.length      = sizeof(long long);
+          parseState->token.value.hash                 = (JK_HASH_INIT + parseState->token.value.type) + (JKHash)parseState->token.value.number.longLongValue;
+        } else {
+          parseState->token.value.number.unsignedLongLongValue = accumulator;
+          parseState->token.value.type                         = JKValueTypeUnsignedLongLong;
+          parseState->token.value.ptrRange.ptr                 = (const unsigned char *)&parseState->token.value.number.unsignedLongLongValue;
+          parseState->token.value.ptrRange.length              = sizeof(unsigned long long);
+          parseState->token.value.hash                         = (JK_HASH_INIT + parseState->token.value.type) + (JKHash)parseState->token.value.number.unsignedLongLongValue;
+          if(JK_EXPECT_T(accumulator < JK_SMALL_NUMBERS)) { return(0); } // The hash is only used by the object cache, which jk_smallNumber() bypasses.
+        }
+
+        size_t hashIndex = 0UL;
+        for(hashIndex = 0UL; hashIndex < parseState->token.value.ptrRange.length; hashIndex++) { parseState->token.value.hash = calculateHash(parseState->token.value.hash, parseState->token.value.ptrRange.ptr[hashIndex]); }
+        return(0);
+      }
+    }
+  }
   
   for(atNumberCharacter = numberStart; (JK_EXPECT_T(atNumberCharacter < endOfBuffer)) && (JK_EXPECT_T(!(JK_EXPECT_F(numberState == JSONNumberStateFinished) || JK_EXPECT_F(numberState == JSONNumberStateError)))); atNumberCharacter++) {
     unsigned long currentChar = (unsigned long)(*atNumberCharacter), lowerCaseCC = currentChar | 0x20UL;
@@ -1674,7 +1832,8 @@ static int jk_parse_number(JKParseState *parseState) {
     if(JK_EXPECT_F(parseState->token.tokenPtrRange.length == 2UL) && JK_EXPECT_F(numberTempBuf[1] == '0') && JK_EXPECT_F(isNegative)) { isFloatingPoint = 1; }
 
     if(isFloatingPoint) {
-      parseState->token.value.number.doubleValue = strtod((const char *)numberTempBuf, (char **)&endOfNumber); // strtod is documented to return U+2261 (identical to) 0.0 on an underflow error (along with setting errno to ERANGE).
+      if(JK_EXPECT_T(jk_parse_double_fast(numberTempBuf, parseState->token.tokenPtrRange.length, &parseState->token.value.number.doubleValue))) { endOfNumber = &numberTempBuf[parseState->token.tokenPtrRange.length]; }
+      else { parseState->token.value.number.doubleValue = strtod((const char *)numberTempBuf, (char **)&endOfNumber); } // strtod is documented to return U+2261 (identical to) 0.0 on an underflow error (along with setting errno to ERANGE).
       parseState->token.value.type               = JKValueTypeDouble;
       parseState->token.value.ptrRange.ptr       = (const unsigned char *)&parseState->token.value.number.doubleValue;
       parseState->token.value.ptrRange.length    = sizeof(double);
@@ -2019,7 +2178,14 @@ static void *jk_cachedObjects(JKParseState *parseState) {
   }
   
   switch(parseState->token.value.type) {
-    case JKValueTypeString:           parsedAtom = (void *)CFStringCreateWithBytes(NULL, parseState->token.value.ptrRange.ptr, parseState->token.value.ptrRange.length, kCFStringEncodingUTF8, 0); break;
+    case JKValueTypeString:
+      // Only strings that were not unescaped in to the token buffer point in to the source bytes and can be used without copying.
+      if((parseState->noCopyDeallocator != NULL) && JK_EXPECT_T(parseState->token.value.ptrRange.ptr >= parseState->stringBuffer.bytes.ptr) && JK_EXPECT_T((parseState->token.value.ptrRange.ptr + parseState->token.value.ptrRange.length) <= JK_END_STRING_PTR(parseState))) {
+        parsedAtom = (void *)CFStringCreateWithBytesNoCopy(NULL, parseState->token.value.ptrRange.ptr, parseState->token.value.ptrRange.length, kCFStringEncodingUTF8, 0, parseState->noCopyDeallocator);
+      } else {
+        parsedAtom = (void *)CFStringCreateWithBytes(NULL, parseState->token.value.ptrRange.ptr, parseState->token.value.ptrRange.length, kCFStringEncodingUTF8, 0);
+      }
+      break;
     case JKValueTypeLongLong:         parsedAtom = (void *)CFNumberCreate(NULL, kCFNumberLongLongType, &parseState->token.value.number.longLongValue);                                             break;
     case JKValueTypeUnsignedLongLong:
       if(parseState->token.value.number.unsignedLongLongValue <= LLONG_MAX) { parsedAtom = (void *)CFNumberCreate(NULL, kCFNumberLongLongType, &parseState->token.value.number.unsignedLongLongValue); }
@@ -2060,7 +2226,10 @@ static void *jk_object_for_token(JKParseState *parseState) {
   parseState->token.value.cacheItem = NULL;
   switch(parseState->token.type) {
     case JKTokenTypeString:      parsedAtom = jk_cachedObjects(parseState);    break;
-    case JKTokenTypeNumber:      parsedAtom = jk_cachedObjects(parseState);    break;
+    case JKTokenTypeNumber:
+      if(JK_EXPECT_T(parseState->token.value.type == JKValueTypeUnsignedLongLong) && JK_EXPECT_T(parseState->token.value.number.unsignedLongLongValue < JK_SMALL_NUMBERS)) { parsedAtom = jk_smallNumber(parseState->token.value.number.unsignedLongLongValue); }
+      else { parsedAtom = jk_cachedObjects(parseState); }
+      break;
     case JKTokenTypeObjectBegin: parsedAtom = jk_parse_dictionary(parseState); break;
     case JKTokenTypeArrayBegin:  parsedAtom = jk_parse_array(parseState);      break;
     case JKTokenTypeTrue:        parsedAtom = (void *)kCFBooleanTrue;          break;
@@ -2072,6 +2241,278 @@ static void *jk_object_for_token(JKParseState *parseState) {
   return(parsedAtom);
 }
 
+////////////
+#pragma mark -
+#pragma mark Read-only document parsing
+
+// The document parser uses the same tokenizer as the object parser, but instead of creating an object for every token it
+// appends a JKDocumentSlot to document->slots.  Slots are referred to by index since the array may be realloc'd as it grows.
+
+JK_STATIC_INLINE size_t jk_document_new_slot(JKParseState *parseState, JKDocument *document) {
+  if(JK_EXPECT_F(document->count == document->capacity)) {
+    size_t          newCapacity = (document->capacity < 64UL) ? 64UL : (document->capacity * 2UL);
+    JKDocumentSlot *newSlots    = NULL;
+    if(JK_EXPECT_F((newSlots = (JKDocumentSlot *)realloc(document->slots, newCapacity * sizeof(JKDocumentSlot))) == NULL)) { jk_error(parseState, @"Internal error: Unable to resize document slots. %@ line #%ld", [NSString stringWithUTF8String:__FILE__], (long)__LINE__); return(JKDocumentValueNotFound); }
+    document->slots    = newSlots;
+    document->capacity = newCapacity;
+  }
+  return(document->count++);
+}
+
+static int jk_document_add_token(JKParseState *parseState, JKDocument *document) {
+  size_t slotIndex = jk_document_new_slot(parseState, document);
+  if(JK_EXPECT_F(slotIndex == JKDocumentValueNotFound)) { return(1); }
+
+  JKDocumentSlot *slot = &document->slots[slotIndex];
+  slot->flags = 0U;
+
+  switch(parseState->token.type) {
+    case JKTokenTypeString:
+      {
+        const unsigned char *stringPtr    = parseState->token.value.ptrRange.ptr;
+        size_t               stringLength = parseState->token.value.ptrRange.length;
+
+        slot->type = JKDocumentValueTypeString;
+        if(JK_EXPECT_T(stringPtr >= parseState->stringBuffer.bytes.ptr) && JK_EXPECT_T((stringPtr + stringLength) <= JK_END_STRING_PTR(parseState))) {
+          slot->flags           = JKDocumentSlotStringInSource;
+          slot->u.string.offset = (size_t)(stringPtr - parseState->stringBuffer.bytes.ptr);
+          slot->u.string.length = stringLength;
+        } else { // The string had \ escapes and was decoded in to the token buffer, so it has to be copied in to the arena.
+          if(JK_EXPECT_F((document->arenaIndex + stringLength) > document->arena.bytes.length) && JK_EXPECT_F(jk_managedBuffer_resize(&document->arena, document->arenaIndex + stringLength) == NULL)) { jk_error(parseState, @"Internal error: Unable to resize document string arena. %@ line #%ld", [NSString stringWithUTF8String:__FILE__], (long)__LINE__); return(1); }
+          memcpy(document->arena.bytes.ptr + document->arenaIndex, stringPtr, stringLength);
+          slot->flags            = JKDocumentSlotStringInArena;
+          slot->u.string.offset  = document->arenaIndex;
+          slot->u.string.length  = stringLength;
+          document->arenaIndex  += stringLength;
+        }
+      }
+      break;
+
+    case JKTokenTypeNumber:
+      switch(parseState->token.value.type) {
+        case JKValueTypeLongLong:         slot->type = JKDocumentValueTypeLongLong;         slot->u.longLongValue         = parseState->token.value.number.longLongValue;         break;
+        case JKValueTypeUnsignedLongLong: slot->type = JKDocumentValueTypeUnsignedLongLong; slot->u.unsignedLongLongValue = parseState->token.value.number.unsignedLongLongValue; break;
+        case JKValueTypeDouble:           slot->type = JKDocumentValueTypeDouble;           slot->u.doubleValue           = parseState->token.value.number.doubleValue;           break;
+        default: jk_error(parseState, @"Internal error: Unknown token value type. %@ line #%ld", [NSString stringWithUTF8String:__FILE__], (long)__LINE__); return(1); break;
+      }
+      break;
+
+    case JKTokenTypeTrue:        slot->type = JKDocumentValueTypeTrue;  break;
+    case JKTokenTypeFalse:       slot->type = JKDocumentValueTypeFalse; break;
+    case JKTokenTypeNull:        slot->type = JKDocumentValueTypeNull;  break;
+    case JKTokenTypeArrayBegin:  slot->type = JKDocumentValueTypeArray;      return(jk_document_parse_array(parseState, document, slotIndex));      break;
+    case JKTokenTypeObjectBegin: slot->type = JKDocumentValueTypeDictionary; return(jk_document_parse_dictionary(parseState, document, slotIndex)); break;
+    default: jk_error(parseState, @"Internal error: Unknown token type. %@ line #%ld", [NSString stringWithUTF8String:__FILE__], (long)__LINE__); return(1); break;
+  }
+
+  return(0);
+}
+
+static int jk_document_parse_array(JKParseState *parseState, JKDocument *document, size_t arraySlotIndex) {
+  int    arrayState = JKParseAcceptValueOrEnd;
+  size_t count      = 0UL;
+
+  while(JK_EXPECT_T(parseState->atIndex < parseState->stringBuffer.bytes.length)) {
+    if(JK_EXPECT_F(jk_parse_next_token(parseState))) { return(1); }
+
+    switch(parseState->token.type) {
+      case JKTokenTypeNumber:
+      case JKTokenTypeString:
+      case JKTokenTypeTrue:
+      case JKTokenTypeFalse:
+      case JKTokenTypeNull:
+      case JKTokenTypeArrayBegin:
+      case JKTokenTypeObjectBegin:
+        if(JK_EXPECT_F((arrayState & JKParseAcceptValue) == 0)) { parseState->errorIsPrev = 1; jk_error(parseState, @"Unexpected value."); return(1); }
+        if(JK_EXPECT_F(jk_document_add_token(parseState, document))) { return(1); }
+        count++;
+        arrayState = JKParseAcceptCommaOrEnd;
+        break;
+      case JKTokenTypeArrayEnd:
+        if(JK_EXPECT_F((arrayState & JKParseAcceptEnd) == 0)) { parseState->errorIsPrev = 1; jk_error(parseState, @"Unexpected ']'."); return(1); }
+        document->slots[arraySlotIndex].u.container.count = count;
+        document->slots[arraySlotIndex].u.container.end   = document->count;
+        return(0);
+        break;
+      case JKTokenTypeComma:
+        if(JK_EXPECT_F((arrayState & JKParseAcceptComma) == 0)) { parseState->errorIsPrev = 1; jk_error(parseState, @"Unexpected ','."); return(1); }
+        arrayState = JKParseAcceptValue;
+        break;
+      default: parseState->errorIsPrev = 1; jk_error_parse_accept_or3(parseState, arrayState, @"a value", @"a comma", @"a ']'"); return(1); break;
+    }
+  }
+
+  jk_error(parseState, @"Reached the end of the buffer.");
+  return(1);
+}
+
+static int jk_document_parse_dictionary(JKParseState *parseState, JKDocument *document, size_t dictionarySlotIndex) {
+  int    dictState = JKParseAcceptValueOrEnd;
+  size_t count     = 0UL;
+
+  while(JK_EXPECT_T(parseState->atIndex < parseState->stringBuffer.bytes.length)) {
+    if(JK_EXPECT_F(jk_parse_next_token(parseState))) { return(1); }
+
+    switch(parseState->token.type) {
+      case JKTokenTypeString:
+        if(JK_EXPECT_F((dictState & JKParseAcceptValue) == 0)) { parseState->errorIsPrev = 1; jk_error(parseState, @"Unexpected string."); return(1); }
+        if(JK_EXPECT_F(jk_document_add_token(parseState, document))) { return(1); }
+        break;
+      case JKTokenTypeObjectEnd:
+        if(JK_EXPECT_F((dictState & JKParseAcceptEnd) == 0)) { parseState->errorIsPrev = 1; jk_error(parseState, @"Unexpected '}'."); return(1); }
+        document->slots[dictionarySlotIndex].u.container.count = count;
+        document->slots[dictionarySlotIndex].u.container.end   = document->count;
+        return(0);
+        break;
+      case JKTokenTypeComma:
+        if(JK_EXPECT_F((dictState & JKParseAcceptComma) == 0)) { parseState->errorIsPrev = 1; jk_error(parseState, @"Unexpected ','."); return(1); }
+        dictState = JKParseAcceptValue;
+        continue;
+        break;
+      default: parseState->errorIsPrev = 1; jk_error_parse_accept_or3(parseState, dictState, @"a \"STRING\"", @"a comma", @"a '}'"); return(1); break;
+    }
+
+    if(JK_EXPECT_F(jk_parse_next_token(parseState))) { return(1); }
+    if(JK_EXPECT_F(parseState->token.type != JKTokenTypeSeparator)) { parseState->errorIsPrev = 1; jk_error(parseState, @"Expected ':'."); return(1); }
+
+    if(JK_EXPECT_F(jk_parse_next_token(parseState))) { return(1); }
+    switch(parseState->token.type) {
+      case JKTokenTypeNumber:
+      case JKTokenTypeString:
+      case JKTokenTypeTrue:
+      case JKTokenTypeFalse:
+      case JKTokenTypeNull:
+      case JKTokenTypeArrayBegin:
+      case JKTokenTypeObjectBegin:
+        if(JK_EXPECT_F(jk_document_add_token(parseState, document))) { return(1); }
+        count++;
+        dictState = JKParseAcceptCommaOrEnd;
+        break;
+      default: parseState->errorIsPrev = 1; jk_error_parse_accept_or3(parseState, dictState, @"a value", @"a comma", @"a '}'"); return(1); break;
+    }
+  }
+
+  jk_error(parseState, @"Reached the end of the buffer.");
+  return(1);
+}
+
+static JKDocument *json_parse_document(JKParseState *parseState, JKDocument *document) {
+  int parsedRoot = 0, stopParsing = 0;
+
+  while((JK_EXPECT_T(stopParsing == 0)) && (JK_EXPECT_T(parseState->atIndex < parseState->stringBuffer.bytes.length))) {
+    if((JK_EXPECT_T(stopParsing == 0)) && (JK_EXPECT_T((stopParsing = jk_parse_next_token(parseState)) == 0))) {
+      switch(parseState->token.type) {
+        case JKTokenTypeArrayBegin:
+        case JKTokenTypeObjectBegin: parsedRoot = (jk_document_add_token(parseState, document) == 0) ? 1 : 0; stopParsing = 1; break;
+        default:                     jk_error(parseState, @"Expected either '[' or '{'.");                     stopParsing = 1; break;
+      }
+    }
+  }
+
+  NSCParameterAssert(JK_AT_STRING_PTR(parseState) <= JK_END_STRING_PTR(parseState));
+
+  if((parsedRoot == 0) && (JK_AT_STRING_PTR(parseState) == JK_END_STRING_PTR(parseState))) { jk_error(parseState, @"Reached the end of the buffer."); }
+  if(parsedRoot == 0) { jk_error(parseState, @"Unable to parse JSON."); return(NULL); }
+
+  if(JK_AT_STRING_PTR(parseState) < JK_END_STRING_PTR(parseState)) {
+    jk_parse_skip_whitespace(parseState);
+    if(((parseState->parseOptionFlags & JKParseOptionPermitTextAfterValidJSON) == 0) && (JK_AT_STRING_PTR(parseState) < JK_END_STRING_PTR(parseState))) {
+      jk_error(parseState, @"A valid JSON object was parsed but there were additional non-white-space characters remaining.");
+      return(NULL);
+    }
+  }
+
+  return(document);
+}
+
+////////////
+#pragma mark -
+#pragma mark Read-only document bridging
+
+JK_STATIC_INLINE const unsigned char *jk_document_string_bytes(JKDocument *document, JKDocumentSlot *slot) {
+  return(((slot->flags & JKDocumentSlotStringInArena) ? document->arena.bytes.ptr : document->sourceBytes) + slot->u.string.offset);
+}
+
+JK_STATIC_INLINE JKDocumentValueRef jk_document_next_sibling(JKDocument *document, JKDocumentValueRef value) {
+  JKDocumentSlot *slot = &document->slots[value];
+  return(((slot->type == JKDocumentValueTypeArray) || (slot->type == JKDocumentValueTypeDictionary)) ? slot->u.container.end : (value + 1UL));
+}
+
+// Returns an object that the document holds a reference to, or NULL.  The caller must CFRetain() it if it is going to be stored in a collection.
+static void *jk_document_bridge(JKDocument *document, JKDocumentValueRef value) {
+  NSCParameterAssert((document != NULL) && (value < document->count));
+
+  if(JK_EXPECT_F(document->bridgedObjects == NULL)) { if((document->bridgedObjects = (void **)calloc(document->count, sizeof(void *))) == NULL) { return(NULL); } }
+  if(document->bridgedObjects[value] != NULL) { return(document->bridgedObjects[value]); }
+
+  JKDocumentSlot *slot         = &document->slots[value];
+  void           *bridgedAtom  = NULL;
+
+  switch(slot->type) {
+    case JKDocumentValueTypeNull:     bridgedAtom = (void *)CFRetain(kCFNull);         break;
+    case JKDocumentValueTypeFalse:    bridgedAtom = (void *)CFRetain(kCFBooleanFalse); break;
+    case JKDocumentValueTypeTrue:     bridgedAtom = (void *)CFRetain(kCFBooleanTrue);  break;
+    case JKDocumentValueTypeString:   bridgedAtom = (void *)CFStringCreateWithBytes(NULL, jk_document_string_bytes(document, slot), slot->u.string.length, kCFStringEncodingUTF8, 0); break;
+    case JKDocumentValueTypeLongLong: bridgedAtom = (void *)CFNumberCreate(NULL, kCFNumberLongLongType, &slot->u.longLongValue); break;
+    case JKDocumentValueTypeUnsignedLongLong:
+           if(slot->u.unsignedLongLongValue <  JK_SMALL_NUMBERS) { bridgedAtom = jk_smallNumber(slot->u.unsignedLongLongValue); }
+      else if(slot->u.unsignedLongLongValue <= LLONG_MAX)        { bridgedAtom = (void *)CFNumberCreate(NULL, kCFNumberLongLongType, &slot->u.unsignedLongLongValue); }
+      else { bridgedAtom = (void *)_jk_NSNumberInitWithUnsignedLongLongImp(_jk_NSNumberAllocImp(_jk_NSNumberClass, @selector(alloc)), @selector(initWithUnsignedLongLong:), slot->u.unsignedLongLongValue); }
+      break;
+    case JKDocumentValueTypeDouble:   bridgedAtom = (void *)CFNumberCreate(NULL, kCFNumberDoubleType, &slot->u.doubleValue); break;
+
+    case JKDocumentValueTypeArray:
+    case JKDocumentValueTypeDictionary:
+      {
+        BOOL                isDictionary = (slot->type == JKDocumentValueTypeDictionary) ? YES : NO;
+        size_t              count        = slot->u.container.count, end = slot->u.container.end, idx = 0UL;
+        void              **objects      = NULL, **keys = NULL;
+        NSUInteger         *keyHashes    = NULL;
+        JKDocumentValueRef  child        = value + 1UL;
+
+        if((objects = (void **)calloc(jk_max(count, 1UL), sizeof(void *))) == NULL) { goto containerExit; }
+        if(isDictionary) {
+          if((keys      = (void **)     calloc(jk_max(count, 1UL), sizeof(void *)))     == NULL) { goto containerExit; }
+          if((keyHashes = (NSUInteger *)calloc(jk_max(count, 1UL), sizeof(NSUInteger))) == NULL) { goto containerExit; }
+        }
+
+        for(idx = 0UL; (idx < count) && (child < end); idx++) {
+          void *object = NULL;
+          if(isDictionary) {
+            if((object = jk_document_bridge(document, child)) == NULL) { goto containerExit; }
+            keys[idx]      = (void *)CFRetain(object);
+            keyHashes[idx] = CFHash(object);
+            child          = jk_document_next_sibling(document, child);
+          }
+          if((object = jk_document_bridge(document, child)) == NULL) { goto containerExit; }
+          objects[idx] = (void *)CFRetain(object);
+          child        = jk_document_next_sibling(document, child);
+        }
+        NSCParameterAssert((idx == count) && (child == end));
+
+        // The collection takes ownership of the +1 retains on success.
+        if(isDictionary) { bridgedAtom = (void *)_JKDictionaryCreate((id *)keys, keyHashes, (id *)objects, count, NO); }
+        else             { bridgedAtom = (void *)_JKArrayCreate((id *)objects, count, NO);                            }
+        if(bridgedAtom != NULL) { count = 0UL; }
+
+      containerExit:
+        for(idx = 0UL; idx < count; idx++) {
+          if((objects != NULL) && (objects[idx] != NULL)) { CFRelease(objects[idx]); }
+          if((keys    != NULL) && (keys[idx]    != NULL)) { CFRelease(keys[idx]);    }
+        }
+        if(objects   != NULL) { free(objects);   objects   = NULL; }
+        if(keys      != NULL) { free(keys);      keys      = NULL; }
+        if(keyHashes != NULL) { free(keyHashes); keyHashes = NULL; }
+      }
+      break;
+
+    default: break;
+  }
+
+  document->bridgedObjects[value] = bridgedAtom;
+  return(bridgedAtom);
+}
+
 #pragma mark -
 @implementation JSONDecoder
 
@@ -2152,8 +2593,18 @@ static void _JSONDecoderCleanup(JSONDecoder *decoder) {
   }
 }
 
+// The bytes of JKParseOptionNoCopyStrings strings belong to the source NSData, so there is nothing to free.  The NSData is the
+// allocators info, which CF retains for as long as the allocator, and therefore any string using it, is alive.
+static void jk_noCopyDeallocate(void *ptr JK_UNUSED_ARG, void *info JK_UNUSED_ARG) {
+}
+
+static CFAllocatorRef jk_noCopyDeallocatorCreate(id sourceData) {
+  CFAllocatorContext allocatorContext = { 0L, (void *)sourceData, CFRetain, CFRelease, NULL, NULL, NULL, jk_noCopyDeallocate, NULL };
+  return(CFAllocatorCreate(NULL, &allocatorContext));
+}
+
 // This needs to be completely rewritten.
-static id _JKParseUTF8String(JKParseState *parseState, BOOL mutableCollections, const unsigned char *string, size_t length, NSError **error) {
+static id _JKParseUTF8String(JKParseState *parseState, BOOL mutableCollections, const unsigned char *string, size_t length, id sourceData, NSError **error) {
   NSCParameterAssert((parseState != NULL) && (string != NULL) && (parseState->cache.prng_lfsr != 0U));
   parseState->stringBuffer.bytes.ptr    = string;
   parseState->stringBuffer.bytes.length = length;
@@ -2166,6 +2617,7 @@ static id _JKParseUTF8String(JKParseState *parseState, BOOL mutableCollections,
   parseState->error                     = NULL;
   parseState->errorIsPrev               = 0;
   parseState->mutableCollections        = (mutableCollections == NO) ? NO : YES;
+  parseState->noCopyDeallocator         = ((sourceData != NULL) && (parseState->parseOptionFlags & JKParseOptionNoCopyStrings)) ? jk_noCopyDeallocatorCreate(sourceData) : NULL;
   
   unsigned char stackTokenBuffer[JK_TOKENBUFFER_SIZE] JK_ALIGNED(64);
   jk_managedBuffer_setToStackBuffer(&parseState->token.tokenBuffer, stackTokenBuffer, sizeof(stackTokenBuffer));
@@ -2193,10 +2645,61 @@ static id _JKParseUTF8String(JKParseState *parseState, BOOL mutableCollections,
   parseState->error                     = NULL;
   parseState->errorIsPrev               = 0;
   parseState->mutableCollections        = NO;
+  if(parseState->noCopyDeallocator != NULL) { CFRelease(parseState->noCopyDeallocator); parseState->noCopyDeallocator = NULL; }
   
   return(parsedJSON);
 }
 
+static JKDocument *_JKParseUTF8StringToDocument(JKParseState *parseState, const unsigned char *string, size_t length, id sourceData, NSError **error) {
+  NSCParameterAssert((parseState != NULL) && (string != NULL) && (parseState->cache.prng_lfsr != 0U));
+  JKDocument *document = NULL;
+
+  if((document = (JKDocument *)calloc(1UL, sizeof(JKDocument))) == NULL) { [NSException raise:NSMallocException format:@"Unable to allocate document structure."]; return(NULL); }
+
+  // JSON averages somewhere around one value per 8 to 16 bytes, so start there to avoid most of the reallocs.
+  document->capacity                      = jk_max(64UL, length / 12UL);
+  document->sourceBytes                   = string;
+  document->sourceLength                  = length;
+  document->sourceData                    = [sourceData retain];
+  document->arena.flags                   = (JKManagedBufferOnHeap | JKManagedBufferMustFree); // Starts out empty, reallocf(NULL) on first use.
+  document->arena.roundSizeUpToMultipleOf = 4096UL;
+  if((document->slots = (JKDocumentSlot *)malloc(document->capacity * sizeof(JKDocumentSlot))) == NULL) { JKDocumentRelease(document); [NSException raise:NSMallocException format:@"Unable to allocate document slots."]; return(NULL); }
+
+  parseState->stringBuffer.bytes.ptr    = string;
+  parseState->stringBuffer.bytes.length = length;
+  parseState->atIndex                   = 0UL;
+  parseState->lineNumber                = 1UL;
+  parseState->lineStartIndex            = 0UL;
+  parseState->prev_atIndex              = 0UL;
+  parseState->prev_lineNumber           = 1UL;
+  parseState->prev_lineStartIndex       = 0UL;
+  parseState->error                     = NULL;
+  parseState->errorIsPrev               = 0;
+  parseState->mutableCollections        = NO;
+
+  unsigned char stackTokenBuffer[JK_TOKENBUFFER_SIZE] JK_ALIGNED(64);
+  jk_managedBuffer_setToStackBuffer(&parseState->token.tokenBuffer, stackTokenBuffer, sizeof(stackTokenBuffer));
+
+  if(json_parse_document(parseState, document) == NULL) { JKDocumentRelease(document); document = NULL; }
+
+  if((error != NULL) && (parseState->error != NULL)) { *error = parseState->error; }
+
+  jk_managedBuffer_release(&parseState->token.tokenBuffer);
+
+  parseState->stringBuffer.bytes.ptr    = NULL;
+  parseState->stringBuffer.bytes.length = 0UL;
+  parseState->atIndex                   = 0UL;
+  parseState->lineNumber                = 1UL;
+  parseState->lineStartIndex            = 0UL;
+  parseState->prev_atIndex              = 0UL;
+  parseState->prev_lineNumber           = 1UL;
+  parseState->prev_lineStartIndex       = 0UL;
+  parseState->error                     = NULL;
+  parseState->errorIsPrev               = 0;
+
+  return(document);
+}
+
 ////////////
 #pragma mark Deprecated as of v1.4
 ////////////
@@ -2239,7 +2742,7 @@ static id _JKParseUTF8String(JKParseState *parseState, BOOL mutableCollections,
   if(parseState == NULL) { [NSException raise:NSInternalInconsistencyException format:@"parseState is NULL."];          }
   if(string     == NULL) { [NSException raise:NSInvalidArgumentException       format:@"The string argument is NULL."]; }
   
-  return(_JKParseUTF8String(parseState, NO, string, (size_t)length, error));
+  return(_JKParseUTF8String(parseState, NO, string, (size_t)length, NULL, error));
 }
 
 - (id)objectWithData:(NSData *)jsonData
@@ -2249,8 +2752,9 @@ static id _JKParseUTF8String(JKParseState *parseState, BOOL mutableCollections,
 
 - (id)objectWithData:(NSData *)jsonData error:(NSError **)error
 {
-  if(jsonData == NULL) { [NSException raise:NSInvalidArgumentException format:@"The jsonData argument is NULL."]; }
-  return([self objectWithUTF8String:(const unsigned char *)[jsonData bytes] length:[jsonData length] error:error]);
+  if(parseState == NULL) { [NSException raise:NSInternalInconsistencyException format:@"parseState is NULL."];             }
+  if(jsonData   == NULL) { [NSException raise:NSInvalidArgumentException       format:@"The jsonData argument is NULL."]; }
+  return(_JKParseUTF8String(parseState, NO, (const unsigned char *)[jsonData bytes], [jsonData length], jsonData, error));
 }
 
 ////////////
@@ -2267,7 +2771,7 @@ static id _JKParseUTF8String(JKParseState *parseState, BOOL mutableCollections,
   if(parseState == NULL) { [NSException raise:NSInternalInconsistencyException format:@"parseState is NULL."];          }
   if(string     == NULL) { [NSException raise:NSInvalidArgumentException       format:@"The string argument is NULL."]; }
   
-  return(_JKParseUTF8String(parseState, YES, string, (size_t)length, error));
+  return(_JKParseUTF8String(parseState, YES, string, (size_t)length, NULL, error));
 }
 
 - (id)mutableObjectWithData:(NSData *)jsonData
@@ -2277,8 +2781,29 @@ static id _JKParseUTF8String(JKParseState *parseState, BOOL mutableCollections,
 
 - (id)mutableObjectWithData:(NSData *)jsonData error:(NSError **)error
 {
-  if(jsonData == NULL) { [NSException raise:NSInvalidArgumentException format:@"The jsonData argument is NULL."]; }
-  return([self mutableObjectWithUTF8String:(const unsigned char *)[jsonData bytes] length:[jsonData length] error:error]);
+  if(parseState == NULL) { [NSException raise:NSInternalInconsistencyException format:@"parseState is NULL."];             }
+  if(jsonData   == NULL) { [NSException raise:NSInvalidArgumentException       format:@"The jsonData argument is NULL."]; }
+  return(_JKParseUTF8String(parseState, YES, (const unsigned char *)[jsonData bytes], [jsonData length], jsonData, error));
+}
+
+////////////
+#pragma mark Methods that return a read-only JKDocument
+////////////
+
+- (JKDocument *)documentWithUTF8String:(const unsigned char *)string length:(NSUInteger)length error:(NSError **)error
+{
+  if(parseState == NULL) { [NSException raise:NSInternalInconsistencyException format:@"parseState is NULL."];          }
+  if(string     == NULL) { [NSException raise:NSInvalidArgumentException       format:@"The string argument is NULL."]; }
+
+  return(_JKParseUTF8StringToDocument(parseState, string, (size_t)length, NULL, error));
+}
+
+- (JKDocument *)documentWithData:(NSData *)jsonData error:(NSError **)error
+{
+  if(parseState == NULL) { [NSException raise:NSInternalInconsistencyException format:@"parseState is NULL."];             }
+  if(jsonData   == NULL) { [NSException raise:NSInvalidArgumentException       format:@"The jsonData argument is NULL."]; }
+
+  return(_JKParseUTF8StringToDocument(parseState, (const unsigned char *)[jsonData bytes], [jsonData length], jsonData, error));
 }
 
 @end
@@ -2416,9 +2941,139 @@ exitNow:
   return(returnObject);
 }
 
+- (JKDocument *)JSONDocumentWithParseOptions:(JKParseOptionFlags)parseOptionFlags error:(NSError **)error
+{
+  JSONDecoder *decoder = NULL;
+  JKDocument *document = [(decoder = [JSONDecoder decoderWithParseOptions:parseOptionFlags]) documentWithData:self error:error];
+  if(decoder != NULL) { _JSONDecoderCleanup(decoder); }
+  return(document);
+}
+
 
 @end
 
+////////////
+#pragma mark -
+#pragma mark Read-only document accessors
+
+void JKDocumentRelease(JKDocument *document) {
+  if(document == NULL) { return; }
+
+  if(document->bridgedObjects != NULL) {
+    size_t idx = 0UL;
+    for(idx = 0UL; idx < document->count; idx++) { if(document->bridgedObjects[idx] != NULL) { CFRelease(document->bridgedObjects[idx]); document->bridgedObjects[idx] = NULL; } }
+    free(document->bridgedObjects); document->bridgedObjects = NULL;
+  }
+  if(document->slots != NULL) { free(document->slots); document->slots = NULL; }
+  jk_managedBuffer_release(&document->arena);
+  if(document->sourceData != NULL) { [document->sourceData release]; document->sourceData = NULL; }
+
+  free(document);
+}
+
+size_t JKDocumentGetValueCount(JKDocument *document) {
+  return((document != NULL) ? document->count : 0UL);
+}
+
+JKDocumentValueRef JKDocumentGetRoot(JKDocument *document) {
+  return(((document != NULL) && (document->count > 0UL)) ? 0UL : JKDocumentValueNotFound);
+}
+
+JKDocumentValueType JKDocumentValueGetType(JKDocument *document, JKDocumentValueRef value) {
+  if(JK_EXPECT_F(document == NULL) || JK_EXPECT_F(value >= document->count)) { return(JKDocumentValueTypeInvalid); }
+  return(document->slots[value].type);
+}
+
+size_t JKDocumentValueGetCount(JKDocument *document, JKDocumentValueRef value) {
+  switch(JKDocumentValueGetType(document, value)) {
+    case JKDocumentValueTypeArray:
+    case JKDocumentValueTypeDictionary: return(document->slots[value].u.container.count); break;
+    default:                            return(0UL);                                      break;
+  }
+}
+
+JKDocumentValueRef JKDocumentValueGetFirstChild(JKDocument *document, JKDocumentValueRef value) {
+  if(JKDocumentValueGetCount(document, value) == 0UL) { return(JKDocumentValueNotFound); }
+  return(value + 1UL);
+}
+
+JKDocumentValueRef JKDocumentValueGetNextSibling(JKDocument *document, JKDocumentValueRef parent, JKDocumentValueRef value) {
+  if(JKDocumentValueGetCount(document, parent) == 0UL) { return(JKDocumentValueNotFound); }
+  if(JK_EXPECT_F(value <= parent) || JK_EXPECT_F(value >= document->slots[parent].u.container.end)) { return(JKDocumentValueNotFound); }
+  JKDocumentValueRef nextValue = jk_document_next_sibling(document, value);
+  return((nextValue < document->slots[parent].u.container.end) ? nextValue : JKDocumentValueNotFound);
+}
+
+JKDocumentValueRef JKDocumentArrayGetValueAtIndex(JKDocument *document, JKDocumentValueRef array, size_t index) {
+  if((JKDocumentValueGetType(document, array) != JKDocumentValueTypeArray) || (index >= document->slots[array].u.container.count)) { return(JKDocumentValueNotFound); }
+  JKDocumentValueRef value = array + 1UL;
+  while(index-- > 0UL) { value = jk_document_next_sibling(document, value); }
+  return(value);
+}
+
+JKDocumentValueRef JKDocumentDictionaryGetValueForKeyBytes(JKDocument *document, JKDocumentValueRef dictionary, const unsigned char *keyBytes, size_t keyLength) {
+  if((JKDocumentValueGetType(document, dictionary) != JKDocumentValueTypeDictionary) || (keyBytes == NULL)) { return(JKDocumentValueNotFound); }
+  JKDocumentValueRef key = dictionary + 1UL, end = document->slots[dictionary].u.container.end;
+
+  while(key < end) {
+    JKDocumentSlot *keySlot = &document->slots[key];
+    NSCParameterAssert(keySlot->type == JKDocumentValueTypeString);
+    if((keySlot->u.string.length == keyLength) && (memcmp(jk_document_string_bytes(document, keySlot), keyBytes, keyLength) == 0)) { return(key + 1UL); }
+    key = jk_document_next_sibling(document, key + 1UL);
+  }
+  return(JKDocumentValueNotFound);
+}
+
+JKDocumentValueRef JKDocumentDictionaryGetValueForKey(JKDocument *document, JKDocumentValueRef dictionary, const char *key) {
+  if(key == NULL) { return(JKDocumentValueNotFound); }
+  return(JKDocumentDictionaryGetValueForKeyBytes(document, dictionary, (const unsigned char *)key, strlen(key)));
+}
+
+const unsigned char *JKDocumentValueGetUTF8Bytes(JKDocument *document, JKDocumentValueRef value, size_t *length) {
+  if(JKDocumentValueGetType(document, value) != JKDocumentValueTypeString) { if(length != NULL) { *length = 0UL; } return(NULL); }
+  if(length != NULL) { *length = document->slots[value].u.string.length; }
+  return(jk_document_string_bytes(document, &document->slots[value]));
+}
+
+long long JKDocumentValueGetLongLongValue(JKDocument *document, JKDocumentValueRef value) {
+  switch(JKDocumentValueGetType(document, value)) {
+    case JKDocumentValueTypeTrue:             return(1LL);                                                   break;
+    case JKDocumentValueTypeLongLong:         return(document->slots[value].u.longLongValue);                break;
+    case JKDocumentValueTypeUnsignedLongLong: return((long long)document->slots[value].u.unsignedLongLongValue); break;
+    case JKDocumentValueTypeDouble:           return((long long)document->slots[value].u.doubleValue);       break;
+    default:                                  return(0LL);                                                   break;
+  }
+}
+
+unsigned long long JKDocumentValueGetUnsignedLongLongValue(JKDocument *document, JKDocumentValueRef value) {
+  switch(JKDocumentValueGetType(document, value)) {
+    case JKDocumentValueTypeTrue:             return(1ULL);                                                        break;
+    case JKDocumentValueTypeLongLong:         return((unsigned long long)document->slots[value].u.longLongValue);  break;
+    case JKDocumentValueTypeUnsignedLongLong: return(document->slots[value].u.unsignedLongLongValue);              break;
+    case JKDocumentValueTypeDouble:           return((unsigned long long)document->slots[value].u.doubleValue);    break;
+    default:                                  return(0ULL);                                                        break;
+  }
+}
+
+double JKDocumentValueGetDoubleValue(JKDocument *document, JKDocumentValueRef value) {
+  switch(JKDocumentValueGetType(document, value)) {
+    case JKDocumentValueTypeTrue:             return(1.0);                                                 break;
+    case JKDocumentValueTypeLongLong:         return((double)document->slots[value].u.longLongValue);      break;
+    case JKDocumentValueTypeUnsignedLongLong: return((double)document->slots[value].u.unsignedLongLongValue); break;
+    case JKDocumentValueTypeDouble:           return(document->slots[value].u.doubleValue);                break;
+    default:                                  return(0.0);                                                 break;
+  }
+}
+
+BOOL JKDocumentValueGetBoolValue(JKDocument *document, JKDocumentValueRef value) {
+  return((JKDocumentValueGetLongLongValue(document, value) != 0LL) || (JKDocumentValueGetDoubleValue(document, value) != 0.0));
+}
+
+id JKDocumentValueGetObject(JKDocument *document, JKDocumentValueRef value) {
+  if(JKDocumentValueGetType(document, value) == JKDocumentValueTypeInvalid) { return(NULL); }
+  return((id)jk_document_bridge(document, value));
+}
+
 ////////////
 #pragma mark -
 #pragma mark Encoding / deserializing functions
@@ -2817,6 +3472,121 @@ static int jk_encode_add_atom_to_buffer(JKEncodeState *encodeState, void *object
   return(0);
 }
 
+#ifdef __BLOCKS__
+
+#pragma mark Parallel encoding of large top level collections
+
+// Returns the number of chunks to split the top level collection in to, or 0 if it should be encoded serially.
+static size_t jk_encode_parallel_chunk_count(JKEncodeState *encodeState, id object) {
+  NSCParameterAssert((encodeState != NULL) && (object != NULL));
+  if(JK_EXPECT_T((encodeState->serializeOptionFlags & JKSerializeOptionParallel) == 0UL) || ((encodeState->encodeOption & JKEncodeOptionCollectionObj) == 0UL)) { return(0UL); }
+  // The unsupported class formatters are user code that we can not assume is thread safe.
+  if((encodeState->classFormatterIMP != NULL) || (encodeState->classFormatterBlock != NULL)) { return(0UL); }
+
+  long   onlineCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t count      = 0UL;
+
+  if(onlineCPUs < 2L) { return(0UL); }
+       if([object isKindOfClass:[NSArray      class]]) { count = (size_t)CFArrayGetCount((CFArrayRef)object);           }
+  else if([object isKindOfClass:[NSDictionary class]]) { count = (size_t)CFDictionaryGetCount((CFDictionaryRef)object); }
+  if(count < JK_PARALLEL_ENCODE_MIN_COUNT) { return(0UL); }
+
+  // A few chunks per CPU so that a chunk full of large strings doesn't leave the other CPUs idle at the end.
+  return(jk_min((size_t)onlineCPUs * 4UL, count / JK_PARALLEL_ENCODE_MIN_CHUNK));
+}
+
+// Each chunk is encoded in to its own JKEncodeState at depth 1, exactly as the serial encoder would have written it inside the
+// top level [ ] or { }.  The chunks are then copied, in order, in to encodeState with the same ',' separator that the serial
+// encoder writes between elements, which makes the output byte for byte identical (the encode cache only ever copies bytes).
+static int jk_encode_add_collection_in_parallel(JKEncodeState *encodeState, id object, size_t chunkCount) {
+  NSCParameterAssert((encodeState != NULL) && (encodeState->atIndex < encodeState->stringBuffer.bytes.length) && (object != NULL) && (chunkCount > 1UL));
+
+  int              _jk_encode_prettyPrint = JK_EXPECT_T((encodeState->serializeOptionFlags & JKSerializeOptionPretty) == 0) ? 0 : 1;
+  BOOL             isDictionary           = [object isKindOfClass:[NSDictionary class]];
+  size_t           count                  = isDictionary ? (size_t)CFDictionaryGetCount((CFDictionaryRef)object) : (size_t)CFArrayGetCount((CFArrayRef)object), idx = 0UL, chunk = 0UL, chunkSize = 0UL;
+  void           **items                  = NULL;
+  JKEncodeState  **chunkStates            = NULL;
+  int              returnValue            = 1;
+
+  if(JK_EXPECT_F((items = (void **)malloc(sizeof(void *) * count)) == NULL) || JK_EXPECT_F((chunkStates = (JKEncodeState **)calloc(chunkCount, sizeof(JKEncodeState *))) == NULL)) { jk_encode_error(encodeState, @"Unable to allocate parallel encoding state."); goto exitNow; }
+
+  if(isDictionary) {
+    // Must match the key order used by the serial dictionary encoder for > 1020 keys, or for pretty printing.
+    id enumerateObject = JK_EXPECT_F(_jk_encode_prettyPrint) ? [[object allKeys] sortedArrayUsingSelector:@selector(compare:)] : object;
+    for(id keyObject in enumerateObject) { if(JK_EXPECT_T(idx < count)) { items[idx++] = keyObject; } }
+    count = idx;
+  } else {
+    CFArrayGetValues((CFArrayRef)object, CFRangeMake(0L, (CFIndex)count), (const void **)items);
+  }
+
+  if(JK_EXPECT_F(count == 0UL)) { chunkCount = 0UL; }
+  else { chunkSize = (count + (chunkCount - 1UL)) / chunkCount; chunkCount = (count + (chunkSize - 1UL)) / chunkSize; }
+
+  dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0UL), ^(size_t chunkIdx) {
+      NSAutoreleasePool *pool       = [[NSAutoreleasePool alloc] init];
+      JKEncodeState     *chunkState = NULL;
+      size_t             startIdx   = chunkIdx * chunkSize, endIdx = jk_min(startIdx + chunkSize, count), itemIdx = 0UL;
+
+      if(JK_EXPECT_F((chunkState = (JKEncodeState *)calloc(1UL, sizeof(JKEncodeState))) == NULL)) { goto chunkExit; }
+      chunkStates[chunkIdx] = chunkState;
+
+      chunkState->serializeOptionFlags                         = encodeState->serializeOptionFlags;
+      chunkState->encodeOption                                 = encodeState->encodeOption;
+      chunkState->depth                                        = 1UL;
+      chunkState->stringBuffer.roundSizeUpToMultipleOf         = (1024UL * 32UL);
+      chunkState->utf8ConversionBuffer.roundSizeUpToMultipleOf = 4096UL;
+      chunkState->stringBuffer.flags                           = (JKManagedBufferOnHeap | JKManagedBufferMustFree);
+      chunkState->utf8ConversionBuffer.flags                   = (JKManagedBufferOnHeap | JKManagedBufferMustFree);
+
+      if(JK_EXPECT_F(jk_managedBuffer_resize(&chunkState->stringBuffer, JK_JSONBUFFER_SIZE * 4UL) == NULL) || JK_EXPECT_F(jk_managedBuffer_resize(&chunkState->utf8ConversionBuffer, JK_UTF8BUFFER_SIZE) == NULL)) { jk_encode_error(chunkState, @"Unable to resize temporary buffer."); goto chunkExit; }
+
+      for(itemIdx = startIdx; itemIdx < endIdx; itemIdx++) {
+        if(JK_EXPECT_T(itemIdx > startIdx)) { if(JK_EXPECT_F(jk_encode_write1(chunkState, 0L, ","))) { goto chunkExit; } }
+        if(isDictionary) {
+          id keyObject = (id)items[itemIdx];
+          if(JK_EXPECT_F([keyObject isKindOfClass:[NSString class]] == NO))                                                                { jk_encode_error(chunkState, @"Key must be a string object."); goto chunkExit; }
+          if(JK_EXPECT_F(jk_encode_add_atom_to_buffer(chunkState, keyObject)))                                                             { goto chunkExit; }
+          if(JK_EXPECT_F(jk_encode_write1(chunkState, 0L, ":")))                                                                           { goto chunkExit; }
+          if(JK_EXPECT_F(jk_encode_add_atom_to_buffer(chunkState, (void *)CFDictionaryGetValue((CFDictionaryRef)object, keyObject))))    { goto chunkExit; }
+        } else {
+          if(JK_EXPECT_F(jk_encode_add_atom_to_buffer(chunkState, items[itemIdx])))                                                        { goto chunkExit; }
+        }
+      }
+
+    chunkExit:
+      if((chunkState != NULL) && (chunkState->error != NULL)) { [chunkState->error retain]; } // Must outlive the chunk's autorelease pool.
+      [pool drain];
+    });
+
+  if(JK_EXPECT_F(jk_encode_write1(encodeState, 1L, isDictionary ? "{" : "["))) { goto exitNow; }
+  for(chunk = 0UL; chunk < chunkCount; chunk++) {
+    JKEncodeState *chunkState = chunkStates[chunk];
+    if(JK_EXPECT_F(chunkState == NULL))        { jk_encode_error(encodeState, @"Unable to allocate parallel encoding state."); goto exitNow; }
+    if(JK_EXPECT_F(chunkState->error != NULL)) { if(encodeState->error == NULL) { encodeState->error = [[chunkState->error retain] autorelease]; } goto exitNow; }
+    if(JK_EXPECT_T(chunk > 0UL)) { if(JK_EXPECT_F(jk_encode_write1(encodeState, 0L, ","))) { goto exitNow; } }
+    if(JK_EXPECT_F(jk_encode_writen(encodeState, NULL, 0UL, NULL, (const char *)chunkState->stringBuffer.bytes.ptr, chunkState->atIndex))) { goto exitNow; }
+  }
+  returnValue = jk_encode_write1(encodeState, -1L, isDictionary ? "}" : "]");
+
+exitNow:
+  if(chunkStates != NULL) {
+    for(chunk = 0UL; chunk < chunkCount; chunk++) {
+      JKEncodeState *chunkState = chunkStates[chunk];
+      if(chunkState == NULL) { continue; }
+      if(chunkState->error != NULL) { [chunkState->error release]; chunkState->error = NULL; }
+      jk_managedBuffer_release(&chunkState->stringBuffer);
+      jk_managedBuffer_release(&chunkState->utf8ConversionBuffer);
+      free(chunkState);
+    }
+    free(chunkStates); chunkStates = NULL;
+  }
+  if(items != NULL) { free(items); items = NULL; }
+
+  return(returnValue);
+}
+
+#endif // __BLOCKS__
+
 
 @implementation JKSerializer
 
@@ -2867,7 +3637,15 @@ static int jk_encode_add_atom_to_buffer(JKEncodeState *encodeState, void *object
   if(((encodeOption & JKEncodeOptionCollectionObj) != 0UL) && (([object isKindOfClass:[NSArray  class]] == NO) && ([object isKindOfClass:[NSDictionary class]] == NO))) { jk_encode_error(encodeState, @"Unable to serialize object class %@, expected a NSArray or NSDictionary.", NSStringFromClass([object class])); goto errorExit; }
   if(((encodeOption & JKEncodeOptionStringObj)     != 0UL) &&  ([object isKindOfClass:[NSString class]] == NO))                                                         { jk_encode_error(encodeState, @"Unable to serialize object class %@, expected a NSString.", NSStringFromClass([object class])); goto errorExit; }
 
-  if(jk_encode_add_atom_to_buffer(encodeState, object) == 0) {
+  int encodeFailed = 1;
+#ifdef __BLOCKS__
+  size_t parallelChunkCount = jk_encode_parallel_chunk_count(encodeState, object);
+  if(parallelChunkCount > 1UL) { encodeFailed = jk_encode_add_collection_in_parallel(encodeState, object, parallelChunkCount); }
+  else
+#endif
+  encodeFailed = jk_encode_add_atom_to_buffer(encodeState, object);
+
+  if(encodeFailed == 0) {
     BOOL stackBuffer = ((encodeState->stringBuffer.flags & JKManagedBufferMustFree) == 0UL) ? YES : NO;
     
     if((encodeState->atIndex < 2UL))
@@ -0,0 +1,261 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <pthread.h>
+
+#import "NIInMemoryCache.h"
+#import "NIMemoryGovernor.h"
+
+/**
+ * Thread-safe in-memory caches.
+ *
+ * NIMemoryCache and NIImageMemoryCache must only be used from one thread. The caches below
+ * split their objects across a number of shards, each an ordinary NIMemoryCache guarded by its
+ * own lock. A name always maps to the same shard, so threads touching different names rarely
+ * wait on one another, and a reader on the main thread only ever waits for the one shard it
+ * needs.
+ *
+ *      @ingroup In-Memory-Caches
+ *      @{
+ */
+
+/**
+ * A lock-striped in-memory cache that may be used from any thread.
+ *
+ * Each shard has its own least recently used list, so eviction within a shard is exact and
+ * eviction across shards is approximate.
+ */
+@interface NIConcurrentMemoryCache : NSObject <NIMemoryGovernedObject> {
+@private
+  NSArray*          _shards;
+  pthread_mutex_t*  _shardLocks;
+  NSUInteger        _numberOfShards;
+  volatile int32_t  _nextShardToEvict;
+}
+
+// Designated initializer.
+- (id)initWithShardClass:(Class)shardClass numberOfShards:(NSUInteger)numberOfShards;
+
+@property (nonatomic, readonly, assign) NSUInteger numberOfShards;
+
+- (NSUInteger)count;
+
+- (void)storeObject:(id)object withName:(NSString *)name;
+- (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate;
+- (void)storeObjects:(NSArray *)objects withNames:(NSArray *)names;
+
+- (void)removeObjectWithName:(NSString *)name;
+- (void)removeObjectsWithNamePrefix:(NSString *)prefix;
+- (void)removeObjectsPassingTest:(BOOL (^)(NSString* name, id object))predicate;
+- (void)removeAllObjects;
+
+- (id)objectWithName:(NSString *)name;
+- (id)peekObjectWithName:(NSString *)name;
+- (BOOL)containsObjectWithName:(NSString *)name;
+
+- (void)reduceMemoryUsage;
+- (unsigned long long)memoryCost;
+- (void)reduceMemoryCostTo:(unsigned long long)memoryCost;
+
+- (BOOL)evictObject;
+
+- (NIMemoryCacheStatistics)statistics;
+- (void)resetStatistics;
+
+- (void)enumerateShardsUsingBlock:(void (^)(id shard))block;
+
+@end
+
+
+/**
+ * A lock-striped image cache with caps on the total number of pixels and bytes across all
+ * shards.
+ *
+ * The shards are NIImageMemoryCache objects without limits of their own. When a total passes
+ * its cap, images are evicted from the shards in turn, each shard giving up the object its
+ * nameOfObjectToEvict chooses, until the total fits again.
+ */
+@interface NIConcurrentImageMemoryCache : NIConcurrentMemoryCache {
+@private
+  NSUInteger*       _numberOfPixelsInShards;
+  NSUInteger*       _numberOfBytesInShards;
+  volatile int64_t  _numberOfPixels;
+  volatile int64_t  _numberOfBytes;
+
+  NSUInteger _maxNumberOfPixels;
+  NSUInteger _maxNumberOfPixelsUnderStress;
+  NSUInteger _maxNumberOfBytes;
+  NSUInteger _maxNumberOfBytesUnderStress;
+}
+
+- (id)initWithNumberOfShards:(NSUInteger)numberOfShards;
+
+@property (nonatomic, readonly, assign) NSUInteger numberOfPixels;
+@property (nonatomic, readwrite, assign) NSUInteger maxNumberOfPixels;
+@property (nonatomic, readwrite, assign) NSUInteger maxNumberOfPixelsUnderStress;
+
+@property (nonatomic, readonly, assign) NSUInteger numberOfBytes;
+@property (nonatomic, readwrite, assign) NSUInteger maxNumberOfBytes;
+@property (nonatomic, readwrite, assign) NSUInteger maxNumberOfBytesUnderStress;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**@}*/// End of In-Memory Cache //////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+/** @name Creating a Concurrent Cache */
+
+/**
+ * Initializes a cache whose objects are spread across numberOfShards instances of shardClass.
+ *
+ * shardClass must be NIMemoryCache or a subclass of it. numberOfShards is rounded up to a power
+ * of two. The shards are not registered with the memory governor themselves; the concurrent
+ * cache is, and trims them under each shard's lock instead.
+ *
+ *      @fn NIConcurrentMemoryCache::initWithShardClass:numberOfShards:
+ */
+
+
+/** @name Configuring Shards */
+
+/**
+ * Calls block once for each shard while holding that shard's lock.
+ *
+ * Use this to configure the shards, for example to give each its own eviction policy. The
+ * block must not call back into this cache and must not keep a reference to the shard.
+ *
+ *      @fn NIConcurrentMemoryCache::enumerateShardsUsingBlock:
+ */
+
+
+/** @name Accessing Objects */
+
+/**
+ * These methods behave like their NIMemoryCache counterparts, and are safe to call from any
+ * thread.
+ *
+ * Objects returned by objectWithName: and peekObjectWithName: are retained and autoreleased in
+ * the calling thread's pool, so they survive being evicted by another thread right away.
+ *
+ *      @fn NIConcurrentMemoryCache::objectWithName:
+ */
+
+/**
+ * Stores many objects at once.
+ *
+ * The objects are grouped by shard, and each shard stores its group as one batch under a
+ * single acquisition of its lock.
+ *
+ *      @see NIMemoryCache::storeObjects:withNames:
+ *      @fn NIConcurrentMemoryCache::storeObjects:withNames:
+ */
+
+/**
+ * Removes every object for which predicate returns YES, one shard at a time.
+ *
+ * The predicate is called with the shard's lock held, so it must not call back into this cache.
+ *
+ *      @see NIMemoryCache::removeObjectsPassingTest:
+ *      @fn NIConcurrentMemoryCache::removeObjectsPassingTest:
+ */
+
+/**
+ * Removes one object, taking the shards in turn.
+ *
+ * Lets an owner of several caches enforce a budget shared between them.
+ *
+ *      @returns NO if every shard was empty.
+ *      @fn NIConcurrentMemoryCache::evictObject
+ */
+
+/**
+ * The statistics of all shards added together.
+ *
+ * Like count, this is only a snapshot when other threads are using the cache.
+ *
+ *      @see NIMemoryCache::statistics
+ *      @fn NIConcurrentMemoryCache::statistics
+ */
+
+/**
+ * Returns the number of objects in all shards.
+ *
+ * The shards are counted one at a time, so the result is only a snapshot when other threads
+ * are storing objects.
+ *
+ *      @fn NIConcurrentMemoryCache::count
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// NIConcurrentImageMemoryCache
+
+/**
+ * Initializes an image cache with the given number of shards and no pixel limits.
+ *
+ * init uses eight shards.
+ *
+ *      @fn NIConcurrentImageMemoryCache::initWithNumberOfShards:
+ */
+
+/**
+ * The total number of pixels stored in all shards.
+ *
+ *      @fn NIConcurrentImageMemoryCache::numberOfPixels
+ */
+
+/**
+ * The maximum number of pixels this cache may store across all of its shards.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of pixels.
+ *
+ *      @fn NIConcurrentImageMemoryCache::maxNumberOfPixels
+ */
+
+/**
+ * The maximum number of pixels this cache may store after a call to reduceMemoryUsage.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of pixels.
+ *
+ *      @fn NIConcurrentImageMemoryCache::maxNumberOfPixelsUnderStress
+ */
+
+/**
+ * The total number of bytes used by the bitmaps of the images in all shards.
+ *
+ *      @see NIImageMemoryCache::numberOfBytes
+ *      @fn NIConcurrentImageMemoryCache::numberOfBytes
+ */
+
+/**
+ * The maximum number of bytes this cache may store across all of its shards.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ *      @fn NIConcurrentImageMemoryCache::maxNumberOfBytes
+ */
+
+/**
+ * The maximum number of bytes this cache may store after a call to reduceMemoryUsage.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ *      @fn NIConcurrentImageMemoryCache::maxNumberOfBytesUnderStress
+ */
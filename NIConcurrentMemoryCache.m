@@ -0,0 +1,508 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIConcurrentMemoryCache.h"
+
+#import "NIDebuggingTools.h"
+#import "NIInMemoryCache.h"
+#import "NIPreprocessorMacros.h"
+#import "NIState.h"
+
+#import <libkern/OSAtomic.h>
+
+static const NSUInteger kDefaultNumberOfShards = 8;
+
+@interface NIConcurrentMemoryCache()
+- (NSUInteger)shardIndexForName:(NSString *)name;
+- (id)shardAtIndex:(NSUInteger)shardIndex;
+- (id)lockShardAtIndex:(NSUInteger)shardIndex;
+- (void)unlockShardAtIndex:(NSUInteger)shardIndex;
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIConcurrentMemoryCache
+
+@synthesize numberOfShards = _numberOfShards;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [[Nimbus memoryGovernor] unregisterObject:self];
+
+  if (NULL != _shardLocks) {
+    for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+      pthread_mutex_destroy(&_shardLocks[ix]);
+    }
+    free(_shardLocks);
+    _shardLocks = NULL;
+  }
+  NI_RELEASE_SAFELY(_shards);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithShardClass:[NIMemoryCache class] numberOfShards:kDefaultNumberOfShards];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithShardClass:(Class)shardClass numberOfShards:(NSUInteger)numberOfShards {
+  NIDASSERT([shardClass isSubclassOfClass:[NIMemoryCache class]]);
+
+  if ((self = [super init])) {
+    // A power of two lets us pick a shard with a mask.
+    _numberOfShards = 1;
+    while (_numberOfShards < numberOfShards) {
+      _numberOfShards <<= 1;
+    }
+
+    _shardLocks = malloc(sizeof(pthread_mutex_t) * _numberOfShards);
+    if (NULL == _shardLocks) {
+      [self release];
+      return nil;
+    }
+
+    NSMutableArray* shards = [NSMutableArray arrayWithCapacity:_numberOfShards];
+    for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+      pthread_mutex_init(&_shardLocks[ix], NULL);
+
+      NIMemoryCache* shard = [[shardClass alloc] init];
+
+      // The governor would otherwise trim the shard on the main thread without its lock.
+      [[Nimbus memoryGovernor] unregisterObject:shard];
+      [shards addObject:shard];
+      [shard release];
+    }
+    _shards = [shards copy];
+
+    [[Nimbus memoryGovernor] registerObject:self withPriority:NIMemoryPriorityNormal];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Shards
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)shardIndexForName:(NSString *)name {
+  // NSString's hash is weak in its low bits, which are the ones the mask keeps.
+  uint64_t hash = [name hash];
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return (NSUInteger)hash & (_numberOfShards - 1);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)shardAtIndex:(NSUInteger)shardIndex {
+  return [_shards objectAtIndex:shardIndex];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)lockShardAtIndex:(NSUInteger)shardIndex {
+  pthread_mutex_lock(&_shardLocks[shardIndex]);
+  return [self shardAtIndex:shardIndex];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)unlockShardAtIndex:(NSUInteger)shardIndex {
+  pthread_mutex_unlock(&_shardLocks[shardIndex]);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)enumerateShardsUsingBlock:(void (^)(id shard))block {
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    id shard = [self lockShardAtIndex:ix];
+    block(shard);
+    [self unlockShardAtIndex:ix];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Public Methods
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)storeObject:(id)object withName:(NSString *)name {
+  [self storeObject:object withName:name expiresAfter:nil];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate {
+  NSUInteger shardIndex = [self shardIndexForName:name];
+  NIMemoryCache* shard = [self lockShardAtIndex:shardIndex];
+  [shard storeObject:object withName:name expiresAfter:expirationDate];
+  [self unlockShardAtIndex:shardIndex];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)storeObjects:(NSArray *)objects withNames:(NSArray *)names {
+  NIDASSERT([objects count] == [names count]);
+  NSUInteger count = MIN([objects count], [names count]);
+  if (0 == count) {
+    return;
+  }
+
+  NSMutableArray* objectsInShards = [NSMutableArray arrayWithCapacity:_numberOfShards];
+  NSMutableArray* namesInShards = [NSMutableArray arrayWithCapacity:_numberOfShards];
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    [objectsInShards addObject:[NSMutableArray array]];
+    [namesInShards addObject:[NSMutableArray array]];
+  }
+
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    NSString* name = [names objectAtIndex:ix];
+    NSUInteger shardIndex = [self shardIndexForName:name];
+    [[objectsInShards objectAtIndex:shardIndex] addObject:[objects objectAtIndex:ix]];
+    [[namesInShards objectAtIndex:shardIndex] addObject:name];
+  }
+
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    NSArray* namesInShard = [namesInShards objectAtIndex:ix];
+    if ([namesInShard count] > 0) {
+      NIMemoryCache* shard = [self lockShardAtIndex:ix];
+      [shard storeObjects:[objectsInShards objectAtIndex:ix] withNames:namesInShard];
+      [self unlockShardAtIndex:ix];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)objectWithName:(NSString *)name {
+  NSUInteger shardIndex = [self shardIndexForName:name];
+  NIMemoryCache* shard = [self lockShardAtIndex:shardIndex];
+  id object = [shard objectWithName:name];
+  [self unlockShardAtIndex:shardIndex];
+  return object;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)peekObjectWithName:(NSString *)name {
+  NSUInteger shardIndex = [self shardIndexForName:name];
+  NIMemoryCache* shard = [self lockShardAtIndex:shardIndex];
+  id object = [shard peekObjectWithName:name];
+  [self unlockShardAtIndex:shardIndex];
+  return object;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)containsObjectWithName:(NSString *)name {
+  NSUInteger shardIndex = [self shardIndexForName:name];
+  NIMemoryCache* shard = [self lockShardAtIndex:shardIndex];
+  BOOL containsObject = [shard containsObjectWithName:name];
+  [self unlockShardAtIndex:shardIndex];
+  return containsObject;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObjectWithName:(NSString *)name {
+  NSUInteger shardIndex = [self shardIndexForName:name];
+  NIMemoryCache* shard = [self lockShardAtIndex:shardIndex];
+  [shard removeObjectWithName:name];
+  [self unlockShardAtIndex:shardIndex];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObjectsPassingTest:(BOOL (^)(NSString* name, id object))predicate {
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    NIMemoryCache* shard = [self lockShardAtIndex:ix];
+    [shard removeObjectsPassingTest:predicate];
+    [self unlockShardAtIndex:ix];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObjectsWithNamePrefix:(NSString *)prefix {
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    NIMemoryCache* shard = [self lockShardAtIndex:ix];
+    [shard removeObjectsWithNamePrefix:prefix];
+    [self unlockShardAtIndex:ix];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeAllObjects {
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    NIMemoryCache* shard = [self lockShardAtIndex:ix];
+    [shard removeAllObjects];
+    [self unlockShardAtIndex:ix];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryUsage {
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    NIMemoryCache* shard = [self lockShardAtIndex:ix];
+    [shard reduceMemoryUsage];
+    [self unlockShardAtIndex:ix];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)evictObjectFromShardAtIndex:(NSUInteger)shardIndex
+                             reason:(NIMemoryCacheRemovalReason)reason {
+  NIMemoryCache* shard = [self lockShardAtIndex:shardIndex];
+  NSString* name = [[[shard nameOfObjectToEvict] retain] autorelease];
+  if (nil != name) {
+    [shard removeObjectWithName:name reason:reason];
+  }
+  [self unlockShardAtIndex:shardIndex];
+  return (nil != name);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)evictObjectForReason:(NIMemoryCacheRemovalReason)reason {
+  // Take one object from each shard in turn, so the shards shrink evenly.
+  for (NSUInteger ix = 0; ix < self.numberOfShards; ++ix) {
+    uint32_t turn = (uint32_t)OSAtomicIncrement32Barrier(&_nextShardToEvict);
+    if ([self evictObjectFromShardAtIndex: (turn & (self.numberOfShards - 1))
+                                   reason: reason]) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)evictObject {
+  return [self evictObjectForReason:NIMemoryCacheRemovalReasonCapacity];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (unsigned long long)memoryCost {
+  return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryCostTo:(unsigned long long)memoryCost {
+  while ([self memoryCost] > memoryCost) {
+    if (![self evictObjectForReason:NIMemoryCacheRemovalReasonMemoryPressure]) {
+      break;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)count {
+  NSUInteger count = 0;
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    NIMemoryCache* shard = [self lockShardAtIndex:ix];
+    count += [shard count];
+    [self unlockShardAtIndex:ix];
+  }
+  return count;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NIMemoryCacheStatistics)statistics {
+  NIMemoryCacheStatistics statistics;
+  memset(&statistics, 0, sizeof(statistics));
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    NIMemoryCache* shard = [self lockShardAtIndex:ix];
+    statistics = NIMemoryCacheStatisticsAdd(statistics, [shard statistics]);
+    [self unlockShardAtIndex:ix];
+  }
+  return statistics;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)resetStatistics {
+  for (NSUInteger ix = 0; ix < _numberOfShards; ++ix) {
+    NIMemoryCache* shard = [self lockShardAtIndex:ix];
+    [shard resetStatistics];
+    [self unlockShardAtIndex:ix];
+  }
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIConcurrentImageMemoryCache
+
+@synthesize maxNumberOfPixels             = _maxNumberOfPixels;
+@synthesize maxNumberOfPixelsUnderStress  = _maxNumberOfPixelsUnderStress;
+@synthesize maxNumberOfBytes              = _maxNumberOfBytes;
+@synthesize maxNumberOfBytesUnderStress   = _maxNumberOfBytesUnderStress;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  free(_numberOfPixelsInShards);
+  _numberOfPixelsInShards = NULL;
+  free(_numberOfBytesInShards);
+  _numberOfBytesInShards = NULL;
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithNumberOfShards:kDefaultNumberOfShards];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithNumberOfShards:(NSUInteger)numberOfShards {
+  return [self initWithShardClass:[NIImageMemoryCache class] numberOfShards:numberOfShards];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithShardClass:(Class)shardClass numberOfShards:(NSUInteger)numberOfShards {
+  NIDASSERT([shardClass isSubclassOfClass:[NIImageMemoryCache class]]);
+
+  if ((self = [super initWithShardClass:shardClass numberOfShards:numberOfShards])) {
+    _numberOfPixelsInShards = calloc(self.numberOfShards, sizeof(NSUInteger));
+    _numberOfBytesInShards = calloc(self.numberOfShards, sizeof(NSUInteger));
+    if (NULL == _numberOfPixelsInShards || NULL == _numberOfBytesInShards) {
+      [self release];
+      return nil;
+    }
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)unlockShardAtIndex:(NSUInteger)shardIndex {
+  // Every change to a shard happens between a lock and an unlock, so this is the one place
+  // that needs to keep the totals up to date. The per-shard counts are guarded by the shard's
+  // lock.
+  NIImageMemoryCache* shard = [self shardAtIndex:shardIndex];
+  NSUInteger numberOfPixels = shard.numberOfPixels;
+  NSUInteger numberOfBytes = shard.numberOfBytes;
+  int64_t pixelsDelta = (int64_t)numberOfPixels - (int64_t)_numberOfPixelsInShards[shardIndex];
+  int64_t bytesDelta = (int64_t)numberOfBytes - (int64_t)_numberOfBytesInShards[shardIndex];
+  _numberOfPixelsInShards[shardIndex] = numberOfPixels;
+  _numberOfBytesInShards[shardIndex] = numberOfBytes;
+
+  [super unlockShardAtIndex:shardIndex];
+
+  if (0 != pixelsDelta) {
+    OSAtomicAdd64Barrier(pixelsDelta, &_numberOfPixels);
+  }
+  if (0 != bytesDelta) {
+    OSAtomicAdd64Barrier(bytesDelta, &_numberOfBytes);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceToMaxNumberOfPixels:(NSUInteger)maxNumberOfPixels
+                 maxNumberOfBytes:(NSUInteger)maxNumberOfBytes
+                           reason:(NIMemoryCacheRemovalReason)reason {
+  while ((maxNumberOfPixels > 0 && self.numberOfPixels > maxNumberOfPixels)
+         || (maxNumberOfBytes > 0 && self.numberOfBytes > maxNumberOfBytes)) {
+    if (![self evictObjectForReason:reason]) {
+      break;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate {
+  [super storeObject:object withName:name expiresAfter:expirationDate];
+
+  [self reduceToMaxNumberOfPixels: self.maxNumberOfPixels
+                 maxNumberOfBytes: self.maxNumberOfBytes
+                           reason: NIMemoryCacheRemovalReasonCapacity];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)storeObjects:(NSArray *)objects withNames:(NSArray *)names {
+  [super storeObjects:objects withNames:names];
+
+  // The totals only span shards, so they are enforced once the whole batch is in.
+  [self reduceToMaxNumberOfPixels: self.maxNumberOfPixels
+                 maxNumberOfBytes: self.maxNumberOfBytes
+                           reason: NIMemoryCacheRemovalReasonCapacity];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryUsage {
+  // Remove all expired images first.
+  [super reduceMemoryUsage];
+
+  [self reduceToMaxNumberOfPixels: self.maxNumberOfPixelsUnderStress
+                 maxNumberOfBytes: self.maxNumberOfBytesUnderStress
+                           reason: NIMemoryCacheRemovalReasonMemoryPressure];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)numberOfPixels {
+  int64_t numberOfPixels = _numberOfPixels;
+  return (numberOfPixels > 0) ? (NSUInteger)numberOfPixels : 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (unsigned long long)memoryCost {
+  return self.numberOfBytes;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)numberOfBytes {
+  int64_t numberOfBytes = _numberOfBytes;
+  return (numberOfBytes > 0) ? (NSUInteger)numberOfBytes : 0;
+}
+
+
+@end
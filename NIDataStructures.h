@@ -76,6 +76,9 @@ struct NILinkedListNode {
   struct NILinkedListNode* next;
 };
 
+// This is not to be used externally. Nodes are allocated in contiguous slabs.
+struct NILinkedListSlab;
+
 // A thin veil over NILinkedListNode pointers. This is the "public" interface to an object's
 // location. Internally, this is cast to an NILinkedListNode*.
 typedef void NILinkedListLocation;
@@ -94,6 +97,10 @@ typedef void NILinkedListLocation;
  * If an object's location is known, it is possible to get O(1) constant time removal
  * with a linked list, where an NSMutableArray would get at best O(N) linear time.
  *
+ * Nodes are not allocated one at a time. They come from contiguous slabs owned by the list
+ * and are recycled when objects are removed, so lists that churn, such as the lru list of an
+ * in-memory cache, rarely touch the allocator, and nodes added together sit together in memory.
+ *
  * This collection implements NSFastEnumeration which allows you to use foreach-style
  * iteration on the linked list. If you would like more control over the iteration of the
  * linked list you can use
@@ -122,6 +129,12 @@ typedef void NILinkedListLocation;
 
   // Used internally to track modifications to the linked list.
   unsigned long _modificationNumber;
+
+  // Nodes are carved out of slabs and recycled through a free list rather than being
+  // allocated one at a time.
+  struct NILinkedListSlab* _slabs;
+  struct NILinkedListNode* _freeNodes;
+  NSUInteger _nextSlabCapacity;
 }
 
 - (NSUInteger)count;
@@ -150,6 +163,7 @@ typedef void NILinkedListLocation;
 - (NILinkedListLocation *)locationOfObject:(id)object;
 - (id)objectAtLocation:(NILinkedListLocation *)location;
 - (void)removeObjectAtLocation:(NILinkedListLocation *)location;
+- (void)moveObjectAtLocationToTail:(NILinkedListLocation *)location;
 
 #pragma mark Mutable Operations
 // TODO (jverkoey August 3, 2011): Consider creating an NIMutableLinkedList implementation.
@@ -426,6 +440,9 @@ typedef void NILinkedListLocation;
 /**
  * Removes all objects from the linked list.
  *
+ * This is the only method that gives the list's node memory back. Removing objects one at a
+ * time keeps their nodes around to be reused by later additions.
+ *
  *      Run-time: Theta(count) linear
  *
  *      @fn NILinkedList::removeAllObjects
@@ -494,3 +511,18 @@ typedef void NILinkedListLocation;
  *
  *      @fn NILinkedList::removeObjectAtLocation:
  */
+
+/**
+ * Moves the object at a predetermined location to the end of the linked list.
+ *
+ * The node is relinked in place: nothing is allocated or freed, the object is not retained or
+ * released again, and the location remains valid. This is what NIMemoryCache uses to mark an
+ * object as most recently used.
+ *
+ * The same caveats as removeObjectAtLocation: apply to the location.
+ *
+ *      Run-time: O(1) constant
+ *
+ *      @fn NILinkedList::moveObjectAtLocationToTail:
+ *      @param location  The location of the object to move.
+ */
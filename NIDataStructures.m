@@ -19,6 +19,16 @@
 #import "NIDebuggingTools.h"
 #import "NIPreprocessorMacros.h"
 
+// Slabs start small so that short lists stay cheap, and double until they reach the max.
+static const NSUInteger kMinSlabCapacity = 16;
+static const NSUInteger kMaxSlabCapacity = 512;
+
+struct NILinkedListSlab {
+  struct NILinkedListSlab* next;
+  NSUInteger capacity;
+  struct NILinkedListNode nodes[];
+};
+
 @interface NILinkedList()
 
 /**
@@ -167,10 +177,56 @@
 #pragma mark Private Methods
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (struct NILinkedListNode *)_allocateNode {
+  if (nil == _freeNodes) {
+    NSUInteger capacity = MAX(kMinSlabCapacity, _nextSlabCapacity);
+    _nextSlabCapacity = MIN(capacity * 2, kMaxSlabCapacity);
+
+    struct NILinkedListSlab* slab = malloc(sizeof(struct NILinkedListSlab)
+                                           + capacity * sizeof(struct NILinkedListNode));
+    slab->next = _slabs;
+    slab->capacity = capacity;
+    _slabs = slab;
+
+    // Thread the free list through the slab back to front so that nodes are handed out in
+    // address order, which keeps neighbours in the list next to each other in memory.
+    for (NSInteger ix = (NSInteger)capacity - 1; ix >= 0; --ix) {
+      slab->nodes[ix].next = _freeNodes;
+      _freeNodes = &slab->nodes[ix];
+    }
+  }
+
+  struct NILinkedListNode* node = _freeNodes;
+  _freeNodes = node->next;
+  memset(node, 0, sizeof(struct NILinkedListNode));
+  return node;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)_eraseNode:(struct NILinkedListNode *)node {
   [node->object release];
-  free(node);
+  node->object = nil;
+  node->prev = nil;
+
+  // The most recently freed node is reused first while it's still likely to be in the cache.
+  node->next = _freeNodes;
+  _freeNodes = node;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)_freeSlabs {
+  struct NILinkedListSlab* slab = _slabs;
+  while (nil != slab) {
+    struct NILinkedListSlab* next = slab->next;
+    free(slab);
+    slab = next;
+  }
+  _slabs = nil;
+  _freeNodes = nil;
+  _nextSlabCapacity = 0;
 }
 
 
@@ -396,6 +452,38 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)moveObjectAtLocationToTail:(NILinkedListLocation *)location {
+  if (0 == location) {
+    return;
+  }
+
+  struct NILinkedListNode* node = (struct NILinkedListNode *)location;
+
+  // Already the tail; nothing to relink.
+  if (node == _tail) {
+    return;
+  }
+
+  // Unlink. node is not the tail, so node->next is never nil here.
+  if (0 != node->prev) {
+    node->prev->next = node->next;
+
+  } else {
+    _head = node->next;
+  }
+  node->next->prev = node->prev;
+
+  // Relink at the tail.
+  node->prev = _tail;
+  node->next = nil;
+  _tail->next = node;
+  _tail = node;
+
+  ++_modificationNumber;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (NILinkedListLocation *)addObject:(id)object {
   // nil objects can not be added to a linked list.
@@ -404,8 +492,7 @@
     return nil;
   }
   
-  struct NILinkedListNode* node = malloc(sizeof(struct NILinkedListNode));
-  memset(node, 0, sizeof(struct NILinkedListNode));
+  struct NILinkedListNode* node = [self _allocateNode];
   
   node->object = [object retain];
   
@@ -446,9 +533,12 @@
   struct NILinkedListNode* node = _head;
   while (nil != node) {
     struct NILinkedListNode* next = (struct NILinkedListNode *)node->next;
-    [self _eraseNode:node];
+    [node->object release];
     node = next;
   }
+
+  // Give the memory back rather than keeping the list's high water mark around.
+  [self _freeSlabs];
   
   _head = nil;
   _tail = nil;
@@ -79,6 +79,27 @@
  *  NIMaxLogLevel = NILOGLEVEL_INFO;
  * @endcode
  *
+ *
+ * <h2>Tracing</h2>
+ *
+ * @code
+ *  NIDTRACEBEGIN("NIStripView.updateVisibleItems");
+ *  ...
+ *  NIDTRACEEND("NIStripView.updateVisibleItems");
+ * @endcode
+ *
+ * Records the start and end of a span of work on the current thread. Spans on one thread must
+ * nest. Work that starts on one thread and ends on another, like a download, is recorded with
+ * NIDTRACEASYNCBEGIN and NIDTRACEASYNCEND and an identifier shared by the two ends.
+ * NIDTRACEINSTANT records a single moment.
+ *
+ * Names must be C string literals; only the pointer is recorded.
+ *
+ * Unlike the other tools, tracing is enabled by defining NI_TRACING, so that it can be used in
+ * optimized builds. Without NI_TRACING the macros compile to nothing. With it, each event is
+ * a clock read and a write to a buffer owned by the current thread, with no locks. See
+ * NITracing.h for exporting the recorded events.
+ *
  *      @ingroup NimbusCore
  *      @defgroup Debugging-Tools Debugging Tools
  *      @{
@@ -183,6 +204,28 @@ xx, ##__VA_ARGS__)
 #define NIDINFO(xx, ...)  NIDCONDITIONLOG((NILOGLEVEL_INFO <= NIMaxLogLevel), xx, ##__VA_ARGS__)
 
 
+#ifdef NI_TRACING
+/**
+ * Records a trace event with a Chrome trace event phase on the current thread.
+ *
+ * Use the NIDTRACE macros rather than calling this directly.
+ */
+void NITraceRecordEvent(char phase, const char* name, const void* identifier);
+
+#define NIDTRACEBEGIN(name)                   NITraceRecordEvent('B', (name), NULL)
+#define NIDTRACEEND(name)                     NITraceRecordEvent('E', (name), NULL)
+#define NIDTRACEINSTANT(name)                 NITraceRecordEvent('i', (name), NULL)
+#define NIDTRACEASYNCBEGIN(name, identifier)  NITraceRecordEvent('b', (name), (identifier))
+#define NIDTRACEASYNCEND(name, identifier)    NITraceRecordEvent('e', (name), (identifier))
+#else
+#define NIDTRACEBEGIN(name)                   ((void)0)
+#define NIDTRACEEND(name)                     ((void)0)
+#define NIDTRACEINSTANT(name)                 ((void)0)
+#define NIDTRACEASYNCBEGIN(name, identifier)  ((void)0)
+#define NIDTRACEASYNCEND(name, identifier)    ((void)0)
+#endif // #ifdef NI_TRACING
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /**@}*/// End of Debugging Tools //////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -62,6 +62,14 @@ NSString* NIStringFromBytes(unsigned long long bytes);
  */
 + (unsigned long long)bytesOfTotalMemory;
 
+/**
+ * The number of bytes of memory used by this app that are resident in physical memory.
+ *
+ * This is the number the OS looks at when it decides which apps to warn and terminate.
+ * Always sampled directly, even while device info is being cached.
+ */
++ (unsigned long long)bytesOfResidentMemory;
+
 
 #pragma mark Disk Space /** @name Disk Space */
 
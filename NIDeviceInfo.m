@@ -131,6 +131,17 @@ NSString* NIStringFromBytes(unsigned long long bytes) {
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (unsigned long long)bytesOfResidentMemory {
+  struct task_basic_info info;
+  mach_msg_type_number_t size = TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &size) != KERN_SUCCESS) {
+    return 0;
+  }
+  return (unsigned long long)info.resident_size;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 + (unsigned long long)bytesOfFreeDiskSpace {
   if (!sIsCaching && ![self updateFileSystemAttributes]) {
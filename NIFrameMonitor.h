@@ -0,0 +1,190 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <QuartzCore/QuartzCore.h>
+
+/**
+ * For measuring how well the main thread keeps up with the display.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Core-Frame-Monitor Frame Monitor
+ * @{
+ *
+ * Scrolling looks smooth only while every frame is ready in time. The frame monitor records how
+ * long each frame took and counts the stalls, which are frames that kept the main thread busy
+ * past a threshold.
+ *
+ * Work that can stall a frame is marked with NIFrameMonitorBeginWork and
+ * NIFrameMonitorEndWork. When a frame stalls, the work that took the most of that frame gets
+ * the blame. NIStripView and the photo views mark their work this way.
+ *
+ * The Overview shows the frame monitor on its own page. Tap that page to copy the histogram.
+ */
+
+typedef enum {
+  NIFrameWorkOther,
+  NIFrameWorkUpdateVisibleItems,
+  NIFrameWorkItemViewForIndex,
+  NIFrameWorkWillDisplayItem,
+  NIFrameWorkSetImage,
+  NIFrameWorkDecode,
+  NIFrameWorkCount, // Not a kind of work.
+} NIFrameWork;
+
+// Bucket n of the histogram counts the frames that took n + 1 display refreshes. The last
+// bucket also counts every longer frame.
+enum {
+  NIFrameMonitorNumberOfBuckets = 8,
+  NIFrameMonitorNumberOfRecentFrames = 240,
+};
+
+/**
+ * Records frame durations and main thread stalls.
+ *
+ * Only one frame monitor may be monitoring at a time, and only from the main thread.
+ */
+@interface NIFrameMonitor : NSObject {
+@private
+  id                    _displayLink;
+  CFRunLoopObserverRef  _runLoopObserver;
+  CFTimeInterval        _frameStartTime;
+  CFTimeInterval        _stallThreshold;
+
+  NSUInteger      _numberOfFrames;
+  NSUInteger      _numberOfStalls;
+  CFTimeInterval  _longestFrameDuration;
+  NSUInteger      _histogram[NIFrameMonitorNumberOfBuckets];
+  NSUInteger      _numberOfStallsByWork[NIFrameWorkCount];
+
+  CFTimeInterval  _recentFrameDurations[NIFrameMonitorNumberOfRecentFrames];
+}
+
+- (void)startMonitoring;
+- (void)stopMonitoring;
+@property (nonatomic, readonly, assign, getter=isMonitoring) BOOL monitoring;
+
+@property (nonatomic, readwrite, assign) CFTimeInterval stallThreshold; // default: 0.05
+
+@property (nonatomic, readonly, assign) NSUInteger numberOfFrames;
+@property (nonatomic, readonly, assign) NSUInteger numberOfStalls;
+@property (nonatomic, readonly, assign) CFTimeInterval longestFrameDuration;
+- (NSUInteger)numberOfFramesInBucket:(NSUInteger)bucket;
+- (NSUInteger)numberOfStallsDuringWork:(NIFrameWork)work;
+
+- (NSUInteger)numberOfRecentFrames;
+- (CFTimeInterval)durationOfRecentFrameAtIndex:(NSUInteger)index;
+
+- (void)reset;
+- (NSString *)histogramDescription;
+
+@end
+
+NIFrameWork NIFrameMonitorBeginWork(NIFrameWork work);
+void NIFrameMonitorEndWork(NIFrameWork previousWork);
+NSString* NIStringFromFrameWork(NIFrameWork work);
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**@}*/// End of Frame Monitor ////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+/** @name Monitoring */
+
+/**
+ * Starts recording frames.
+ *
+ * Frames are timed with a CADisplayLink. Without one, each pass of the main run loop counts as
+ * a frame, and its duration is the time the pass spent working.
+ *
+ * The monitor is retained until stopMonitoring is called.
+ *
+ *      @fn NIFrameMonitor::startMonitoring
+ */
+
+/**
+ * The longest a frame may take before it counts as a stall, in seconds.
+ *
+ * The default is 50 milliseconds, three refreshes of a 60 Hz display.
+ *
+ *      @fn NIFrameMonitor::stallThreshold
+ */
+
+
+/** @name Reading the Results */
+
+/**
+ * The number of stalls that were blamed on the given work.
+ *
+ * A stall is blamed on NIFrameWorkOther when no marked work took most of the frame, for
+ * example when the time went to layout or to drawing.
+ *
+ *      @fn NIFrameMonitor::numberOfStallsDuringWork:
+ */
+
+/**
+ * The durations of the last NIFrameMonitorNumberOfRecentFrames frames, oldest first.
+ *
+ *      @fn NIFrameMonitor::durationOfRecentFrameAtIndex:
+ */
+
+/**
+ * The results as comma separated values, ready to paste into a spreadsheet.
+ *
+ * There are three tables: the totals, the histogram of frame durations, and the stalls for
+ * each kind of work.
+ *
+ *      @fn NIFrameMonitor::histogramDescription
+ */
+
+/**
+ * Forgets every frame recorded so far.
+ *
+ *      @fn NIFrameMonitor::reset
+ */
+
+
+/** @name Marking Work */
+
+/**
+ * Marks the start of work that may stall the frame.
+ *
+ * Returns the work that was in progress, which must be passed to the matching
+ * NIFrameMonitorEndWork. Work may be nested; the time spent in the inner work is not counted
+ * for the outer one. Both functions do nothing off the main thread or while no monitor is
+ * monitoring.
+ *
+ * @code
+ * NIFrameWork previousWork = NIFrameMonitorBeginWork(NIFrameWorkSetImage);
+ * ...
+ * NIFrameMonitorEndWork(previousWork);
+ * @endcode
+ *
+ *      @fn NIFrameMonitorBeginWork
+ */
+
+/**
+ * Marks the end of work started with NIFrameMonitorBeginWork.
+ *
+ *      @fn NIFrameMonitorEndWork
+ */
+
+/**
+ * A short name for the work, such as @"setImage".
+ *
+ *      @fn NIStringFromFrameWork
+ */
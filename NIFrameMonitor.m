@@ -0,0 +1,317 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIFrameMonitor.h"
+
+#import "NIDebuggingTools.h"
+#import "NIPreprocessorMacros.h"
+
+#import <pthread.h>
+
+static const CFTimeInterval kDefaultStallThreshold = 0.05;
+static const CFTimeInterval kRefreshInterval = 1.0 / 60.0;
+
+// The work in progress on the main thread. Only one monitor runs at a time, so this is shared.
+static NIFrameMonitor*  sMonitoringFrameMonitor = nil;
+static NIFrameWork      sCurrentWork = NIFrameWorkOther;
+static CFTimeInterval   sCurrentWorkStartTime = 0;
+static CFTimeInterval   sWorkDurations[NIFrameWorkCount];
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NIFrameWork NIFrameMonitorBeginWork(NIFrameWork work) {
+  if (nil == sMonitoringFrameMonitor || !pthread_main_np()) {
+    return NIFrameWorkOther;
+  }
+  CFTimeInterval now = CACurrentMediaTime();
+  NIFrameWork previousWork = sCurrentWork;
+  sWorkDurations[previousWork] += now - sCurrentWorkStartTime;
+  sCurrentWork = work;
+  sCurrentWorkStartTime = now;
+  return previousWork;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NIFrameMonitorEndWork(NIFrameWork previousWork) {
+  if (nil == sMonitoringFrameMonitor || !pthread_main_np()) {
+    return;
+  }
+  CFTimeInterval now = CACurrentMediaTime();
+  sWorkDurations[sCurrentWork] += now - sCurrentWorkStartTime;
+  sCurrentWork = previousWork;
+  sCurrentWorkStartTime = now;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSString* NIStringFromFrameWork(NIFrameWork work) {
+  switch (work) {
+    case NIFrameWorkUpdateVisibleItems:
+      return @"updateVisibleItems";
+    case NIFrameWorkItemViewForIndex:
+      return @"itemViewForIndex";
+    case NIFrameWorkWillDisplayItem:
+      return @"willDisplayItem";
+    case NIFrameWorkSetImage:
+      return @"setImage";
+    case NIFrameWorkDecode:
+      return @"decode";
+    default:
+      return @"other";
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Returns the work that took the most of the frame so far and starts counting a new frame.
+static NIFrameWork NIFrameMonitorTakeSlowestWork(CFTimeInterval now) {
+  sWorkDurations[sCurrentWork] += now - sCurrentWorkStartTime;
+  sCurrentWorkStartTime = now;
+
+  NIFrameWork slowestWork = NIFrameWorkOther;
+  for (NSInteger work = 0; work < NIFrameWorkCount; ++work) {
+    if (sWorkDurations[work] > sWorkDurations[slowestWork]) {
+      slowestWork = (NIFrameWork)work;
+    }
+    sWorkDurations[work] = 0;
+  }
+  return slowestWork;
+}
+
+
+@interface NIFrameMonitor()
+- (void)beginFrameAtTime:(CFTimeInterval)time;
+- (void)endFrameAtTime:(CFTimeInterval)time;
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIFrameMonitorRunLoopObserverCallBack(CFRunLoopObserverRef observer,
+                                                  CFRunLoopActivity activity,
+                                                  void* info) {
+  NIFrameMonitor* frameMonitor = (NIFrameMonitor *)info;
+  if (kCFRunLoopAfterWaiting == activity) {
+    [frameMonitor beginFrameAtTime:CACurrentMediaTime()];
+
+  } else {
+    [frameMonitor endFrameAtTime:CACurrentMediaTime()];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIFrameMonitor
+
+@synthesize stallThreshold = _stallThreshold;
+@synthesize numberOfFrames = _numberOfFrames;
+@synthesize numberOfStalls = _numberOfStalls;
+@synthesize longestFrameDuration = _longestFrameDuration;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [self stopMonitoring];
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    _stallThreshold = kDefaultStallThreshold;
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Monitoring
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)isMonitoring {
+  return self == sMonitoringFrameMonitor;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)startMonitoring {
+  NIDASSERT([NSThread isMainThread]);
+  NIDASSERT(nil == sMonitoringFrameMonitor || self == sMonitoringFrameMonitor);
+  if (nil != sMonitoringFrameMonitor) {
+    return;
+  }
+
+  // Retained until stopMonitoring.
+  sMonitoringFrameMonitor = [self retain];
+  sCurrentWork = NIFrameWorkOther;
+  [self beginFrameAtTime:CACurrentMediaTime()];
+
+  Class displayLinkClass = NSClassFromString(@"CADisplayLink");
+  if (nil != displayLinkClass) {
+    _displayLink = [[displayLinkClass displayLinkWithTarget: self
+                                                   selector: @selector(displayLinkDidFire:)]
+                    retain];
+    [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+
+  } else {
+    CFRunLoopObserverContext context = { 0, self, NULL, NULL, NULL };
+    _runLoopObserver = CFRunLoopObserverCreate(kCFAllocatorDefault,
+                                               kCFRunLoopAfterWaiting | kCFRunLoopBeforeWaiting,
+                                               YES, 0,
+                                               NIFrameMonitorRunLoopObserverCallBack,
+                                               &context);
+    CFRunLoopAddObserver(CFRunLoopGetMain(), _runLoopObserver, kCFRunLoopCommonModes);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)stopMonitoring {
+  if (self != sMonitoringFrameMonitor) {
+    return;
+  }
+
+  [_displayLink invalidate];
+  NI_RELEASE_SAFELY(_displayLink);
+
+  if (nil != _runLoopObserver) {
+    CFRunLoopObserverInvalidate(_runLoopObserver);
+    CFRelease(_runLoopObserver);
+    _runLoopObserver = nil;
+  }
+
+  sMonitoringFrameMonitor = nil;
+  [self autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink {
+  // Each refresh ends one frame and begins the next.
+  [self endFrameAtTime:displayLink.timestamp];
+  [self beginFrameAtTime:displayLink.timestamp];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)beginFrameAtTime:(CFTimeInterval)time {
+  _frameStartTime = time;
+
+  // Work done between frames doesn't count against the next one.
+  NIFrameMonitorTakeSlowestWork(time);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)endFrameAtTime:(CFTimeInterval)time {
+  CFTimeInterval duration = time - _frameStartTime;
+
+  NIFrameWork slowestWork = NIFrameMonitorTakeSlowestWork(time);
+  if (duration > _stallThreshold) {
+    _numberOfStalls++;
+    _numberOfStallsByWork[slowestWork]++;
+  }
+
+  NSInteger bucket = (NSInteger)floor(duration / kRefreshInterval + 0.5) - 1;
+  bucket = MAX(0, MIN(bucket, NIFrameMonitorNumberOfBuckets - 1));
+  _histogram[bucket]++;
+
+  _recentFrameDurations[_numberOfFrames % NIFrameMonitorNumberOfRecentFrames] = duration;
+  _numberOfFrames++;
+  _longestFrameDuration = MAX(_longestFrameDuration, duration);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Results
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)numberOfFramesInBucket:(NSUInteger)bucket {
+  NIDASSERT(bucket < NIFrameMonitorNumberOfBuckets);
+  return (bucket < NIFrameMonitorNumberOfBuckets) ? _histogram[bucket] : 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)numberOfStallsDuringWork:(NIFrameWork)work {
+  NIDASSERT(work < NIFrameWorkCount);
+  return (work < NIFrameWorkCount) ? _numberOfStallsByWork[work] : 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)numberOfRecentFrames {
+  return MIN(_numberOfFrames, (NSUInteger)NIFrameMonitorNumberOfRecentFrames);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CFTimeInterval)durationOfRecentFrameAtIndex:(NSUInteger)index {
+  NSUInteger numberOfRecentFrames = [self numberOfRecentFrames];
+  NIDASSERT(index < numberOfRecentFrames);
+  NSUInteger frameIndex = _numberOfFrames - numberOfRecentFrames + index;
+  return _recentFrameDurations[frameIndex % NIFrameMonitorNumberOfRecentFrames];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reset {
+  _numberOfFrames = 0;
+  _numberOfStalls = 0;
+  _longestFrameDuration = 0;
+  memset(_histogram, 0, sizeof(_histogram));
+  memset(_numberOfStallsByWork, 0, sizeof(_numberOfStallsByWork));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSString *)histogramDescription {
+  NSMutableString* description = [NSMutableString string];
+
+  [description appendString:@"frames,stalls,longest frame (ms)\n"];
+  [description appendFormat:@"%lu,%lu,%.1f\n",
+   (unsigned long)_numberOfFrames, (unsigned long)_numberOfStalls,
+   _longestFrameDuration * 1000];
+
+  [description appendString:@"\nframe duration (ms),frames\n"];
+  for (NSUInteger bucket = 0; bucket < NIFrameMonitorNumberOfBuckets; ++bucket) {
+    BOOL isLastBucket = (bucket == NIFrameMonitorNumberOfBuckets - 1);
+    [description appendFormat:@"%@%.1f,%lu\n",
+     isLastBucket ? @">=" : @"", (bucket + 1) * kRefreshInterval * 1000,
+     (unsigned long)_histogram[bucket]];
+  }
+
+  [description appendString:@"\nwork,stalls\n"];
+  for (NSInteger work = 0; work < NIFrameWorkCount; ++work) {
+    [description appendFormat:@"%@,%lu\n",
+     NIStringFromFrameWork((NIFrameWork)work), (unsigned long)_numberOfStallsByWork[work]];
+  }
+
+  return description;
+}
+
+
+@end
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#import "NIMemoryGovernor.h"
+
 /**
  * For storing and accessing objects in memory.
  *
@@ -28,6 +30,35 @@
  */
 
 @class NILinkedList;
+@class NIMemoryCacheExpirationWheel;
+@protocol NIMemoryCacheEvictionPolicy;
+
+/**
+ * Why an object left a cache.
+ */
+typedef enum {
+  NIMemoryCacheRemovalReasonExplicit,       // Removed by name, by a batch removal, or cleared.
+  NIMemoryCacheRemovalReasonExpired,        // Its expiration date passed.
+  NIMemoryCacheRemovalReasonCapacity,       // Evicted to stay within the cache's limits.
+  NIMemoryCacheRemovalReasonMemoryPressure, // Evicted by reduceMemoryUsage or the memory governor.
+  NIMemoryCacheNumberOfRemovalReasons,
+} NIMemoryCacheRemovalReason;
+
+/**
+ * Counters kept by every NIMemoryCache since it was created or its statistics were reset.
+ */
+typedef struct {
+  unsigned long long numberOfHits;
+  unsigned long long numberOfMisses;
+  unsigned long long numberOfInsertions;
+  unsigned long long numberOfReplacements;
+  unsigned long long numberOfRemovals[NIMemoryCacheNumberOfRemovalReasons];
+  unsigned long long numberOfBytesRemoved[NIMemoryCacheNumberOfRemovalReasons];
+
+  // Not counters. The state of the cache when the statistics were taken.
+  unsigned long long numberOfBytes;
+  NSUInteger count;
+} NIMemoryCacheStatistics;
 
 /**
  * An in-memory cache for storing objects with expiration support.
@@ -35,13 +66,22 @@
  * The Nimbus in-memory object cache allows you to store objects in memory with an expiration
  * date attached. Objects with expiration dates drop out of the cache when they have expired.
  */
-@interface NIMemoryCache : NSObject {
+@interface NIMemoryCache : NSObject <NIMemoryGovernedObject> {
 @private
   // Mapping from a name (usually a URL) to an internal object.
   NSMutableDictionary*  _cacheMap;
 
   // A linked list of least recently used cache objects. Most recently used is the tail.
   NILinkedList*         _lruCacheObjects;
+
+  id<NIMemoryCacheEvictionPolicy> _evictionPolicy;
+
+  // Schedules objects with expiration dates so that they can be reclaimed without a full scan.
+  NIMemoryCacheExpirationWheel* _expirationWheel;
+
+  NSUInteger _batchUpdateDepth;
+
+  NIMemoryCacheStatistics _statistics;
 }
 
 // Designated initializer.
@@ -52,10 +92,15 @@
 - (void)storeObject:(id)object withName:(NSString *)name;
 - (void)storeObject:(id)object withName:(NSString *)name expiresAfter:(NSDate *)expirationDate;
 
+- (void)storeObjects:(NSArray *)objects withNames:(NSArray *)names;
+
 - (void)removeObjectWithName:(NSString *)name;
+- (void)removeObjectsWithNamePrefix:(NSString *)prefix;
+- (void)removeObjectsPassingTest:(BOOL (^)(NSString* name, id object))predicate;
 - (void)removeAllObjects;
 
 - (id)objectWithName:(NSString *)name;
+- (id)peekObjectWithName:(NSString *)name;
 - (BOOL)containsObjectWithName:(NSString *)name;
 - (NSDate *)dateOfLastAccessWithName:(NSString *)name;
 
@@ -63,14 +108,27 @@
 - (NSString *)nameOfMostRecentlyUsedObject;
 
 - (void)reduceMemoryUsage;
+- (unsigned long long)memoryCost;
+- (void)reduceMemoryCostTo:(unsigned long long)memoryCost;
+
+@property (nonatomic, readwrite, retain) id<NIMemoryCacheEvictionPolicy> evictionPolicy;
+
+- (NIMemoryCacheStatistics)statistics;
+- (void)resetStatistics;
 
 
 // Subclassing
 
+- (NSString *)nameOfObjectToEvict;
+- (void)removeObjectWithName:(NSString *)name reason:(NIMemoryCacheRemovalReason)reason;
+
 - (BOOL)willSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject;
 - (void)didSetObject:(id)object withName:(NSString *)name;
 - (void)willRemoveObject:(id)object withName:(NSString *)name;
 
+- (BOOL)isPerformingBatchUpdate;
+- (void)didEndBatchUpdate;
+
 @end
 
 
@@ -87,6 +145,9 @@
  * By default the image memory cache has no limit to its pixel count. You must explicitly
  * set this value in your application.
  *
+ * Limits may also be given in bytes with maxNumberOfBytes, which accounts for the actual size
+ * of each image's decoded bitmap.
+ *
  *      @attention If the cache is too small to fit the newly added image, then all images
  *                 will end up being removed including the one being added.
  *
@@ -99,15 +160,66 @@
 
   NSUInteger _maxNumberOfPixels;
   NSUInteger _maxNumberOfPixelsUnderStress;
+
+  NSUInteger _numberOfBytes;
+
+  NSUInteger _maxNumberOfBytes;
+  NSUInteger _maxNumberOfBytesUnderStress;
 }
 
 @property (nonatomic, readonly, assign) NSUInteger numberOfPixels;
 @property (nonatomic, readwrite, assign) NSUInteger maxNumberOfPixels;
 @property (nonatomic, readwrite, assign) NSUInteger maxNumberOfPixelsUnderStress;
 
+@property (nonatomic, readonly, assign) NSUInteger numberOfBytes;
+@property (nonatomic, readwrite, assign) NSUInteger maxNumberOfBytes;
+@property (nonatomic, readwrite, assign) NSUInteger maxNumberOfBytesUnderStress;
+
 @end
 
 
+/**
+ * An in-memory cache for storing data with caps on the total number of bytes.
+ *
+ * Meant for keeping the compressed bytes of images, such as the JPEG or PNG data of a network
+ * response, after the decoded image has been evicted from an NIImageMemoryCache. Decoding
+ * the image again from memory takes milliseconds, where downloading it again takes seconds,
+ * and compressed images are a fraction of the size of their bitmaps.
+ *
+ * When data is added to the cache that takes it past maxNumberOfBytes, objects are removed,
+ * least recently used first unless an eviction policy says otherwise, until it fits again.
+ */
+@interface NIDataMemoryCache : NIMemoryCache {
+@private
+  NSUInteger _numberOfBytes;
+
+  NSUInteger _maxNumberOfBytes;
+  NSUInteger _maxNumberOfBytesUnderStress;
+}
+
+@property (nonatomic, readonly, assign) NSUInteger numberOfBytes;
+@property (nonatomic, readwrite, assign) NSUInteger maxNumberOfBytes;
+@property (nonatomic, readwrite, assign) NSUInteger maxNumberOfBytesUnderStress;
+
+@end
+
+
+/**
+ * Adds the counters of two sets of statistics, and their numberOfBytes and count.
+ */
+NIMemoryCacheStatistics NIMemoryCacheStatisticsAdd(NIMemoryCacheStatistics statistics1,
+                                                   NIMemoryCacheStatistics statistics2);
+
+/**
+ * A property list of the statistics, suitable for writing to a file or logging.
+ *
+ * The keys are the names of the fields. Removals are broken down by reason under the
+ * "removals" and "bytesRemoved" keys, keyed "explicit", "expired", "capacity" and
+ * "memoryPressure". "hitRatio" is included for convenience.
+ */
+NSDictionary* NIDictionaryFromMemoryCacheStatistics(NIMemoryCacheStatistics statistics);
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /**@}*/// End of In-Memory Cache //////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -143,12 +255,28 @@
  * not be stored in the cache and any existing object will be removed. The rationale behind this
  * is that the object would be removed from the cache the next time it was accessed anyway.
  *
+ * Expiration dates are kept to the second, rounded up. Expired objects are also reclaimed
+ * without being accessed: each store and each call to reduceMemoryUsage removes the objects
+ * that have expired since the last time, without looking at the objects that haven't.
+ *
  *      @param object          The object being stored in the cache.
  *      @param name            The name used as a key to store this object.
  *      @param expirationDate  A date after which this object is no longer valid in the cache.
  *      @fn NIMemoryCache::storeObject:withName:expiresAfter:
  */
 
+/**
+ * Stores many objects in the cache at once, without expiration dates.
+ *
+ * Each object is stored with the name at the same index. Expired objects are reclaimed once
+ * for the whole batch, and subclasses that evict to stay within a limit do so once, after the
+ * last object has been stored. Use this when restoring a cache from a snapshot.
+ *
+ *      @param objects  The objects being stored in the cache.
+ *      @param names    The names used as keys to store the objects. Must be as many as objects.
+ *      @fn NIMemoryCache::storeObjects:withNames:
+ */
+
 
 /** @name Removing Objects from the Cache */
 
@@ -159,6 +287,23 @@
  *      @fn NIMemoryCache::removeObjectWithName:
  */
 
+/**
+ * Removes every object whose name begins with the given prefix.
+ *
+ * Handy when names are namespaced, for example by album, and a whole namespace goes away.
+ *
+ *      @fn NIMemoryCache::removeObjectsWithNamePrefix:
+ */
+
+/**
+ * Removes every object for which predicate returns YES.
+ *
+ * The predicate is called once for each object in the cache, expired or not, and must not
+ * modify the cache. Matching objects are removed as one batch.
+ *
+ *      @fn NIMemoryCache::removeObjectsPassingTest:
+ */
+
 /**
  * Removes all objects from the cache, regardless of expiration dates.
  *
@@ -181,6 +326,20 @@
  *      @fn NIMemoryCache::objectWithName:
  */
 
+/**
+ * Retrieves an object from the cache without counting it as a use of the object.
+ *
+ * Unlike objectWithName:, this does not update the access time, does not tell the eviction
+ * policy, and is not counted as a hit or a miss. Use it to check what is already in memory
+ * without making an object look popular, for example while the user scrubs past photos.
+ *
+ * If the object has expired then the object will be removed from the cache and nil will be
+ * returned.
+ *
+ *      @returns The object stored in the cache, retained and autoreleased.
+ *      @fn NIMemoryCache::peekObjectWithName:
+ */
+
 /**
  * Returns a Boolean value that indicates whether an object with the given name is present
  * in the cache.
@@ -237,12 +396,62 @@
  * Subclasses may add additional functionality to this implementation.
  * Subclasses should call super in order to prune expired objects.
  *
- * This will be called when <code>UIApplicationDidReceiveMemoryWarningNotification</code>
- * is posted.
+ * This will be called by Nimbus::memoryGovernor at the hard and critical pressure levels,
+ * including when <code>UIApplicationDidReceiveMemoryWarningNotification</code> is posted.
  *
  *      @fn NIMemoryCache::reduceMemoryUsage
  */
 
+/**
+ * The number of bytes held by the cache, as seen by the memory governor.
+ *
+ * NIMemoryCache can't measure arbitrary objects and returns 0. NIImageMemoryCache and
+ * NIDataMemoryCache return their numberOfBytes.
+ *
+ *      @fn NIMemoryCache::memoryCost
+ */
+
+/**
+ * Evicts objects, in the order nameOfObjectToEvict gives them, until memoryCost is at most the
+ * given number of bytes.
+ *
+ *      @fn NIMemoryCache::reduceMemoryCostTo:
+ */
+
+
+/** @name Choosing What to Evict */
+
+/**
+ * The policy that decides which object is evicted when a subclass needs to make room.
+ *
+ * Defaults to nil, in which case the least recently used object is evicted. Setting a policy
+ * tells it about every object already in the cache, oldest first. A policy must only be
+ * attached to one cache at a time.
+ *
+ *      @see NIWTinyLFUEvictionPolicy
+ *      @fn NIMemoryCache::evictionPolicy
+ */
+
+
+/** @name Measuring an In-Memory Cache */
+
+/**
+ * A snapshot of the cache's counters, along with its current count and memoryCost.
+ *
+ * Hits and misses are counted by objectWithName:, where an expired object counts as a miss.
+ * Bytes removed are measured with memoryCost, so they stay at 0 for caches that can't measure
+ * their objects.
+ *
+ *      @see NIDictionaryFromMemoryCacheStatistics
+ *      @fn NIMemoryCache::statistics
+ */
+
+/**
+ * Sets every counter back to zero.
+ *
+ *      @fn NIMemoryCache::resetStatistics
+ */
+
 
 /** @name Querying an In-Memory Cache */
 
@@ -261,6 +470,24 @@
  * used externally.
  */
 
+/**
+ * The name of the object that should be removed next to make room in the cache.
+ *
+ * Asks the eviction policy if there is one, otherwise returns the name of the least recently
+ * used object. Does not remove expired objects. Returns nil if the cache is empty.
+ *
+ *      @fn NIMemoryCache::nameOfObjectToEvict
+ */
+
+/**
+ * Removes an object and counts its removal under the given reason.
+ *
+ * For evicting on the cache's behalf, as NIConcurrentMemoryCache does with its shards.
+ * removeObjectWithName: counts as NIMemoryCacheRemovalReasonExplicit.
+ *
+ *      @fn NIMemoryCache::removeObjectWithName:reason:
+ */
+
 /**
  * An object is about to be stored in the cache.
  *
@@ -288,6 +515,23 @@
  *      @fn NIMemoryCache::willRemoveObject:withName:
  */
 
+/**
+ * Whether the cache is in the middle of a batch store or removal.
+ *
+ * The per-object hooks are still called during a batch. Subclasses can use this to put off
+ * work that only needs doing once, such as eviction, until didEndBatchUpdate.
+ *
+ *      @fn NIMemoryCache::isPerformingBatchUpdate
+ */
+
+/**
+ * A batch store or removal has finished.
+ *
+ * NIImageMemoryCache evicts objects here to get back under its limits.
+ *
+ *      @fn NIMemoryCache::didEndBatchUpdate
+ */
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // NIImageMemoryCache
@@ -297,10 +541,23 @@
 /**
  * Returns the total number of pixels being stored in the cache.
  *
+ * Image sizes are in points, so an image's pixel count is its width and height each
+ * multiplied by its scale.
+ *
  *      @returns The total number of pixels being stored in the cache.
  *      @fn NIImageMemoryCache::numberOfPixels
  */
 
+/**
+ * Returns the total number of bytes used by the bitmaps of the images in the cache.
+ *
+ * An image is counted as the bitmap it decodes into, including row padding, whether or not it
+ * has been drawn yet.
+ *
+ *      @returns The total number of bytes used by the images stored in the cache.
+ *      @fn NIImageMemoryCache::numberOfBytes
+ */
+
 
 /** @name Setting the Maximum Number of Pixels */
 
@@ -322,3 +579,55 @@
  *               to reduceMemoryUsage.
  *      @fn NIImageMemoryCache::maxNumberOfPixelsUnderStress
  */
+
+
+/** @name Setting the Maximum Number of Bytes */
+
+/**
+ * The maximum number of bytes this cache may ever store.
+ *
+ * Applies alongside maxNumberOfPixels; images are removed until both limits are met.
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ *      @fn NIImageMemoryCache::maxNumberOfBytes
+ */
+
+/**
+ * The maximum number of bytes this cache may store after a call to reduceMemoryUsage.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ *      @fn NIImageMemoryCache::maxNumberOfBytesUnderStress
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// NIDataMemoryCache
+
+/** @name Querying an In-Memory Data Cache */
+
+/**
+ * Returns the total length of the data stored in the cache.
+ *
+ *      @fn NIDataMemoryCache::numberOfBytes
+ */
+
+
+/** @name Setting the Maximum Number of Bytes */
+
+/**
+ * The maximum number of bytes this cache may ever store.
+ *
+ * Lowering the limit trims the cache right away.
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ *      @fn NIDataMemoryCache::maxNumberOfBytes
+ */
+
+/**
+ * The maximum number of bytes this cache may store after a call to reduceMemoryUsage.
+ *
+ * Defaults to 0, which is special cased to represent an unlimited number of bytes.
+ *
+ *      @fn NIDataMemoryCache::maxNumberOfBytesUnderStress
+ */
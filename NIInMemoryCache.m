@@ -18,9 +18,48 @@
 
 #import "NIDataStructures.h"
 #import "NIDebuggingTools.h"
+#import "NIMemoryCacheEvictionPolicy.h"
 #import "NIPreprocessorMacros.h"
+#import "NIState.h"
 
 #import <UIKit/UIKit.h>
+#import <mach/mach_time.h>
+
+@class NIMemoryCacheInfo;
+
+// A timing wheel of four levels of 64 slots each. With one second ticks the levels cover about
+// a minute, an hour, three days and half a year.
+enum {
+  NIExpirationWheelBitsPerLevel = 6,
+  NIExpirationWheelSlotsPerLevel = 1 << NIExpirationWheelBitsPerLevel,
+  NIExpirationWheelSlotMask = NIExpirationWheelSlotsPerLevel - 1,
+  NIExpirationWheelNumberOfLevels = 4,
+  NIExpirationWheelNumberOfSlots = NIExpirationWheelNumberOfLevels * NIExpirationWheelSlotsPerLevel,
+};
+
+/**
+ * @brief Tracks when cache entries expire so that they can be reclaimed without a full scan.
+ *
+ * Entries are linked into slots through pointers stored in the entries themselves, so
+ * scheduling and unscheduling an entry never allocates. Entries are not retained.
+ */
+@interface NIMemoryCacheExpirationWheel : NSObject {
+@private
+  NIMemoryCacheInfo*  _slots[NIExpirationWheelNumberOfSlots];
+  uint64_t            _currentTick;
+  NSUInteger          _count;
+}
+
+- (id)initWithTick:(uint64_t)tick;
+
+- (void)scheduleInfo:(NIMemoryCacheInfo *)info;
+- (void)unscheduleInfo:(NIMemoryCacheInfo *)info;
+- (void)unscheduleAllInfos;
+
+// Returns the entries that expired on the way to tick, or nil if none did.
+- (NSArray *)advanceToTick:(uint64_t)tick;
+
+@end
 
 @interface NIMemoryCache()
 @property (nonatomic, readwrite, retain) NSMutableDictionary* cacheMap;
@@ -28,6 +67,46 @@
 @end
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Expiration uses coarse ticks of whole seconds of wall-clock time, read without allocating a
+// date. Wall-clock time keeps counting while the device sleeps, which max-age style expiration
+// needs. The wheel itself never moves backwards if the clock does.
+static uint64_t NIMemoryCacheExpirationTick(void) {
+  CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+  return (now > 0) ? (uint64_t)now : 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static uint64_t NIMemoryCacheExpirationTickForDate(NSDate* date) {
+  CFAbsoluteTime expiration = [date timeIntervalSinceReferenceDate];
+
+  // Round up so that an object never expires early.
+  uint64_t tick = (expiration > 0) ? (uint64_t)ceil(expiration) : 0;
+  return MAX(tick, 1);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Access times are kept as mach_absolute_time() ticks so that touching a cache entry never
+// allocates. They are only turned into NSDates when someone asks for one.
+static uint64_t NIMemoryCacheTick(void) {
+  return mach_absolute_time();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static NSDate* NIMemoryCacheDateForTick(uint64_t tick) {
+  static mach_timebase_info_data_t timebase;
+  if (0 == timebase.denom) {
+    mach_timebase_info(&timebase);
+  }
+  uint64_t elapsedTicks = mach_absolute_time() - tick;
+  NSTimeInterval elapsed = ((double)elapsedTicks * timebase.numer / timebase.denom) / NSEC_PER_SEC;
+  return [NSDate dateWithTimeIntervalSinceNow:-elapsed];
+}
+
+
 /**
  * @brief A single cache item's information.
  *
@@ -37,11 +116,15 @@
 @private
   NSString* _name;
   id        _object;
-  NSDate*   _expirationDate;
-  NSDate*   _lastAccessTime;
+  uint64_t  _expirationTick;
+  uint64_t  _lastAccessTick;
 
   // Keep tabs on the location of the lru object so that we can move it quickly.
   NILinkedListLocation* _lruLocation;
+
+  NIMemoryCacheInfo*    _wheelPrevious;
+  NIMemoryCacheInfo*    _wheelNext;
+  NSUInteger            _wheelSlot;
 }
 
 /**
@@ -55,25 +138,39 @@
 @property (nonatomic, readwrite, retain) id object;
 
 /**
- * @brief The date after which the image is no longer valid and should be removed from the cache.
+ * @brief The expiration tick at which the object is no longer valid and should be removed from
+ *        the cache, or 0 if it never expires.
  */
-@property (nonatomic, readwrite, retain) NSDate* expirationDate;
+@property (nonatomic, readwrite, assign) uint64_t expirationTick;
+
+/**
+ * @brief The last time this image was accessed, in mach_absolute_time() ticks.
+ *
+ * This property is updated every time the image is fetched from or stored into the cache.
+ */
+@property (nonatomic, readwrite, assign) uint64_t lastAccessTick;
 
 /**
  * @brief The last time this image was accessed.
  *
- * This property is updated every time the image is fetched from or stored into the cache. It
- * is used when the memory peak has been reached as a fast means of removing least-recently-used
- * images. When the memory limit is reached, we sort the cache based on the last access times and
- * then prune images until we're under the memory limit again.
+ * Computed from lastAccessTick, so this allocates a new date on every call.
  */
-@property (nonatomic, readwrite, retain) NSDate* lastAccessTime;
+@property (nonatomic, readonly) NSDate* lastAccessTime;
 
 /**
  * @brief The location of this object in the least-recently used linked list.
  */
 @property (nonatomic, readwrite, assign) NILinkedListLocation* lruLocation;
 
+/**
+ * @brief The links and slot of this object in the expiration wheel.
+ *
+ * wheelSlot is NSNotFound while the object is not scheduled.
+ */
+@property (nonatomic, readwrite, assign) NIMemoryCacheInfo* wheelPrevious;
+@property (nonatomic, readwrite, assign) NIMemoryCacheInfo* wheelNext;
+@property (nonatomic, readwrite, assign) NSUInteger wheelSlot;
+
 /**
  * @brief Determine whether this cache entry has past its expiration date.
  *
@@ -93,14 +190,17 @@
 
 @synthesize cacheMap        = _cacheMap;
 @synthesize lruCacheObjects = _lruCacheObjects;
+@synthesize evictionPolicy  = _evictionPolicy;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)dealloc {
-  [[NSNotificationCenter defaultCenter] removeObserver:self];
+  [[Nimbus memoryGovernor] unregisterObject:self];
 
   NI_RELEASE_SAFELY(_cacheMap);
   NI_RELEASE_SAFELY(_lruCacheObjects);
+  NI_RELEASE_SAFELY(_evictionPolicy);
+  NI_RELEASE_SAFELY(_expirationWheel);
 
   [super dealloc];
 }
@@ -117,12 +217,10 @@
   if ((self = [super init])) {
     _cacheMap = [[NSMutableDictionary alloc] initWithCapacity:capacity];
     _lruCacheObjects = [[NILinkedList alloc] init];
+    _expirationWheel = [[NIMemoryCacheExpirationWheel alloc] initWithTick:NIMemoryCacheExpirationTick()];
 
-    // Automatically reduce memory usage when we get a memory warning.
-    [[NSNotificationCenter defaultCenter] addObserver: self
-                                             selector: @selector(reduceMemoryUsage)
-                                                 name: UIApplicationDidReceiveMemoryWarningNotification
-                                               object: nil];
+    // The governor reduces our memory usage under memory pressure and on memory warnings.
+    [[Nimbus memoryGovernor] registerObject:self withPriority:NIMemoryPriorityNormal];
   }
   return self;
 }
@@ -140,10 +238,15 @@
   if (nil == info) {
     return; // COV_NF_LINE
   }
-  info.lastAccessTime = [NSDate date];
+  info.lastAccessTick = NIMemoryCacheTick();
 
-  [self.lruCacheObjects removeObjectAtLocation:info.lruLocation];
-  info.lruLocation = [self.lruCacheObjects addObject:info];
+  // A cache hit relinks the existing node in place, so touching an object never allocates.
+  if (nil == info.lruLocation) {
+    info.lruLocation = [self.lruCacheObjects addObject:info];
+
+  } else {
+    [self.lruCacheObjects moveObjectAtLocationToTail:info.lruLocation];
+  }
 }
 
 
@@ -154,36 +257,116 @@
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)setCacheInfo:(NIMemoryCacheInfo *)info forName:(NSString *)name {
-  NIDASSERT(nil != name);
-  if (nil == name) {
-    return;
-  }
-
+- (void)setCacheInfo:(NIMemoryCacheInfo *)info forName:(NSString *)name isReplacement:(BOOL)isReplacement {
   // Storing in the cache counts as an access of the object, so we update the access time.
   [self updateAccessTimeForInfo:info];
 
-  if ([self willSetObject:info.object
-                 withName:name
-           previousObject:[self cacheInfoForName:name].object]) {
-    [self.cacheMap setObject:info forKey:name];
+  [self.cacheMap setObject:info forKey:name];
+
+  [_expirationWheel unscheduleInfo:info];
+  if (0 != info.expirationTick) {
+    [_expirationWheel scheduleInfo:info];
+  }
+
+  // The policy has to know about the object before didSetObject: gets a chance to evict.
+  if (isReplacement) {
+    [_evictionPolicy didAccessObjectWithName:name];
+    ++_statistics.numberOfReplacements;
 
-    [self didSetObject:info.object
-              withName:name];
+  } else {
+    [_evictionPolicy didInsertObjectWithName:name];
+    ++_statistics.numberOfInsertions;
   }
+
+  [self didSetObject:info.object
+            withName:name];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)detachCacheInfo:(NIMemoryCacheInfo *)info withName:(NSString *)name {
+  [self willRemoveObject:info.object withName:name];
+  [_evictionPolicy didRemoveObjectWithName:name];
+  [_expirationWheel unscheduleInfo:info];
+
+  // The lru list retains the info as well, so the map's reference keeps it alive until the end.
+  [self.lruCacheObjects removeObjectAtLocation:info.lruLocation];
+  info.lruLocation = nil;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)removeCacheInfoForName:(NSString *)name {
+- (void)didRemoveObjects:(NSUInteger)numberOfObjects
+           numberOfBytes:(unsigned long long)numberOfBytes
+                  reason:(NIMemoryCacheRemovalReason)reason {
+  _statistics.numberOfRemovals[reason] += numberOfObjects;
+  _statistics.numberOfBytesRemoved[reason] += numberOfBytes;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeCacheInfoForName:(NSString *)name reason:(NIMemoryCacheRemovalReason)reason {
   NIDASSERT(nil != name);
   if (nil == name) {
     return;
   }
 
-  [self willRemoveObject:[self cacheInfoForName:name].object withName:name];
+  NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+  if (nil == info) {
+    return;
+  }
+  unsigned long long memoryCost = [self memoryCost];
+  [self detachCacheInfo:info withName:name];
 
   [self.cacheMap removeObjectForKey:name];
+
+  // Subclasses account for the object in willRemoveObject:, so the difference is its size.
+  unsigned long long remainingMemoryCost = [self memoryCost];
+  [self didRemoveObjects: 1
+           numberOfBytes: (memoryCost > remainingMemoryCost) ? memoryCost - remainingMemoryCost : 0
+                  reason: reason];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeCacheInfosForNames:(NSArray *)names {
+  if (0 == [names count]) {
+    return;
+  }
+
+  [self beginBatchUpdate];
+  unsigned long long memoryCost = [self memoryCost];
+  NSUInteger count = [self count];
+  for (NSString* name in names) {
+    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+    if (nil != info) {
+      [self detachCacheInfo:info withName:name];
+    }
+  }
+
+  // The map drops the whole batch at once. Until then it keeps the detached infos alive.
+  [self.cacheMap removeObjectsForKeys:names];
+
+  unsigned long long remainingMemoryCost = [self memoryCost];
+  [self didRemoveObjects: count - [self count]
+           numberOfBytes: (memoryCost > remainingMemoryCost) ? memoryCost - remainingMemoryCost : 0
+                  reason: NIMemoryCacheRemovalReasonExplicit];
+  [self endBatchUpdate];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)beginBatchUpdate {
+  ++_batchUpdateDepth;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)endBatchUpdate {
+  NIDASSERT(_batchUpdateDepth > 0);
+  if (_batchUpdateDepth > 0 && 0 == --_batchUpdateDepth) {
+    [self didEndBatchUpdate];
+  }
 }
 
 
@@ -212,6 +395,27 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)isPerformingBatchUpdate {
+  return (_batchUpdateDepth > 0);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didEndBatchUpdate {
+  // No-op
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSString *)nameOfObjectToEvict {
+  if (nil != _evictionPolicy) {
+    return [_evictionPolicy nameOfObjectToEvict];
+  }
+  return [(NIMemoryCacheInfo *)[self.lruCacheObjects firstObject] name];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -231,14 +435,42 @@
     return;
   }
 
-  if (nil != expirationDate && [[NSDate date] timeIntervalSinceDate:expirationDate] >= 0) {
+  // Stores are where the cache grows, so this is where expired objects are reclaimed.
+  [self removeExpiredObjects];
+
+  uint64_t expirationTick = 0;
+  if (nil != expirationDate) {
+    expirationTick = NIMemoryCacheExpirationTickForDate(expirationDate);
+  }
+
+  if (nil != expirationDate && expirationTick <= NIMemoryCacheExpirationTick()) {
     // The object being stored is already expired so remove the object from the cache altogether.
-    [self removeObjectWithName:name];
+    [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpired];
 
     // We're done here.
     return;
   }
-  NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+
+  [self storeObject:object withName:name expirationTick:expirationTick];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)storeObject:(id)object withName:(NSString *)name expirationTick:(uint64_t)expirationTick {
+  NIDASSERT(nil != name);
+  if (nil == name) {
+    return;
+  }
+
+  NIMemoryCacheInfo* previousInfo = [self cacheInfoForName:name];
+
+  // Subclasses account for the replaced object here, so this has to happen while the existing
+  // entry still holds it. A rejected object leaves the existing entry untouched.
+  if (![self willSetObject:object withName:name previousObject:previousInfo.object]) {
+    return;
+  }
+
+  NIMemoryCacheInfo* info = previousInfo;
 
   // Create a new cache entry.
   if (nil == info) {
@@ -250,10 +482,31 @@
   info.object = object;
 
   // Override any existing expiration date.
-  info.expirationDate = expirationDate;
+  info.expirationTick = expirationTick;
 
   // Commit the changes to the cache.
-  [self setCacheInfo:info forName:name];
+  [self setCacheInfo:info forName:name isReplacement:(nil != previousInfo)];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)storeObjects:(NSArray *)objects withNames:(NSArray *)names {
+  NIDASSERT([objects count] == [names count]);
+  NSUInteger count = MIN([objects count], [names count]);
+  if (0 == count) {
+    return;
+  }
+
+  // Once for the whole batch rather than once per object.
+  [self removeExpiredObjects];
+
+  [self beginBatchUpdate];
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    [self storeObject: [objects objectAtIndex:ix]
+             withName: [names objectAtIndex:ix]
+       expirationTick: 0];
+  }
+  [self endBatchUpdate];
 }
 
 
@@ -265,26 +518,47 @@
 
   if (nil != info) {
     if ([info hasExpired]) {
-      [self removeObjectWithName:name];
+      [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpired];
 
     } else {
       // Update the access time whenever we fetch an object from the cache.
       [self updateAccessTimeForInfo:info];
+      [_evictionPolicy didAccessObjectWithName:name];
 
       object = info.object;
     }
   }
 
+  if (nil != object) {
+    ++_statistics.numberOfHits;
+
+  } else {
+    ++_statistics.numberOfMisses;
+  }
+
   return [[object retain] autorelease];
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)peekObjectWithName:(NSString *)name {
+  NIMemoryCacheInfo* info = [self cacheInfoForName:name];
+
+  if ([info hasExpired]) {
+    [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpired];
+    return nil;
+  }
+
+  return [[info.object retain] autorelease];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (BOOL)containsObjectWithName:(NSString *)name {
   NIMemoryCacheInfo* info = [self cacheInfoForName:name];
 
   if ([info hasExpired]) {
-    [self removeObjectWithName:name];
+    [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpired];
     return NO;
   }
 
@@ -297,7 +571,7 @@
   NIMemoryCacheInfo* info = [self cacheInfoForName:name];
 
   if ([info hasExpired]) {
-    [self removeObjectWithName:name];
+    [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExpired];
     return nil;
   }
 
@@ -310,7 +584,7 @@
   NIMemoryCacheInfo* info = [self.lruCacheObjects firstObject];
 
   if ([info hasExpired]) {
-    [self removeObjectWithName:info.name];
+    [self removeCacheInfoForName:info.name reason:NIMemoryCacheRemovalReasonExpired];
     return nil;
   }
 
@@ -323,7 +597,7 @@
   NIMemoryCacheInfo* info = [self.lruCacheObjects lastObject];
 
   if ([info hasExpired]) {
-    [self removeObjectWithName:info.name];
+    [self removeCacheInfoForName:info.name reason:NIMemoryCacheRemovalReasonExpired];
     return nil;
   }
 
@@ -333,31 +607,112 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)removeObjectWithName:(NSString *)name {
-  [self removeCacheInfoForName:name];
+  [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonExplicit];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObjectWithName:(NSString *)name reason:(NIMemoryCacheRemovalReason)reason {
+  [self removeCacheInfoForName:name reason:reason];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObjectsPassingTest:(BOOL (^)(NSString* name, id object))predicate {
+  NIDASSERT(nil != predicate);
+  if (nil == predicate) {
+    return;
+  }
+
+  // Every object in the cache is in the lru list, which is quicker to walk than the map.
+  NSMutableArray* names = nil;
+  for (NIMemoryCacheInfo* info in self.lruCacheObjects) {
+    if (predicate(info.name, info.object)) {
+      if (nil == names) {
+        names = [NSMutableArray array];
+      }
+      [names addObject:info.name];
+    }
+  }
+  [self removeCacheInfosForNames:names];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObjectsWithNamePrefix:(NSString *)prefix {
+  if (0 == [prefix length]) {
+    return;
+  }
+
+  [self removeObjectsPassingTest:^BOOL(NSString* name, id object) {
+    return [name hasPrefix:prefix];
+  }];
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)removeAllObjects {
+  // Subclasses reset their own accounting after this returns, so measure it first.
+  [self didRemoveObjects: [self count]
+           numberOfBytes: [self memoryCost]
+                  reason: NIMemoryCacheRemovalReasonExplicit];
+
+  // The wheel doesn't retain its entries, so empty it before the cache map lets them go.
+  [_expirationWheel unscheduleAllInfos];
   self.cacheMap = [[[NSMutableDictionary alloc] init] autorelease];
   self.lruCacheObjects = [[[NILinkedList alloc] init] autorelease];
+  [_evictionPolicy didRemoveAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setEvictionPolicy:(id<NIMemoryCacheEvictionPolicy>)evictionPolicy {
+  if (_evictionPolicy == evictionPolicy) {
+    return;
+  }
+  [_evictionPolicy release];
+  _evictionPolicy = [evictionPolicy retain];
+
+  // Catch the new policy up on what is already cached, least recently used first.
+  [_evictionPolicy didRemoveAllObjects];
+  for (NIMemoryCacheInfo* info in self.lruCacheObjects) {
+    [_evictionPolicy didInsertObjectWithName:info.name];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeExpiredObjects {
+  // The wheel doesn't retain its entries, but the cache map does until they're removed.
+  for (NIMemoryCacheInfo* info in [_expirationWheel advanceToTick:NIMemoryCacheExpirationTick()]) {
+    if ([self cacheInfoForName:info.name] == info) {
+      [self removeCacheInfoForName:info.name reason:NIMemoryCacheRemovalReasonExpired];
+    }
+  }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)reduceMemoryUsage {
-  // Copy the cache map because it's likely that we're going to modify it.
-  NSDictionary* cacheMap = [self.cacheMap copy];
+  [self removeExpiredObjects];
+}
 
-  // Iterate over the copied cache map (which will not be modified).
-  for (id name in cacheMap) {
-    NIMemoryCacheInfo* info = [self cacheInfoForName:name];
 
-    if ([info hasExpired]) {
-      [self removeCacheInfoForName:name];
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (unsigned long long)memoryCost {
+  return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryCostTo:(unsigned long long)memoryCost {
+  while ([self memoryCost] > memoryCost && [self count] > 0) {
+    NSString* name = [self nameOfObjectToEvict];
+    if (nil == name) {
+      break; // COV_NF_LINE
     }
+    [self removeCacheInfoForName:name reason:NIMemoryCacheRemovalReasonMemoryPressure];
   }
-  NI_RELEASE_SAFELY(cacheMap);
 }
 
 
@@ -367,6 +722,21 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NIMemoryCacheStatistics)statistics {
+  NIMemoryCacheStatistics statistics = _statistics;
+  statistics.numberOfBytes = [self memoryCost];
+  statistics.count = [self count];
+  return statistics;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)resetStatistics {
+  memset(&_statistics, 0, sizeof(_statistics));
+}
+
+
 @end
 
 
@@ -377,27 +747,225 @@
 
 @synthesize name            = _name;
 @synthesize object          = _object;
-@synthesize expirationDate  = _expirationDate;
-@synthesize lastAccessTime  = _lastAccessTime;
+@synthesize expirationTick  = _expirationTick;
+@synthesize lastAccessTick  = _lastAccessTick;
 @synthesize lruLocation     = _lruLocation;
+@synthesize wheelPrevious   = _wheelPrevious;
+@synthesize wheelNext       = _wheelNext;
+@synthesize wheelSlot       = _wheelSlot;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    _wheelSlot = NSNotFound;
+  }
+  return self;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)dealloc {
   NI_RELEASE_SAFELY(_name);
   NI_RELEASE_SAFELY(_object);
-  NI_RELEASE_SAFELY(_expirationDate);
-  NI_RELEASE_SAFELY(_lastAccessTime);
   _lruLocation = nil;
+  _wheelPrevious = nil;
+  _wheelNext = nil;
 
   [super dealloc];
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSDate *)lastAccessTime {
+  return NIMemoryCacheDateForTick(_lastAccessTick);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (BOOL)hasExpired {
-  return (nil != _expirationDate
-          && [[NSDate date] timeIntervalSinceDate:_expirationDate] >= 0);
+  return (0 != _expirationTick
+          && NIMemoryCacheExpirationTick() >= _expirationTick);
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIMemoryCacheExpirationWheel
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithTick:0];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithTick:(uint64_t)tick {
+  if ((self = [super init])) {
+    _currentTick = tick;
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)slotForTick:(uint64_t)tick {
+  uint64_t delta = (tick > _currentTick) ? tick - _currentTick : 0;
+  if (0 == delta) {
+    // Already due, which happens if the clock went back. Expire it on the next tick.
+    return (NSUInteger)((_currentTick + 1) & NIExpirationWheelSlotMask);
+  }
+
+  NSUInteger level = 0;
+  while (level + 1 < NIExpirationWheelNumberOfLevels
+         && delta >= (1ULL << (NIExpirationWheelBitsPerLevel * (level + 1)))) {
+    ++level;
+  }
+
+  // Anything beyond the top level's range is rescheduled whenever its slot cascades.
+  return (level * NIExpirationWheelSlotsPerLevel
+          + (NSUInteger)((tick >> (NIExpirationWheelBitsPerLevel * level))
+                         & NIExpirationWheelSlotMask));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)scheduleInfo:(NIMemoryCacheInfo *)info {
+  NIDASSERT(NSNotFound == info.wheelSlot);
+  NIDASSERT(0 != info.expirationTick);
+
+  NSUInteger slot = [self slotForTick:info.expirationTick];
+  NIMemoryCacheInfo* head = _slots[slot];
+  info.wheelPrevious = nil;
+  info.wheelNext = head;
+  head.wheelPrevious = info;
+  info.wheelSlot = slot;
+  _slots[slot] = info;
+  ++_count;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)unscheduleInfo:(NIMemoryCacheInfo *)info {
+  NSUInteger slot = info.wheelSlot;
+  if (NSNotFound == slot) {
+    return;
+  }
+
+  NIMemoryCacheInfo* previous = info.wheelPrevious;
+  NIMemoryCacheInfo* next = info.wheelNext;
+  if (nil != previous) {
+    previous.wheelNext = next;
+
+  } else {
+    _slots[slot] = next;
+  }
+  next.wheelPrevious = previous;
+
+  info.wheelPrevious = nil;
+  info.wheelNext = nil;
+  info.wheelSlot = NSNotFound;
+  --_count;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)unscheduleAllInfos {
+  memset(_slots, 0, sizeof(_slots));
+  _count = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NIMemoryCacheInfo *)detachSlot:(NSUInteger)slot {
+  NIMemoryCacheInfo* head = _slots[slot];
+  _slots[slot] = nil;
+  for (NIMemoryCacheInfo* info = head; nil != info; info = info.wheelNext) {
+    info.wheelSlot = NSNotFound;
+    --_count;
+  }
+  return head;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSMutableArray *)rescheduleInfos:(NIMemoryCacheInfo *)head
+                   collectExpiredIn:(NSMutableArray *)expiredInfos {
+  NIMemoryCacheInfo* info = head;
+  while (nil != info) {
+    NIMemoryCacheInfo* next = info.wheelNext;
+    info.wheelPrevious = nil;
+    info.wheelNext = nil;
+
+    if (info.expirationTick <= _currentTick) {
+      if (nil == expiredInfos) {
+        expiredInfos = [NSMutableArray array];
+      }
+      [expiredInfos addObject:info];
+
+    } else {
+      [self scheduleInfo:info];
+    }
+    info = next;
+  }
+  return expiredInfos;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSArray *)advanceToTick:(uint64_t)tick {
+  if (tick <= _currentTick) {
+    return nil;
+  }
+
+  NSMutableArray* expiredInfos = nil;
+
+  if (tick - _currentTick >= (1ULL << (NIExpirationWheelBitsPerLevel * 3))) {
+    // After a long time away (days of one second ticks) it's cheaper to sort everything
+    // again than to turn the wheel one tick at a time.
+    NIMemoryCacheInfo* heads[NIExpirationWheelNumberOfSlots];
+    for (NSUInteger slot = 0; slot < NIExpirationWheelNumberOfSlots; ++slot) {
+      heads[slot] = [self detachSlot:slot];
+    }
+    _currentTick = tick;
+    for (NSUInteger slot = 0; slot < NIExpirationWheelNumberOfSlots; ++slot) {
+      expiredInfos = [self rescheduleInfos:heads[slot] collectExpiredIn:expiredInfos];
+    }
+    return expiredInfos;
+  }
+
+  while (_currentTick < tick && _count > 0) {
+    ++_currentTick;
+
+    // When a lower level wraps around, the next slot of the level above is spread out over the
+    // levels below it. Higher levels go first so that their entries can keep falling.
+    NSUInteger level = 0;
+    while (level + 1 < NIExpirationWheelNumberOfLevels
+           && 0 == (_currentTick & ((1ULL << (NIExpirationWheelBitsPerLevel * (level + 1))) - 1))) {
+      ++level;
+    }
+    for (; level > 0; --level) {
+      NSUInteger slot = (level * NIExpirationWheelSlotsPerLevel
+                         + (NSUInteger)((_currentTick >> (NIExpirationWheelBitsPerLevel * level))
+                                        & NIExpirationWheelSlotMask));
+      expiredInfos = [self rescheduleInfos: [self detachSlot:slot]
+                          collectExpiredIn: expiredInfos];
+    }
+
+    NSUInteger slot = (NSUInteger)(_currentTick & NIExpirationWheelSlotMask);
+    expiredInfos = [self rescheduleInfos: [self detachSlot:slot]
+                        collectExpiredIn: expiredInfos];
+  }
+
+  // Nothing left to expire, so skip the rest of the way.
+  _currentTick = tick;
+
+  return expiredInfos;
 }
 
 
@@ -411,6 +979,7 @@
 
 // Internally only.
 @property (nonatomic, readwrite, assign) NSUInteger numberOfPixels;
+@property (nonatomic, readwrite, assign) NSUInteger numberOfBytes;
 
 @end
 
@@ -423,6 +992,9 @@
 @synthesize numberOfPixels                = _numberOfPixels;
 @synthesize maxNumberOfPixels             = _maxNumberOfPixels;
 @synthesize maxNumberOfPixelsUnderStress  = _maxNumberOfPixelsUnderStress;
+@synthesize numberOfBytes                 = _numberOfBytes;
+@synthesize maxNumberOfBytes              = _maxNumberOfBytes;
+@synthesize maxNumberOfBytesUnderStress   = _maxNumberOfBytesUnderStress;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -431,11 +1003,55 @@
     return 0;
   }
 
-  NSUInteger numberOfPixels = (NSUInteger)(image.size.width * image.size.height);
+  // The size is in points, so the scale applies to both dimensions.
+  CGFloat scale = 1;
   if ([image respondsToSelector:@selector(scale)]) {
-    numberOfPixels *= [image scale];
+    scale = [image scale];
+  }
+  return ((NSUInteger)(image.size.width * scale)
+          * (NSUInteger)(image.size.height * scale));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)numberOfBytesUsedByImage:(UIImage *)image {
+  if (nil == image) {
+    return 0;
+  }
+
+  // Whether or not the image has been decoded yet, this is the bitmap it decodes into.
+  // bytesPerRow includes the row padding.
+  CGImageRef imageRef = image.CGImage;
+  if (NULL != imageRef) {
+    return CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+  }
+
+  // Images without a CGImage are rendered into 32-bit bitmaps.
+  return [self numberOfPixelsUsedByImage:image] * 4;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)exceedsMaxNumberOfPixels:(NSUInteger)maxNumberOfPixels
+                maxNumberOfBytes:(NSUInteger)maxNumberOfBytes {
+  return ((maxNumberOfPixels > 0 && self.numberOfPixels > maxNumberOfPixels)
+          || (maxNumberOfBytes > 0 && self.numberOfBytes > maxNumberOfBytes));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceToMaxNumberOfPixels:(NSUInteger)maxNumberOfPixels
+                 maxNumberOfBytes:(NSUInteger)maxNumberOfBytes
+                           reason:(NIMemoryCacheRemovalReason)reason {
+  // Remove images, least recently used first unless a policy says otherwise.
+  while ([self exceedsMaxNumberOfPixels:maxNumberOfPixels maxNumberOfBytes:maxNumberOfBytes]
+         && [self count] > 0) {
+    NSString* name = [self nameOfObjectToEvict];
+    if (nil == name) {
+      break; // COV_NF_LINE
+    }
+    [self removeCacheInfoForName:name reason:reason];
   }
-  return numberOfPixels;
 }
 
 
@@ -444,6 +1060,7 @@
   [super removeAllObjects];
 
   self.numberOfPixels = 0;
+  self.numberOfBytes = 0;
 }
 
 
@@ -452,13 +1069,15 @@
   // Remove all expired images first.
   [super reduceMemoryUsage];
 
-  if (self.maxNumberOfPixelsUnderStress > 0) {
-    // Remove the least recently used images by iterating over the linked list.
-    while (self.numberOfPixels > self.maxNumberOfPixelsUnderStress) {
-      NIMemoryCacheInfo* info = [self.lruCacheObjects firstObject];
-      [self removeCacheInfoForName:info.name];
-    }
-  }
+  [self reduceToMaxNumberOfPixels: self.maxNumberOfPixelsUnderStress
+                 maxNumberOfBytes: self.maxNumberOfBytesUnderStress
+                           reason: NIMemoryCacheRemovalReasonMemoryPressure];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (unsigned long long)memoryCost {
+  return self.numberOfBytes;
 }
 
 
@@ -471,6 +1090,8 @@
 
   self.numberOfPixels -= [self numberOfPixelsUsedByImage:previousObject];
   self.numberOfPixels += [self numberOfPixelsUsedByImage:object];
+  self.numberOfBytes -= [self numberOfBytesUsedByImage:previousObject];
+  self.numberOfBytes += [self numberOfBytesUsedByImage:object];
 
   return YES;
 }
@@ -478,18 +1099,26 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)didSetObject:(id)object withName:(NSString *)name {
+  // A batch is trimmed once, when it ends.
+  if ([self isPerformingBatchUpdate]) {
+    return;
+  }
+
   // Reduce the cache size after the object has been set in case the cache size is smaller
   // than the object that's being added and we need to remove this object right away. If we
   // try to reduce the cache size before the object's been set, we won't have anything to remove
   // and we'll get stuck in an infinite loop.
-  if (self.maxNumberOfPixels > 0) {
-    // Remove least recently used images until we satisfy our memory constraints.
-    while (self.numberOfPixels > self.maxNumberOfPixels
-           && [self.lruCacheObjects count] > 0) {
-      NIMemoryCacheInfo* info = [self.lruCacheObjects firstObject];
-      [self removeCacheInfoForName:info.name];
-    }
-  }
+  [self reduceToMaxNumberOfPixels: self.maxNumberOfPixels
+                 maxNumberOfBytes: self.maxNumberOfBytes
+                           reason: NIMemoryCacheRemovalReasonCapacity];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didEndBatchUpdate {
+  [self reduceToMaxNumberOfPixels: self.maxNumberOfPixels
+                 maxNumberOfBytes: self.maxNumberOfBytes
+                           reason: NIMemoryCacheRemovalReasonCapacity];
 }
 
 
@@ -500,12 +1129,174 @@
     return; // COV_NF_LINE
   }
 
-  NIMemoryCacheInfo* info = [self cacheInfoForName:name];
-  [self.lruCacheObjects removeObjectAtLocation:info.lruLocation];
-
+  NIDASSERT(self.numberOfPixels >= [self numberOfPixelsUsedByImage:object]);
+  NIDASSERT(self.numberOfBytes >= [self numberOfBytesUsedByImage:object]);
   self.numberOfPixels -= [self numberOfPixelsUsedByImage:object];
+  self.numberOfBytes -= [self numberOfBytesUsedByImage:object];
 }
 
 
 @end
 
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@interface NIDataMemoryCache()
+
+// Internally only.
+@property (nonatomic, readwrite, assign) NSUInteger numberOfBytes;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIDataMemoryCache
+
+@synthesize numberOfBytes               = _numberOfBytes;
+@synthesize maxNumberOfBytes            = _maxNumberOfBytes;
+@synthesize maxNumberOfBytesUnderStress = _maxNumberOfBytesUnderStress;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceToMaxNumberOfBytes:(NSUInteger)maxNumberOfBytes
+                          reason:(NIMemoryCacheRemovalReason)reason {
+  while (maxNumberOfBytes > 0 && self.numberOfBytes > maxNumberOfBytes && [self count] > 0) {
+    NSString* name = [self nameOfObjectToEvict];
+    if (nil == name) {
+      break; // COV_NF_LINE
+    }
+    [self removeCacheInfoForName:name reason:reason];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setMaxNumberOfBytes:(NSUInteger)maxNumberOfBytes {
+  _maxNumberOfBytes = maxNumberOfBytes;
+  [self reduceToMaxNumberOfBytes:maxNumberOfBytes reason:NIMemoryCacheRemovalReasonCapacity];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeAllObjects {
+  [super removeAllObjects];
+
+  self.numberOfBytes = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryUsage {
+  // Remove all expired data first.
+  [super reduceMemoryUsage];
+
+  [self reduceToMaxNumberOfBytes: self.maxNumberOfBytesUnderStress
+                          reason: NIMemoryCacheRemovalReasonMemoryPressure];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (unsigned long long)memoryCost {
+  return self.numberOfBytes;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)willSetObject:(id)object withName:(NSString *)name previousObject:(id)previousObject {
+  NIDASSERT(nil == object || [object isKindOfClass:[NSData class]]);
+  if (![object isKindOfClass:[NSData class]]) {
+    return NO;
+  }
+
+  self.numberOfBytes -= [(NSData *)previousObject length];
+  self.numberOfBytes += [(NSData *)object length];
+
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didSetObject:(id)object withName:(NSString *)name {
+  // A batch is trimmed once, when it ends.
+  if ([self isPerformingBatchUpdate]) {
+    return;
+  }
+
+  [self reduceToMaxNumberOfBytes:self.maxNumberOfBytes reason:NIMemoryCacheRemovalReasonCapacity];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didEndBatchUpdate {
+  [self reduceToMaxNumberOfBytes:self.maxNumberOfBytes reason:NIMemoryCacheRemovalReasonCapacity];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)willRemoveObject:(id)object withName:(NSString *)name {
+  NIDASSERT(nil == object || [object isKindOfClass:[NSData class]]);
+  if (![object isKindOfClass:[NSData class]]) {
+    return; // COV_NF_LINE
+  }
+
+  NIDASSERT(self.numberOfBytes >= [(NSData *)object length]);
+  self.numberOfBytes -= [(NSData *)object length];
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NIMemoryCacheStatistics NIMemoryCacheStatisticsAdd(NIMemoryCacheStatistics statistics1,
+                                                   NIMemoryCacheStatistics statistics2) {
+  NIMemoryCacheStatistics sum = statistics1;
+  sum.numberOfHits += statistics2.numberOfHits;
+  sum.numberOfMisses += statistics2.numberOfMisses;
+  sum.numberOfInsertions += statistics2.numberOfInsertions;
+  sum.numberOfReplacements += statistics2.numberOfReplacements;
+  for (NSInteger ix = 0; ix < NIMemoryCacheNumberOfRemovalReasons; ++ix) {
+    sum.numberOfRemovals[ix] += statistics2.numberOfRemovals[ix];
+    sum.numberOfBytesRemoved[ix] += statistics2.numberOfBytesRemoved[ix];
+  }
+  sum.numberOfBytes += statistics2.numberOfBytes;
+  sum.count += statistics2.count;
+  return sum;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSDictionary* NIDictionaryFromMemoryCacheStatistics(NIMemoryCacheStatistics statistics) {
+  // In NIMemoryCacheRemovalReason order.
+  NSArray* reasons = [NSArray arrayWithObjects:
+                      @"explicit", @"expired", @"capacity", @"memoryPressure", nil];
+  NIDASSERT([reasons count] == NIMemoryCacheNumberOfRemovalReasons);
+
+  NSMutableDictionary* removals = [NSMutableDictionary dictionary];
+  NSMutableDictionary* bytesRemoved = [NSMutableDictionary dictionary];
+  for (NSInteger ix = 0; ix < NIMemoryCacheNumberOfRemovalReasons; ++ix) {
+    NSString* reason = [reasons objectAtIndex:ix];
+    [removals setObject: [NSNumber numberWithUnsignedLongLong:statistics.numberOfRemovals[ix]]
+                 forKey: reason];
+    [bytesRemoved setObject: [NSNumber numberWithUnsignedLongLong:statistics.numberOfBytesRemoved[ix]]
+                     forKey: reason];
+  }
+
+  unsigned long long lookups = statistics.numberOfHits + statistics.numberOfMisses;
+  double hitRatio = (lookups > 0) ? (double)statistics.numberOfHits / (double)lookups : 0;
+
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+          [NSNumber numberWithUnsignedLongLong:statistics.numberOfHits], @"hits",
+          [NSNumber numberWithUnsignedLongLong:statistics.numberOfMisses], @"misses",
+          [NSNumber numberWithDouble:hitRatio], @"hitRatio",
+          [NSNumber numberWithUnsignedLongLong:statistics.numberOfInsertions], @"insertions",
+          [NSNumber numberWithUnsignedLongLong:statistics.numberOfReplacements], @"replacements",
+          removals, @"removals",
+          bytesRemoved, @"bytesRemoved",
+          [NSNumber numberWithUnsignedLongLong:statistics.numberOfBytes], @"bytes",
+          [NSNumber numberWithUnsignedInteger:statistics.count], @"count",
+          nil];
+}
@@ -0,0 +1,257 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Pluggable eviction policies for NIMemoryCache.
+ *
+ * By default an NIMemoryCache evicts its least recently used object. Plain LRU is not scan
+ * resistant: flinging through a long strip of photos touches every image exactly once and
+ * pushes out the images the user keeps coming back to. An eviction policy decides which
+ * object a cache gives up when it needs room.
+ *
+ *      @ingroup In-Memory-Caches
+ *      @{
+ */
+
+@class NILinkedList;
+
+/**
+ * The interface between NIMemoryCache and an eviction policy.
+ *
+ * The cache tells the policy about every insertion, access and removal, by name, and asks it
+ * for a name whenever it has to evict something. A policy instance must only be attached to
+ * one cache at a time.
+ */
+@protocol NIMemoryCacheEvictionPolicy <NSObject>
+@required
+
+- (void)didInsertObjectWithName:(NSString *)name;
+- (void)didAccessObjectWithName:(NSString *)name;
+- (void)didRemoveObjectWithName:(NSString *)name;
+- (void)didRemoveAllObjects;
+
+- (NSString *)nameOfObjectToEvict;
+
+@end
+
+
+/**
+ * Plain least-recently-used eviction.
+ *
+ * This is what NIMemoryCache does when it has no eviction policy. It exists as a policy so
+ * that it can be compared against others with NIMemoryCacheEvictionSimulator.
+ */
+@interface NILRUEvictionPolicy : NSObject <NIMemoryCacheEvictionPolicy> {
+@private
+  NILinkedList*         _lru;
+  NSMutableDictionary*  _locations;
+}
+
+@end
+
+
+/**
+ * A count-min sketch of 4-bit counters used to estimate how often a name has been seen.
+ *
+ * Counters are halved once the number of recorded events reaches ten times the width of the
+ * sketch, so old popularity fades out.
+ */
+@interface NIFrequencySketch : NSObject {
+@private
+  uint8_t*    _counters;
+  NSUInteger  _width;
+  NSUInteger  _numberOfEvents;
+  NSUInteger  _resetThreshold;
+}
+
+// Designated initializer.
+- (id)initWithExpectedNumberOfObjects:(NSUInteger)expectedNumberOfObjects;
+
+- (void)recordEventForName:(NSString *)name;
+- (NSUInteger)frequencyForName:(NSString *)name;
+
+@end
+
+
+/**
+ * Window TinyLFU eviction.
+ *
+ * New objects enter a small LRU window. When the window overflows, its oldest object moves to
+ * the tail of probation, and when something has to be evicted it must win a frequency duel
+ * against the head of probation to be kept. The main area is a segmented LRU: objects that
+ * are hit again while on probation move to the protected segment. One-shot objects, such as
+ * those touched by a fast scroll, lose the duel and leave without displacing frequently used
+ * objects.
+ */
+@interface NIWTinyLFUEvictionPolicy : NSObject <NIMemoryCacheEvictionPolicy> {
+@private
+  NIFrequencySketch*    _sketch;
+  NSMutableDictionary*  _entries;
+  NILinkedList*         _window;
+  NILinkedList*         _probation;
+  NILinkedList*         _protected;
+  double                _windowRatio;
+  double                _protectedRatio;
+}
+
+// Designated initializer.
+- (id)initWithExpectedNumberOfObjects:(NSUInteger)expectedNumberOfObjects;
+
+@property (nonatomic, readonly) NIFrequencySketch* sketch;
+@property (nonatomic, readwrite, assign) double windowRatio;     // default: 0.01
+@property (nonatomic, readwrite, assign) double protectedRatio;  // default: 0.8
+
+@end
+
+
+/**
+ * Replays a recorded access trace against eviction policies and reports their hit rates.
+ *
+ * Each entry of a trace is the name of an object that was requested. A miss inserts the name,
+ * then names are evicted, as chosen by the policy, until the simulated cache holds at most
+ * capacity objects.
+ */
+@interface NIMemoryCacheEvictionSimulator : NSObject
+
++ (NSArray *)traceWithContentsOfFile:(NSString *)path;
+
++ (double)hitRateForTrace:(NSArray *)trace
+                 capacity:(NSUInteger)capacity
+                   policy:(id<NIMemoryCacheEvictionPolicy>)policy;
+
++ (NSDictionary *)hitRatesForTrace:(NSArray *)trace
+                          capacity:(NSUInteger)capacity
+                     policyClasses:(NSArray *)policyClasses;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**@}*/// End of In-Memory Cache //////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+/** @name Notifying an Eviction Policy */
+
+/**
+ * An object was stored in the cache under a name that was not in the cache before.
+ *
+ *      @fn NIMemoryCacheEvictionPolicy::didInsertObjectWithName:
+ */
+
+/**
+ * An object already in the cache was fetched or stored again.
+ *
+ *      @fn NIMemoryCacheEvictionPolicy::didAccessObjectWithName:
+ */
+
+/**
+ * An object was removed from the cache, whether by eviction, expiration or explicitly.
+ *
+ *      @fn NIMemoryCacheEvictionPolicy::didRemoveObjectWithName:
+ */
+
+/**
+ * The cache was emptied.
+ *
+ *      @fn NIMemoryCacheEvictionPolicy::didRemoveAllObjects
+ */
+
+
+/** @name Choosing a Victim */
+
+/**
+ * Returns the name of the object the cache should remove next.
+ *
+ * This does not remove anything itself and must not change the policy's state, so it is safe
+ * to ask without evicting. The cache reports the removal through didRemoveObjectWithName: as
+ * usual. Returns nil if the policy tracks no objects.
+ *
+ *      @fn NIMemoryCacheEvictionPolicy::nameOfObjectToEvict
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// NIFrequencySketch
+
+/**
+ * Initializes a sketch sized for roughly the given number of distinct live objects.
+ *
+ *      @fn NIFrequencySketch::initWithExpectedNumberOfObjects:
+ */
+
+/**
+ * Returns the estimated number of recent events for a name, from 0 to 15.
+ *
+ * The estimate may be too high, due to collisions, but is never too low.
+ *
+ *      @fn NIFrequencySketch::frequencyForName:
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// NIWTinyLFUEvictionPolicy
+
+/**
+ * Initializes a policy whose frequency sketch is sized for roughly the given number of objects.
+ *
+ * This should be about the number of objects the cache holds when it is full.
+ *
+ *      @fn NIWTinyLFUEvictionPolicy::initWithExpectedNumberOfObjects:
+ */
+
+/**
+ * The share of tracked objects kept in the admission window.
+ *
+ * A larger window favors recency, a smaller one favors frequency.
+ *
+ *      @fn NIWTinyLFUEvictionPolicy::windowRatio
+ */
+
+/**
+ * The share of the main area that may be protected.
+ *
+ *      @fn NIWTinyLFUEvictionPolicy::protectedRatio
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// NIMemoryCacheEvictionSimulator
+
+/**
+ * Loads a trace from a text file containing one name per line. Empty lines are skipped.
+ *
+ * A trace can be recorded by logging the names passed to NIMemoryCache::objectWithName:.
+ *
+ *      @fn NIMemoryCacheEvictionSimulator::traceWithContentsOfFile:
+ */
+
+/**
+ * Replays the trace against a fresh policy and returns the fraction of requests that hit.
+ *
+ *      @fn NIMemoryCacheEvictionSimulator::hitRateForTrace:capacity:policy:
+ */
+
+/**
+ * Replays the trace against a new instance of each policy class, and returns a dictionary
+ * mapping each class name to its hit rate as an NSNumber.
+ *
+ * Classes that respond to initWithExpectedNumberOfObjects: are initialized with capacity.
+ *
+ *      @fn NIMemoryCacheEvictionSimulator::hitRatesForTrace:capacity:policyClasses:
+ */
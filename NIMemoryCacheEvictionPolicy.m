@@ -0,0 +1,479 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIMemoryCacheEvictionPolicy.h"
+
+#import "NIDataStructures.h"
+#import "NIDebuggingTools.h"
+#import "NIPreprocessorMacros.h"
+
+// Number of hash functions, and rows, in the frequency sketch.
+static const NSUInteger kSketchDepth = 4;
+static const uint64_t kSketchSeeds[4] = {
+  0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NILRUEvictionPolicy
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_lru);
+  NI_RELEASE_SAFELY(_locations);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    _lru = [[NILinkedList alloc] init];
+    _locations = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NILinkedListLocation *)locationForName:(NSString *)name {
+  return [[_locations objectForKey:name] pointerValue];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didInsertObjectWithName:(NSString *)name {
+  NILinkedListLocation* location = [_lru addObject:name];
+  [_locations setObject:[NSValue valueWithPointer:location] forKey:name];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didAccessObjectWithName:(NSString *)name {
+  [_lru moveObjectAtLocationToTail:[self locationForName:name]];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didRemoveObjectWithName:(NSString *)name {
+  [_lru removeObjectAtLocation:[self locationForName:name]];
+  [_locations removeObjectForKey:name];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didRemoveAllObjects {
+  [_lru removeAllObjects];
+  [_locations removeAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSString *)nameOfObjectToEvict {
+  return [_lru firstObject];
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIFrequencySketch
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  free(_counters);
+  _counters = NULL;
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithExpectedNumberOfObjects:0];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithExpectedNumberOfObjects:(NSUInteger)expectedNumberOfObjects {
+  if ((self = [super init])) {
+    // A power of two at least twice the expected number of objects keeps collisions rare.
+    _width = 64;
+    while (_width < expectedNumberOfObjects * 2) {
+      _width <<= 1;
+    }
+    _resetThreshold = _width * 10;
+
+    // Two 4-bit counters per byte.
+    _counters = calloc(kSketchDepth * _width / 2, sizeof(uint8_t));
+    if (NULL == _counters) {
+      [self release];
+      return nil;
+    }
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static uint64_t NIFrequencySketchMix(uint64_t hash) {
+  // The 64 bit finalizer from MurmurHash3. NSString's hash leaves most of the bits alone.
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)counterIndexForHash:(uint64_t)hash row:(NSUInteger)row {
+  uint64_t rowHash = NIFrequencySketchMix(hash ^ kSketchSeeds[row]);
+  return row * _width + (NSUInteger)(rowHash & (_width - 1));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)counterAtIndex:(NSUInteger)counterIndex {
+  return (_counters[counterIndex >> 1] >> ((counterIndex & 1) << 2)) & 0xF;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)halveAllCounters {
+  for (NSUInteger ix = 0; ix < kSketchDepth * _width / 2; ++ix) {
+    _counters[ix] = (_counters[ix] >> 1) & 0x77;
+  }
+  _numberOfEvents /= 2;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)recordEventForName:(NSString *)name {
+  uint64_t hash = [name hash];
+  for (NSUInteger row = 0; row < kSketchDepth; ++row) {
+    NSUInteger counterIndex = [self counterIndexForHash:hash row:row];
+    if ([self counterAtIndex:counterIndex] < 0xF) {
+      _counters[counterIndex >> 1] += (1 << ((counterIndex & 1) << 2));
+    }
+  }
+
+  if (++_numberOfEvents >= _resetThreshold) {
+    [self halveAllCounters];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)frequencyForName:(NSString *)name {
+  uint64_t hash = [name hash];
+  NSUInteger frequency = 0xF;
+  for (NSUInteger row = 0; row < kSketchDepth; ++row) {
+    frequency = MIN(frequency, [self counterAtIndex:[self counterIndexForHash:hash row:row]]);
+  }
+  return frequency;
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+typedef enum {
+  NIWTinyLFUSegmentWindow,
+  NIWTinyLFUSegmentProbation,
+  NIWTinyLFUSegmentProtected,
+} NIWTinyLFUSegment;
+
+/**
+ * @brief Where a name currently lives in an NIWTinyLFUEvictionPolicy.
+ */
+@interface NIWTinyLFUEntry : NSObject {
+@public
+  NIWTinyLFUSegment     _segment;
+  NILinkedListLocation* _location;
+}
+@end
+
+@implementation NIWTinyLFUEntry
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIWTinyLFUEvictionPolicy
+
+@synthesize sketch          = _sketch;
+@synthesize windowRatio     = _windowRatio;
+@synthesize protectedRatio  = _protectedRatio;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_sketch);
+  NI_RELEASE_SAFELY(_entries);
+  NI_RELEASE_SAFELY(_window);
+  NI_RELEASE_SAFELY(_probation);
+  NI_RELEASE_SAFELY(_protected);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithExpectedNumberOfObjects:0];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithExpectedNumberOfObjects:(NSUInteger)expectedNumberOfObjects {
+  if ((self = [super init])) {
+    _sketch = [[NIFrequencySketch alloc] initWithExpectedNumberOfObjects:expectedNumberOfObjects];
+    _entries = [[NSMutableDictionary alloc] initWithCapacity:expectedNumberOfObjects];
+    _window = [[NILinkedList alloc] init];
+    _probation = [[NILinkedList alloc] init];
+    _protected = [[NILinkedList alloc] init];
+    _windowRatio = 0.01;
+    _protectedRatio = 0.8;
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NILinkedList *)listForSegment:(NIWTinyLFUSegment)segment {
+  switch (segment) {
+    case NIWTinyLFUSegmentWindow:     return _window;
+    case NIWTinyLFUSegmentProbation:  return _probation;
+    case NIWTinyLFUSegmentProtected:  return _protected;
+  }
+  return nil;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)moveEntry:(NIWTinyLFUEntry *)entry withName:(NSString *)name toSegment:(NIWTinyLFUSegment)segment {
+  // The lists retain the name, so keep it alive while it moves between them.
+  [[name retain] autorelease];
+  [[self listForSegment:entry->_segment] removeObjectAtLocation:entry->_location];
+  entry->_segment = segment;
+  entry->_location = [[self listForSegment:segment] addObject:name];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didInsertObjectWithName:(NSString *)name {
+  NIDASSERT(nil == [_entries objectForKey:name]);
+  [_sketch recordEventForName:name];
+
+  NIWTinyLFUEntry* entry = [[NIWTinyLFUEntry alloc] init];
+  entry->_segment = NIWTinyLFUSegmentWindow;
+  entry->_location = [_window addObject:name];
+  [_entries setObject:entry forKey:name];
+  [entry release];
+
+  // Objects leaving the window join the tail of probation, where they duel the head of
+  // probation the next time something has to be evicted.
+  NSUInteger maxWindowCount = MAX(1, (NSUInteger)([_entries count] * _windowRatio));
+  while ([_window count] > maxWindowCount) {
+    NSString* admittedName = [_window firstObject];
+    [self moveEntry: [_entries objectForKey:admittedName]
+           withName: admittedName
+          toSegment: NIWTinyLFUSegmentProbation];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didAccessObjectWithName:(NSString *)name {
+  [_sketch recordEventForName:name];
+
+  NIWTinyLFUEntry* entry = [_entries objectForKey:name];
+  if (nil == entry) {
+    return;
+  }
+
+  if (NIWTinyLFUSegmentProbation == entry->_segment) {
+    // A second hit while on probation earns a place in the protected segment.
+    [self moveEntry:entry withName:name toSegment:NIWTinyLFUSegmentProtected];
+
+    NSUInteger mainCount = [_probation count] + [_protected count];
+    NSUInteger maxProtectedCount = MAX(1, (NSUInteger)(mainCount * _protectedRatio));
+    while ([_protected count] > maxProtectedCount) {
+      NSString* demotedName = [_protected firstObject];
+      [self moveEntry: [_entries objectForKey:demotedName]
+             withName: demotedName
+            toSegment: NIWTinyLFUSegmentProbation];
+    }
+
+  } else {
+    [[self listForSegment:entry->_segment] moveObjectAtLocationToTail:entry->_location];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didRemoveObjectWithName:(NSString *)name {
+  NIWTinyLFUEntry* entry = [_entries objectForKey:name];
+  if (nil == entry) {
+    return;
+  }
+  [[name retain] autorelease];
+  [[self listForSegment:entry->_segment] removeObjectAtLocation:entry->_location];
+  [_entries removeObjectForKey:name];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didRemoveAllObjects {
+  [_entries removeAllObjects];
+  [_window removeAllObjects];
+  [_probation removeAllObjects];
+  [_protected removeAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSString *)nameOfObjectToEvict {
+  if ([_probation count] > 1) {
+    // The most recently admitted object has to be more popular than the oldest object on
+    // probation to stay. Ties go to the incumbent.
+    NSString* candidate = [_probation lastObject];
+    NSString* victim = [_probation firstObject];
+    return ([_sketch frequencyForName:candidate] > [_sketch frequencyForName:victim]
+            ? victim
+            : candidate);
+  }
+
+  if ([_probation count] > 0) {
+    return [_probation firstObject];
+  }
+  if ([_protected count] > 0) {
+    return [_protected firstObject];
+  }
+  return [_window firstObject];
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIMemoryCacheEvictionSimulator
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSArray *)traceWithContentsOfFile:(NSString *)path {
+  NSString* contents = [NSString stringWithContentsOfFile: path
+                                                 encoding: NSUTF8StringEncoding
+                                                    error: nil];
+  if (nil == contents) {
+    return nil;
+  }
+
+  NSMutableArray* trace = [NSMutableArray array];
+  for (NSString* line in [contents componentsSeparatedByCharactersInSet:
+                          [NSCharacterSet newlineCharacterSet]]) {
+    if ([line length] > 0) {
+      [trace addObject:line];
+    }
+  }
+  return trace;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (double)hitRateForTrace:(NSArray *)trace
+                 capacity:(NSUInteger)capacity
+                   policy:(id<NIMemoryCacheEvictionPolicy>)policy {
+  if (0 == [trace count]) {
+    return 0;
+  }
+
+  NSMutableSet* residentNames = [[NSMutableSet alloc] initWithCapacity:capacity];
+  NSUInteger numberOfHits = 0;
+
+  for (NSString* name in trace) {
+    @autoreleasepool {
+      if ([residentNames containsObject:name]) {
+        ++numberOfHits;
+        [policy didAccessObjectWithName:name];
+
+      } else {
+        [residentNames addObject:name];
+        [policy didInsertObjectWithName:name];
+
+        while ([residentNames count] > capacity) {
+          NSString* victim = [[[policy nameOfObjectToEvict] retain] autorelease];
+          NIDASSERT(nil != victim);
+          if (nil == victim) {
+            break;
+          }
+          [residentNames removeObject:victim];
+          [policy didRemoveObjectWithName:victim];
+        }
+      }
+    }
+  }
+
+  NI_RELEASE_SAFELY(residentNames);
+
+  return (double)numberOfHits / (double)[trace count];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSDictionary *)hitRatesForTrace:(NSArray *)trace
+                          capacity:(NSUInteger)capacity
+                     policyClasses:(NSArray *)policyClasses {
+  NSMutableDictionary* hitRates = [NSMutableDictionary dictionaryWithCapacity:[policyClasses count]];
+
+  for (Class policyClass in policyClasses) {
+    id<NIMemoryCacheEvictionPolicy> policy = nil;
+    if ([policyClass instancesRespondToSelector:@selector(initWithExpectedNumberOfObjects:)]) {
+      policy = [[policyClass alloc] initWithExpectedNumberOfObjects:capacity];
+
+    } else {
+      policy = [[policyClass alloc] init];
+    }
+
+    double hitRate = [self hitRateForTrace:trace capacity:capacity policy:policy];
+    [hitRates setObject: [NSNumber numberWithDouble:hitRate]
+                 forKey: NSStringFromClass(policyClass)];
+
+    NI_RELEASE_SAFELY(policy);
+  }
+
+  return hitRates;
+}
+
+
+@end
@@ -0,0 +1,195 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <pthread.h>
+
+/**
+ * For coordinating how caches give memory back.
+ *
+ * @ingroup NimbusCore
+ * @defgroup Core-Memory-Governor Memory Governor
+ * @{
+ *
+ * Left alone, every cache and recycler waits for the memory warning and then purges itself,
+ * all at once, no matter how cheap it is to keep or how expensive it is to rebuild. The memory
+ * governor watches the app's resident memory and starts trimming before the OS warns us. It
+ * trims in steps, and takes from the least valuable objects first.
+ *
+ * NIMemoryCache, NIConcurrentMemoryCache and NIViewRecycler register themselves with
+ * Nimbus::memoryGovernor when they are created, at NIMemoryPriorityNormal.
+ */
+
+typedef enum {
+  NIMemoryPressureLevelNone,
+  NIMemoryPressureLevelSoft,
+  NIMemoryPressureLevelHard,
+  NIMemoryPressureLevelCritical,
+} NIMemoryPressureLevel;
+
+// Objects with a higher priority are trimmed later.
+typedef NSInteger NIMemoryPriority;
+static const NIMemoryPriority NIMemoryPriorityLow = -100;
+static const NIMemoryPriority NIMemoryPriorityNormal = 0;
+static const NIMemoryPriority NIMemoryPriorityHigh = 100;
+
+/**
+ * An object that holds memory it can give back when asked.
+ */
+@protocol NIMemoryGovernedObject <NSObject>
+@required
+
+- (unsigned long long)memoryCost;
+- (void)reduceMemoryCostTo:(unsigned long long)memoryCost;
+- (void)reduceMemoryUsage;
+
+@end
+
+/**
+ * Samples resident memory and trims registered objects at graduated pressure levels.
+ *
+ * All trimming happens on the main thread.
+ */
+@interface NIMemoryGovernor : NSObject {
+@private
+  pthread_mutex_t       _lock;
+  NSMutableArray*       _entries;
+
+  NSTimer*              _sampleTimer;
+  NSTimeInterval        _sampleInterval;
+
+  unsigned long long    _softLimit;
+  unsigned long long    _hardLimit;
+  unsigned long long    _criticalLimit;
+
+  NIMemoryPressureLevel _pressureLevel;
+  unsigned long long    _memoryCostAfterLastTrim;
+}
+
+- (void)registerObject:(id<NIMemoryGovernedObject>)object withPriority:(NIMemoryPriority)priority;
+- (void)unregisterObject:(id<NIMemoryGovernedObject>)object;
+- (void)setPriority:(NIMemoryPriority)priority forObject:(id<NIMemoryGovernedObject>)object;
+
+- (unsigned long long)memoryCost;
+
+@property (nonatomic, readwrite, assign) unsigned long long softLimit;
+@property (nonatomic, readwrite, assign) unsigned long long hardLimit;
+@property (nonatomic, readwrite, assign) unsigned long long criticalLimit;
+
+@property (nonatomic, readwrite, assign) NSTimeInterval sampleInterval; // default: 2
+- (void)startSampling;
+- (void)stopSampling;
+
+@property (nonatomic, readonly, assign) NIMemoryPressureLevel pressureLevel;
+- (void)sampleResidentMemory;
+- (void)applyPressureLevel:(NIMemoryPressureLevel)pressureLevel;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**@}*/// End of Memory Governor //////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+/** @name Giving Memory Back */
+
+/**
+ * The number of bytes this object could give back.
+ *
+ * Objects that cannot measure what they hold may return 0. They are then only asked to
+ * reduceMemoryUsage at the hard and critical levels.
+ *
+ *      @fn NIMemoryGovernedObject::memoryCost
+ */
+
+/**
+ * Trims the object until its memoryCost is at most the given number of bytes.
+ *
+ *      @fn NIMemoryGovernedObject::reduceMemoryCostTo:
+ */
+
+/**
+ * Does what the object would otherwise do on a memory warning.
+ *
+ *      @fn NIMemoryGovernedObject::reduceMemoryUsage
+ */
+
+
+/** @name Registering Objects */
+
+/**
+ * Starts governing an object.
+ *
+ * The object is not retained. It must unregister itself before it is deallocated.
+ *
+ *      @fn NIMemoryGovernor::registerObject:withPriority:
+ */
+
+/**
+ * Changes the priority of a registered object.
+ *
+ * For example, thumbnails that are cheap to keep and visible in a scrubber should outlive
+ * off-screen high-resolution images, so their cache gets NIMemoryPriorityHigh.
+ *
+ *      @fn NIMemoryGovernor::setPriority:forObject:
+ */
+
+/**
+ * The sum of the memoryCost of every registered object.
+ *
+ *      @fn NIMemoryGovernor::memoryCost
+ */
+
+
+/** @name Pressure Levels */
+
+/**
+ * The resident memory sizes, in bytes, at which each pressure level begins.
+ *
+ * The defaults are a quarter, a third and two fifths of the device's physical memory.
+ *
+ *      @fn NIMemoryGovernor::softLimit
+ */
+
+/**
+ * The pressure level found by the last sample.
+ *
+ *      @fn NIMemoryGovernor::pressureLevel
+ */
+
+/**
+ * Reads the app's resident memory and applies the matching pressure level.
+ *
+ * Trimming happens when the level rises. While the level stays above
+ * NIMemoryPressureLevelNone, anything that has grown since the last trim is trimmed back.
+ * Called periodically once sampling has started, which it does when the governor is created.
+ *
+ *      @fn NIMemoryGovernor::sampleResidentMemory
+ */
+
+/**
+ * Trims the registered objects for a pressure level, regardless of resident memory.
+ *
+ * - Soft: frees a quarter of the governed memory cost.
+ * - Hard: frees half of it, then asks every object to reduceMemoryUsage.
+ * - Critical: frees three quarters of it, then asks every object to reduceMemoryUsage.
+ *
+ * Memory is taken from the lowest priority objects first. A memory warning applies
+ * NIMemoryPressureLevelCritical.
+ *
+ *      @fn NIMemoryGovernor::applyPressureLevel:
+ */
@@ -0,0 +1,325 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIMemoryGovernor.h"
+
+#import "NIDebuggingTools.h"
+#import "NIDeviceInfo.h"
+#import "NIPreprocessorMacros.h"
+
+#import <UIKit/UIKit.h>
+
+static const NSTimeInterval kDefaultSampleInterval = 2;
+
+
+/**
+ * @brief A registered object and its priority.
+ */
+@interface NIMemoryGovernorEntry : NSObject {
+@public
+  // Not retained. Cleared when the object unregisters.
+  id<NIMemoryGovernedObject>  _object;
+  NIMemoryPriority            _priority;
+}
+@end
+
+@implementation NIMemoryGovernorEntry
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static NSInteger NIMemoryGovernorEntryCompare(NIMemoryGovernorEntry* entry1,
+                                              NIMemoryGovernorEntry* entry2,
+                                              void* context) {
+  if (entry1->_priority < entry2->_priority) {
+    return NSOrderedAscending;
+
+  } else if (entry1->_priority > entry2->_priority) {
+    return NSOrderedDescending;
+  }
+  return NSOrderedSame;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIMemoryGovernor
+
+@synthesize softLimit       = _softLimit;
+@synthesize hardLimit       = _hardLimit;
+@synthesize criticalLimit   = _criticalLimit;
+@synthesize sampleInterval  = _sampleInterval;
+@synthesize pressureLevel   = _pressureLevel;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+  [_sampleTimer invalidate];
+  NI_RELEASE_SAFELY(_sampleTimer);
+  NI_RELEASE_SAFELY(_entries);
+  pthread_mutex_destroy(&_lock);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    // Trimming an object can release another object that unregisters on the same thread.
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&_lock, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+
+    _entries = [[NSMutableArray alloc] init];
+    _sampleInterval = kDefaultSampleInterval;
+
+    unsigned long long physicalMemory = [[NSProcessInfo processInfo] physicalMemory];
+    _softLimit = physicalMemory / 4;
+    _hardLimit = physicalMemory / 3;
+    _criticalLimit = physicalMemory * 2 / 5;
+
+    [[NSNotificationCenter defaultCenter] addObserver: self
+                                             selector: @selector(didReceiveMemoryWarning)
+                                                 name: UIApplicationDidReceiveMemoryWarningNotification
+                                               object: nil];
+
+    [self performSelectorOnMainThread: @selector(startSampling)
+                           withObject: nil
+                        waitUntilDone: NO];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Registering Objects
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NIMemoryGovernorEntry *)entryForObject:(id<NIMemoryGovernedObject>)object {
+  for (NIMemoryGovernorEntry* entry in _entries) {
+    if (entry->_object == object) {
+      return entry;
+    }
+  }
+  return nil;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)registerObject:(id<NIMemoryGovernedObject>)object withPriority:(NIMemoryPriority)priority {
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return;
+  }
+
+  pthread_mutex_lock(&_lock);
+  NIMemoryGovernorEntry* entry = [self entryForObject:object];
+  if (nil == entry) {
+    entry = [[[NIMemoryGovernorEntry alloc] init] autorelease];
+    entry->_object = object;
+    [_entries addObject:entry];
+  }
+  entry->_priority = priority;
+  pthread_mutex_unlock(&_lock);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)unregisterObject:(id<NIMemoryGovernedObject>)object {
+  pthread_mutex_lock(&_lock);
+  NIMemoryGovernorEntry* entry = [self entryForObject:object];
+  if (nil != entry) {
+    // A trim in progress may still hold the entry.
+    entry->_object = nil;
+    [_entries removeObjectIdenticalTo:entry];
+  }
+  pthread_mutex_unlock(&_lock);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setPriority:(NIMemoryPriority)priority forObject:(id<NIMemoryGovernedObject>)object {
+  pthread_mutex_lock(&_lock);
+  NIMemoryGovernorEntry* entry = [self entryForObject:object];
+  NIDASSERT(nil != entry);
+  entry->_priority = priority;
+  pthread_mutex_unlock(&_lock);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (unsigned long long)memoryCost {
+  pthread_mutex_lock(&_lock);
+  unsigned long long memoryCost = 0;
+  for (NIMemoryGovernorEntry* entry in _entries) {
+    memoryCost += [entry->_object memoryCost];
+  }
+  pthread_mutex_unlock(&_lock);
+  return memoryCost;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Trimming
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)trimMemoryCostTo:(unsigned long long)targetMemoryCost {
+  pthread_mutex_lock(&_lock);
+  NSArray* entries = [_entries sortedArrayUsingFunction:NIMemoryGovernorEntryCompare context:nil];
+  unsigned long long memoryCost = [self memoryCost];
+
+  // Lowest priority first. An object only gives up what is still needed.
+  for (NIMemoryGovernorEntry* entry in entries) {
+    if (memoryCost <= targetMemoryCost) {
+      break;
+    }
+    id<NIMemoryGovernedObject> object = entry->_object;
+    if (nil == object) {
+      continue;
+    }
+
+    unsigned long long objectMemoryCost = [object memoryCost];
+    if (0 == objectMemoryCost) {
+      continue;
+    }
+    unsigned long long excess = memoryCost - targetMemoryCost;
+    unsigned long long objectTarget = (objectMemoryCost > excess) ? objectMemoryCost - excess : 0;
+    [object reduceMemoryCostTo:objectTarget];
+
+    unsigned long long remaining = (nil != entry->_object) ? [object memoryCost] : 0;
+    unsigned long long freed = objectMemoryCost - MIN(objectMemoryCost, remaining);
+    memoryCost -= MIN(memoryCost, freed);
+  }
+  pthread_mutex_unlock(&_lock);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)applyPressureLevel:(NIMemoryPressureLevel)pressureLevel {
+  NIDASSERT([NSThread isMainThread]);
+  if (NIMemoryPressureLevelNone == pressureLevel) {
+    return;
+  }
+
+  unsigned long long memoryCost = [self memoryCost];
+  unsigned long long fractionToKeep[] = { 4, 3, 2, 1 }; // In quarters.
+  [self trimMemoryCostTo:memoryCost * fractionToKeep[pressureLevel] / 4];
+
+  if (pressureLevel >= NIMemoryPressureLevelHard) {
+    pthread_mutex_lock(&_lock);
+    NSArray* entries = [[_entries copy] autorelease];
+    for (NIMemoryGovernorEntry* entry in entries) {
+      [entry->_object reduceMemoryUsage];
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+  _memoryCostAfterLastTrim = [self memoryCost];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NIMemoryPressureLevel)pressureLevelForResidentMemory:(unsigned long long)bytes {
+  if (_criticalLimit > 0 && bytes >= _criticalLimit) {
+    return NIMemoryPressureLevelCritical;
+
+  } else if (_hardLimit > 0 && bytes >= _hardLimit) {
+    return NIMemoryPressureLevelHard;
+
+  } else if (_softLimit > 0 && bytes >= _softLimit) {
+    return NIMemoryPressureLevelSoft;
+  }
+  return NIMemoryPressureLevelNone;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)sampleResidentMemory {
+  NIDASSERT([NSThread isMainThread]);
+  unsigned long long residentMemory = [NIDeviceInfo bytesOfResidentMemory];
+  if (0 == residentMemory) {
+    return; // COV_NF_LINE
+  }
+
+  NIMemoryPressureLevel pressureLevel = [self pressureLevelForResidentMemory:residentMemory];
+  if (pressureLevel > _pressureLevel) {
+    [self applyPressureLevel:pressureLevel];
+
+  } else if (NIMemoryPressureLevelNone != pressureLevel) {
+    // Freed memory rarely shows up in the resident size right away, so rather than trimming
+    // again on every sample, only take back what has been added since the last trim.
+    if ([self memoryCost] > _memoryCostAfterLastTrim) {
+      [self trimMemoryCostTo:_memoryCostAfterLastTrim];
+    }
+  }
+  _pressureLevel = pressureLevel;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didReceiveMemoryWarning {
+  [self applyPressureLevel:NIMemoryPressureLevelCritical];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Sampling
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)startSampling {
+  NIDASSERT([NSThread isMainThread]);
+  [self stopSampling];
+
+  _sampleTimer = [[NSTimer scheduledTimerWithTimeInterval: _sampleInterval
+                                                   target: self
+                                                 selector: @selector(sampleResidentMemory)
+                                                 userInfo: nil
+                                                  repeats: YES] retain];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)stopSampling {
+  [_sampleTimer invalidate];
+  NI_RELEASE_SAFELY(_sampleTimer);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setSampleInterval:(NSTimeInterval)sampleInterval {
+  _sampleInterval = sampleInterval;
+  if (nil != _sampleTimer) {
+    [self startSampling];
+  }
+}
+
+
+@end
@@ -18,6 +18,7 @@
 
 #import "NIOperations+Subclassing.h"
 #import "JSONKit.h"
+#import "NIDebuggingTools.h"
 
 //
 // Compiler errors? JSONKit.h file not found?
@@ -36,8 +37,13 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)operationWillFinish {
   NSError* error = nil;
-  self.processedObject = [[JSONDecoder decoder] objectWithData:self.data
-                                                         error:&error];
+  // self.data is never mutated once the request has finished, so the parsed strings can
+  // reference its bytes directly instead of each copying them.
+  JSONDecoder* decoder = [JSONDecoder decoderWithParseOptions:JKParseOptionNoCopyStrings];
+  NIDTRACEBEGIN("NINetworkJSONRequest.parse");
+  self.processedObject = [decoder objectWithData:self.data
+                                           error:&error];
+  NIDTRACEEND("NINetworkJSONRequest.parse");
 
   self.lastError = error;
 
@@ -69,6 +69,23 @@
 + (void)addOverviewToWindow:(UIWindow *)window;
 
 
+#pragma mark Graphing Memory Caches /** @name Graphing Memory Caches */
+
+/**
+ * Adds a page that graphs the hit ratio of the given cache.
+ *
+ * The cache may be an NIMemoryCache or an NIConcurrentMemoryCache. Caches may be added before
+ * or after the Overview is added to a window; the page appears once the Overview exists.
+ * The page retains the cache until it is removed with removeMemoryCache:.
+ */
++ (void)addMemoryCache:(id)cache withTitle:(NSString *)title;
+
+/**
+ * Removes the page added for the given cache.
+ */
++ (void)removeMemoryCache:(id)cache;
+
+
 #pragma mark Accessing State Information /** @name Accessing State Information */
 
 /**
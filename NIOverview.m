@@ -33,6 +33,9 @@ static NSTimer* sOverviewHeartbeatTimer = nil;
 static NIOverviewView* sOverviewView = nil;
 static NIOverviewLogger* sOverviewLogger = nil;
 
+// Pages for the caches added with addMemoryCache:withTitle:, kept across Overview views.
+static NSMutableArray* sMemoryCachePages = nil;
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -184,18 +187,18 @@ void NIOverviewLogMethod(const char* message, unsigned length, BOOL withSyslogBa
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 + (void)didReceiveMemoryWarning {
-  [sOverviewLogger addEventLog:
-   [[[NIOverviewEventLogEntry alloc] initWithType:NIOverviewEventDidReceiveMemoryWarning]
-    autorelease]];
+  NIOverviewEventLog logEntry;
+  logEntry.timestamp = NIOverviewLogTimestamp();
+  logEntry.type = NIOverviewEventDidReceiveMemoryWarning;
+  [sOverviewLogger addEventLog:logEntry];
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 + (void)heartbeat {
   [NIDeviceInfo beginCachedDeviceInfo];
-  NIOverviewDeviceLogEntry* logEntry =
-  [[[NIOverviewDeviceLogEntry alloc] initWithTimestamp:[NSDate date]]
-   autorelease];
+  NIOverviewDeviceLog logEntry;
+  logEntry.timestamp = NIOverviewLogTimestamp();
   logEntry.bytesOfTotalDiskSpace = [NIDeviceInfo bytesOfTotalDiskSpace];
   logEntry.bytesOfFreeDiskSpace = [NIDeviceInfo bytesOfFreeDiskSpace];
   logEntry.bytesOfFreeMemory = [NIDeviceInfo bytesOfFreeMemory];
@@ -271,6 +274,11 @@ void NIOverviewLogMethod(const char* message, unsigned length, BOOL withSyslogBa
   
   [sOverviewView addPageView:[NIOverviewMemoryPageView page]];
   [sOverviewView addPageView:[NIOverviewDiskPageView page]];
+  [sOverviewView addPageView:[NIOverviewMemoryCachePageView pageWithCache:[Nimbus imageMemoryCache]]];
+  for (NIOverviewMemoryCachePageView* page in sMemoryCachePages) {
+    [sOverviewView addPageView:page];
+  }
+  [sOverviewView addPageView:[NIOverviewFramePageView page]];
   [sOverviewView addPageView:[NIOverviewConsoleLogPageView page]];
   [sOverviewView addPageView:[NIOverviewMaxLogLevelPageView page]];
 
@@ -286,6 +294,43 @@ void NIOverviewLogMethod(const char* message, unsigned length, BOOL withSyslogBa
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (void)addMemoryCache:(id)cache withTitle:(NSString *)title {
+#ifdef DEBUG
+  NIDASSERT([NSThread isMainThread]);
+  NIDASSERT(nil != cache);
+  if (nil == cache) {
+    return;
+  }
+
+  if (nil == sMemoryCachePages) {
+    sMemoryCachePages = [[NSMutableArray alloc] init];
+  }
+
+  NIOverviewMemoryCachePageView* page = [NIOverviewMemoryCachePageView pageWithCache:cache];
+  if (nil != title) {
+    page.pageTitle = title;
+  }
+  [sMemoryCachePages addObject:page];
+  [sOverviewView addPageView:page];
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (void)removeMemoryCache:(id)cache {
+#ifdef DEBUG
+  NIDASSERT([NSThread isMainThread]);
+  for (NIOverviewMemoryCachePageView* page in [[sMemoryCachePages copy] autorelease]) {
+    if (page.cache == cache) {
+      [sOverviewView removePageView:page];
+      [sMemoryCachePages removeObjectIdenticalTo:page];
+    }
+  }
+#endif
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 + (NIOverviewLogger *)logger {
 #ifdef DEBUG
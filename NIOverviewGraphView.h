@@ -26,6 +26,22 @@
 @interface NIOverviewGraphView : UIView {
 @private
   id<NIOverviewGraphViewDataSource> _dataSource;
+
+  // The background and gloss, drawn once for each size.
+  CGImageRef _chromeImage;
+
+  // The line, in a bitmap that scrolls left as new points are added on the right.
+  CGContextRef _plotContext;
+  CGFloat _plotScale;
+  double _plottedXOrigin;
+  double _plottedXRange;
+  double _plottedYOrigin;
+  double _plottedYRange;
+  double _lastPlottedX;
+  double _lastPlottedY;
+
+  CGPoint* _points;
+  NSUInteger _pointsCapacity;
 }
 
 /**
@@ -77,4 +93,39 @@
                       xValue: (CGFloat *)xValue
                        color: (UIColor **)color;
 
+@optional
+
+/**
+ * Fetches where x = 0 lies on an axis that does not move between updates.
+ *
+ * For a graph of the last minute of logs, this is the time of the first log.
+ *
+ * Implement this and graphViewYOrigin: to let the graph view keep what it has already
+ * plotted. Each update then scrolls the plotted line and adds only the new points, instead
+ * of plotting every point again. The view still redraws everything when the ranges change
+ * by too much.
+ */
+- (double)graphViewXOrigin:(NIOverviewGraphView *)graphView;
+
+/**
+ * Fetches where y = 0 lies on an axis that does not move between updates.
+ *
+ * Called after graphViewYRange:.
+ *
+ *      @see graphViewXOrigin:
+ */
+- (double)graphViewYOrigin:(NIOverviewGraphView *)graphView;
+
+/**
+ * The data source should move its point iterator to the first point whose x value is greater
+ * than xValue.
+ *
+ * When the graph view only needs the points added since its last update, it calls this
+ * instead of resetPointIterator. Implement it when the data source can find that point
+ * without walking every point before it, so that each update costs only the new points.
+ *
+ *      @see graphViewXOrigin:
+ */
+- (void)resetPointIteratorAfterXValue:(double)xValue;
+
 @end
@@ -16,8 +16,87 @@
 
 #import "NIOverviewGraphView.h"
 
+#import "NISDKAvailability.h"
+
 #import <QuartzCore/QuartzCore.h>
 
+// The most points that are stroked across each pixel of the graph's width. Older points are
+// thinned out to this many when the graph is redrawn.
+static const NSUInteger kPlotPointsPerPixel = 2;
+
+// How much the x range may drift before the plotted line is drawn again at the new scale.
+static const double kPlotXRangeTolerance = 0.1;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Creates a bitmap context that is drawn into with the coordinates of a view of the given size.
+static CGContextRef NIOverviewGraphCreateBitmapContext(CGSize size, CGFloat scale) {
+  size_t width = (size_t)ceilf(size.width * scale);
+  size_t height = (size_t)ceilf(size.height * scale);
+
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, width * 4, colorSpace,
+                                               kCGImageAlphaPremultipliedLast);
+  CGColorSpaceRelease(colorSpace);
+
+  CGContextTranslateCTM(context, 0, height);
+  CGContextScaleCTM(context, scale, -scale);
+  return context;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Thins points out to at most threshold of them with the Largest-Triangle-Three-Buckets
+// algorithm, which keeps the peaks and dips that make the line's shape. The first and last
+// points are kept, and each bucket in between gives up the point that forms the largest
+// triangle with the point picked before it and the average of the next bucket.
+//
+// Works in place and returns the number of points kept.
+static NSUInteger NIOverviewGraphDownsamplePoints(CGPoint* points,
+                                                  NSUInteger numberOfPoints,
+                                                  NSUInteger threshold) {
+  if (threshold >= numberOfPoints || threshold < 3) {
+    return numberOfPoints;
+  }
+
+  double bucketSize = (double)(numberOfPoints - 2) / (double)(threshold - 2);
+  CGPoint lastKeptPoint = points[0];
+  NSUInteger numberOfKeptPoints = 1;
+
+  for (NSUInteger bucket = 0; bucket < threshold - 2; ++bucket) {
+    NSUInteger nextStart = (NSUInteger)floor((bucket + 1) * bucketSize) + 1;
+    NSUInteger nextEnd = MIN((NSUInteger)floor((bucket + 2) * bucketSize) + 1, numberOfPoints);
+    double averageX = 0;
+    double averageY = 0;
+    for (NSUInteger ix = nextStart; ix < nextEnd; ++ix) {
+      averageX += points[ix].x;
+      averageY += points[ix].y;
+    }
+    averageX /= (double)(nextEnd - nextStart);
+    averageY /= (double)(nextEnd - nextStart);
+
+    NSUInteger start = (NSUInteger)floor(bucket * bucketSize) + 1;
+    NSUInteger end = nextStart;
+    NSUInteger keptIndex = start;
+    double largestArea = -1;
+    for (NSUInteger ix = start; ix < end; ++ix) {
+      double area = fabs((lastKeptPoint.x - averageX) * (points[ix].y - lastKeptPoint.y)
+                         - (lastKeptPoint.x - points[ix].x) * (averageY - lastKeptPoint.y));
+      if (area > largestArea) {
+        largestArea = area;
+        keptIndex = ix;
+      }
+    }
+
+    // Every later read is past this bucket, so the kept points can be packed at the front.
+    lastKeptPoint = points[keptIndex];
+    points[numberOfKeptPoints++] = lastKeptPoint;
+  }
+
+  points[numberOfKeptPoints++] = points[numberOfPoints - 1];
+  return numberOfKeptPoints;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -27,6 +106,16 @@
 @synthesize dataSource = _dataSource;
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  CGImageRelease(_chromeImage);
+  CGContextRelease(_plotContext);
+  free(_points);
+
+  [super dealloc];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (id)initWithFrame:(CGRect)frame {
   if ((self = [super initWithFrame:frame])) {
@@ -39,41 +128,237 @@
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)drawGraphWithContext:(CGContextRef)context {
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Plotting
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGPoint)plotPointWithX:(double)x y:(double)y {
   CGSize contentSize = self.bounds.size;
+  CGFloat scaledX = (CGFloat)((x - _plottedXOrigin) / _plottedXRange);
+  CGFloat scaledY = (CGFloat)((y - _plottedYOrigin) / _plottedYRange);
+  return CGPointMake(floorf(scaledX * contentSize.width) - 0.5f,
+                     contentSize.height
+                     - floorf((scaledY * 0.8f + 0.1f) * contentSize.height) - 0.5f);
+}
 
-  CGFloat xRange = [self.dataSource graphViewXRange:self];
-  CGFloat yRange = [self.dataSource graphViewYRange:self];
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)addPoint:(CGPoint)point atIndex:(NSUInteger)index {
+  if (index >= _pointsCapacity) {
+    _pointsCapacity = MAX(_pointsCapacity * 2, 256);
+    _points = realloc(_points, _pointsCapacity * sizeof(CGPoint));
+  }
+  _points[index] = point;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)strokePoints:(NSUInteger)numberOfPoints maxNumberOfPoints:(NSUInteger)maxNumberOfPoints {
+  numberOfPoints = NIOverviewGraphDownsamplePoints(_points, numberOfPoints, maxNumberOfPoints);
+  if (numberOfPoints < 2) {
+    return;
+  }
+
+  CGContextSetLineWidth(_plotContext, 1);
+  CGContextSetShouldAntialias(_plotContext, YES);
+  CGContextAddLines(_plotContext, _points, numberOfPoints);
+  CGContextSetStrokeColorWithColor(_plotContext, [UIColor colorWithWhite:1 alpha:0.6f].CGColor);
+  CGContextStrokePath(_plotContext);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)releasePlot {
+  CGContextRelease(_plotContext);
+  _plotContext = nil;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)canAppendToPlotWithXOrigin: (double)xOrigin
+                            xRange: (double)xRange
+                           yOrigin: (double)yOrigin
+                            yRange: (double)yRange {
+  CGSize contentSize = self.bounds.size;
+  CGFloat scale = NIScreenScale();
+  if (nil == _plotContext
+      || _plotScale != scale
+      || CGBitmapContextGetWidth(_plotContext) != (size_t)ceilf(contentSize.width * scale)
+      || CGBitmapContextGetHeight(_plotContext) != (size_t)ceilf(contentSize.height * scale)) {
+    return NO;
+  }
+
+  // The line was thrown away or started over.
+  if (xOrigin + xRange < _lastPlottedX) {
+    return NO;
+  }
+
+  if (fabs(xRange - _plottedXRange) > _plottedXRange * kPlotXRangeTolerance) {
+    return NO;
+  }
+
+  // The line is plotted between 10% and 90% of the height, so it can go a little past the
+  // plotted range before it leaves the graph.
+  double yMargin = _plottedYRange * 0.1 / 0.8;
+  return (yOrigin >= _plottedYOrigin - yMargin
+          && yOrigin + yRange <= _plottedYOrigin + _plottedYRange + yMargin
+          && yRange >= _plottedYRange / 2);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)plotWithXOrigin: (double)xOrigin
+                 xRange: (double)xRange
+                yOrigin: (double)yOrigin
+                 yRange: (double)yRange {
+  CGSize contentSize = self.bounds.size;
+  CGFloat scale = NIScreenScale();
+  if (nil == _plotContext
+      || _plotScale != scale
+      || CGBitmapContextGetWidth(_plotContext) != (size_t)ceilf(contentSize.width * scale)
+      || CGBitmapContextGetHeight(_plotContext) != (size_t)ceilf(contentSize.height * scale)) {
+    [self releasePlot];
+    _plotContext = NIOverviewGraphCreateBitmapContext(contentSize, scale);
+    _plotScale = scale;
+
+  } else {
+    CGContextClearRect(_plotContext, CGRectMake(0, 0, contentSize.width, contentSize.height));
+  }
+
+  _plottedXOrigin = xOrigin;
+  _plottedXRange = xRange;
+  _plottedYOrigin = yOrigin;
+  _plottedYRange = yRange;
+  _lastPlottedX = xOrigin;
+  _lastPlottedY = yOrigin;
+
+  NSUInteger numberOfPoints = 0;
+  CGPoint point = CGPointZero;
   [self.dataSource resetPointIterator];
+  while ([self.dataSource nextPointInGraphView:self point:&point]) {
+    _lastPlottedX = xOrigin + point.x;
+    _lastPlottedY = yOrigin + point.y;
+    [self addPoint:[self plotPointWithX:_lastPlottedX y:_lastPlottedY] atIndex:numberOfPoints++];
+  }
 
-  CGContextSetLineWidth(context, 1);
-  CGContextSetShouldAntialias(context, YES);
+  NSUInteger pixelWidth = (NSUInteger)ceilf(contentSize.width * scale);
+  [self strokePoints:numberOfPoints maxNumberOfPoints:pixelWidth * kPlotPointsPerPixel];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)scrollPlotByPixels:(size_t)numberOfPixels {
+  unsigned char* data = CGBitmapContextGetData(_plotContext);
+  size_t width = CGBitmapContextGetWidth(_plotContext);
+  size_t height = CGBitmapContextGetHeight(_plotContext);
+  size_t bytesPerRow = CGBitmapContextGetBytesPerRow(_plotContext);
+  size_t bytesPerPixel = CGBitmapContextGetBitsPerPixel(_plotContext) / 8;
+  numberOfPixels = MIN(numberOfPixels, width);
+
+  size_t bytesToKeep = (width - numberOfPixels) * bytesPerPixel;
+  size_t bytesToClear = numberOfPixels * bytesPerPixel;
+  for (size_t row = 0; row < height; ++row) {
+    unsigned char* rowData = data + row * bytesPerRow;
+    memmove(rowData, rowData + bytesToClear, bytesToKeep);
+    memset(rowData + bytesToKeep, 0, bytesToClear);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)appendToPlotWithXOrigin:(double)xOrigin xRange:(double)xRange yOrigin:(double)yOrigin {
+  CGSize contentSize = self.bounds.size;
+
+  // Scroll the line along so that the newest point is on the right edge again. Only whole
+  // pixels are scrolled; the rest waits for the next update.
+  double pixelsPerX = contentSize.width * _plotScale / _plottedXRange;
+  double newestX = xOrigin + xRange;
+  double pixelsToScroll = floor((newestX - _plottedXRange - _plottedXOrigin) * pixelsPerX);
+  if (pixelsToScroll > 0) {
+    [self scrollPlotByPixels:(size_t)pixelsToScroll];
+    _plottedXOrigin += pixelsToScroll / pixelsPerX;
+  }
+
+  // The new points carry on from the last one plotted.
+  NSUInteger numberOfPoints = 0;
+  [self addPoint:[self plotPointWithX:_lastPlottedX y:_lastPlottedY] atIndex:numberOfPoints++];
 
-  BOOL isFirstPoint = YES;
   CGPoint point = CGPointZero;
+  if ([self.dataSource respondsToSelector:@selector(resetPointIteratorAfterXValue:)]) {
+    [self.dataSource resetPointIteratorAfterXValue:_lastPlottedX - xOrigin];
+
+  } else {
+    [self.dataSource resetPointIterator];
+  }
   while ([self.dataSource nextPointInGraphView:self point:&point]) {
-    CGPoint scaledPoint = CGPointMake(point.x / xRange, point.y / yRange);
-    CGPoint plotPoint = CGPointMake(floorf(scaledPoint.x * contentSize.width) - 0.5f,
-                                    contentSize.height
-                                    - floorf((scaledPoint.y * 0.8f + 0.1f)
-                                             * contentSize.height) - 0.5f);
-    if (!isFirstPoint) {
-      CGContextAddLineToPoint(context, plotPoint.x, plotPoint.y);
+    double x = xOrigin + point.x;
+    if (x > _lastPlottedX) {
+      _lastPlottedX = x;
+      _lastPlottedY = yOrigin + point.y;
+      [self addPoint:[self plotPointWithX:_lastPlottedX y:_lastPlottedY] atIndex:numberOfPoints++];
     }
-    CGContextMoveToPoint(context, plotPoint.x, plotPoint.y);
-    isFirstPoint = NO;
   }
 
-	CGContextSetStrokeColorWithColor(context, [UIColor colorWithWhite:1 alpha:0.6f].CGColor);
-	CGContextStrokePath(context);
-  
+  CGFloat newWidth = _points[numberOfPoints - 1].x - _points[0].x;
+  NSUInteger pixelWidth = (NSUInteger)ceilf(MAX(0, newWidth) * _plotScale);
+  [self strokePoints:numberOfPoints maxNumberOfPoints:(pixelWidth + 1) * kPlotPointsPerPixel];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)drawGraphWithContext:(CGContextRef)context {
+  CGSize contentSize = self.bounds.size;
+
+  CGFloat xRange = [self.dataSource graphViewXRange:self];
+  CGFloat yRange = [self.dataSource graphViewYRange:self];
+
+  // Without fixed origins there is no telling how far the line has moved since the last update.
+  BOOL canAppend = ([self.dataSource respondsToSelector:@selector(graphViewXOrigin:)]
+                    && [self.dataSource respondsToSelector:@selector(graphViewYOrigin:)]);
+  double xOrigin = canAppend ? [self.dataSource graphViewXOrigin:self] : 0;
+  double yOrigin = canAppend ? [self.dataSource graphViewYOrigin:self] : 0;
+
+  if (xRange <= 0 || yRange <= 0) {
+    [self releasePlot];
+
+  } else if (canAppend && [self canAppendToPlotWithXOrigin: xOrigin
+                                                    xRange: xRange
+                                                   yOrigin: yOrigin
+                                                    yRange: yRange]) {
+    [self appendToPlotWithXOrigin:xOrigin xRange:xRange yOrigin:yOrigin];
+
+  } else {
+    [self plotWithXOrigin:xOrigin xRange:xRange yOrigin:yOrigin yRange:yRange];
+  }
+
+  if (nil != _plotContext) {
+    CGImageRef plotImage = CGBitmapContextCreateImage(_plotContext);
+    CGContextSaveGState(context);
+    CGContextTranslateCTM(context, 0, contentSize.height);
+    CGContextScaleCTM(context, 1, -1);
+    CGContextDrawImage(context, CGRectMake(0, 0, contentSize.width, contentSize.height), plotImage);
+    CGContextRestoreGState(context);
+    CGImageRelease(plotImage);
+
+  } else {
+    _plottedXOrigin = xOrigin;
+    _plottedXRange = xRange;
+  }
+
+  if (_plottedXRange <= 0) {
+    return;
+  }
+
   [self.dataSource resetEventIterator];
 
+  CGContextSetLineWidth(context, 1);
+
   CGFloat xValue = 0;
   UIColor* color = nil;
   while ([self.dataSource nextEventInGraphView:self xValue:&xValue color:&color]) {
-    CGFloat scaledXValue = xValue / xRange;
+    CGFloat scaledXValue = (CGFloat)((xOrigin + xValue - _plottedXOrigin) / _plottedXRange);
     CGFloat plotXValue = floorf(scaledXValue * contentSize.width) - 0.5f;
     CGContextMoveToPoint(context, plotXValue, 0);
     CGContextAddLineToPoint(context, plotXValue, contentSize.height);
@@ -85,17 +370,29 @@
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)drawRect:(CGRect)rect {
-	CGContextRef context = UIGraphicsGetCurrentContext();
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Chrome
 
-  CGRect bounds = self.bounds;
-  
-  UIGraphicsPushContext(context);
 
-  [self drawGraphWithContext:context];
-  
-	CGContextSetFillColorWithColor(context, [UIColor colorWithWhite:1 alpha:0.2f].CGColor);
-	CGContextFillRect(context, bounds);
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGImageRef)chromeImage {
+  CGSize contentSize = self.bounds.size;
+  CGFloat scale = NIScreenScale();
+  if (nil != _chromeImage
+      && CGImageGetWidth(_chromeImage) == (size_t)ceilf(contentSize.width * scale)
+      && CGImageGetHeight(_chromeImage) == (size_t)ceilf(contentSize.height * scale)) {
+    return _chromeImage;
+  }
+
+  CGImageRelease(_chromeImage);
+  _chromeImage = nil;
+
+  CGRect bounds = CGRectMake(0, 0, contentSize.width, contentSize.height);
+  CGContextRef context = NIOverviewGraphCreateBitmapContext(contentSize, scale);
+
+  CGContextSetFillColorWithColor(context, [UIColor colorWithWhite:1 alpha:0.2f].CGColor);
+  CGContextFillRect(context, bounds);
 
   CGGradientRef glossGradient = nil;
   CGColorSpaceRef colorspace = nil;
@@ -119,6 +416,31 @@
   CGColorSpaceRelease(colorspace);
   colorspace = nil;
 
+  _chromeImage = CGBitmapContextCreateImage(context);
+  CGContextRelease(context);
+
+  return _chromeImage;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)drawRect:(CGRect)rect {
+	CGContextRef context = UIGraphicsGetCurrentContext();
+
+  CGRect bounds = self.bounds;
+  
+  UIGraphicsPushContext(context);
+
+  [self drawGraphWithContext:context];
+
+  // The chrome doesn't change between updates, so it's drawn once and kept as an image.
+  CGContextSaveGState(context);
+  CGContextTranslateCTM(context, 0, bounds.size.height);
+  CGContextScaleCTM(context, 1, -1);
+  CGContextDrawImage(context, CGRectMake(0, 0, bounds.size.width, bounds.size.height),
+                     [self chromeImage]);
+  CGContextRestoreGState(context);
+
   UIGraphicsPopContext();
 }
 
@@ -20,9 +20,86 @@
 
 extern NSString* const NIOverviewLoggerDidAddConsoleLog;
 
-@class NIOverviewDeviceLogEntry;
 @class NIOverviewConsoleLogEntry;
-@class NIOverviewEventLogEntry;
+
+/**
+ * A device log entry.
+ *
+ *      @ingroup Overview-Logger-Entries
+ */
+typedef struct {
+  // Seconds on the NIOverviewLogTimestamp clock.
+  NSTimeInterval timestamp;
+
+  unsigned long long bytesOfFreeMemory;
+  unsigned long long bytesOfTotalMemory;
+  unsigned long long bytesOfFreeDiskSpace;
+  unsigned long long bytesOfTotalDiskSpace;
+
+  CGFloat batteryLevel;
+  UIDeviceBatteryState batteryState;
+} NIOverviewDeviceLog;
+
+typedef enum {
+  NIOverviewEventDidReceiveMemoryWarning,
+} NIOverviewEventType;
+
+/**
+ * An event log entry.
+ *
+ *      @ingroup Overview-Logger-Entries
+ */
+typedef struct {
+  // Seconds on the NIOverviewLogTimestamp clock.
+  NSTimeInterval timestamp;
+
+  NIOverviewEventType type;
+} NIOverviewEventLog;
+
+/**
+ * A memory cache log entry.
+ *
+ *      @ingroup Overview-Logger-Entries
+ */
+typedef struct {
+  // Seconds on the NIOverviewLogTimestamp clock.
+  NSTimeInterval timestamp;
+
+  NIMemoryCacheStatistics statistics;
+} NIOverviewMemoryCacheLog;
+
+// Fixed-capacity storage for one type of log entry. Each entry must start with its
+// NIOverviewLogTimestamp timestamp. Used by NIOverviewLogger and the Overview pages.
+typedef struct {
+  char*       entries;
+  size_t      entrySize;
+  NSUInteger  mask;
+  NSUInteger  first;
+  NSUInteger  count;
+} NIOverviewLogBuffer;
+
+// Returns NO if the entries could not be allocated. The buffer must still be freed.
+BOOL NIOverviewLogBufferInit(NIOverviewLogBuffer* buffer,
+                             size_t entrySize,
+                             NSUInteger capacity);
+void NIOverviewLogBufferFree(NIOverviewLogBuffer* buffer);
+void NIOverviewLogBufferRemoveAllEntries(NIOverviewLogBuffer* buffer);
+void* NIOverviewLogBufferEntryAtIndex(const NIOverviewLogBuffer* buffer, NSUInteger index);
+void NIOverviewLogBufferPruneEntriesBefore(NIOverviewLogBuffer* buffer,
+                                           NSTimeInterval cutoffTimestamp);
+NSUInteger NIOverviewLogBufferIndexOfFirstEntryAfter(const NIOverviewLogBuffer* buffer,
+                                                     NSTimeInterval timestamp);
+void NIOverviewLogBufferAppend(NIOverviewLogBuffer* buffer, const void* entry);
+
+/**
+ * The current time on the clock used for log timestamps.
+ *
+ *      @ingroup Overview-Logger
+ *
+ * The clock counts seconds since the device started and, unlike the wall clock, never jumps
+ * when the user changes the time.
+ */
+NSTimeInterval NIOverviewLogTimestamp(void);
 
 /**
  * The Overview logger.
@@ -36,12 +113,26 @@ extern NSString* const NIOverviewLoggerDidAddConsoleLog;
  */
 @interface NIOverviewLogger : NSObject {
 @private
-  NILinkedList* _deviceLogs;
+  NIOverviewLogBuffer _deviceLogs;
   NILinkedList* _consoleLogs;
-  NILinkedList* _eventLogs;
+  NIOverviewLogBuffer _eventLogs;
   NSTimeInterval _oldestLogAge;
 }
 
+#pragma mark Creating a Logger /** @name Creating a Logger */
+
+/**
+ * Designated initializer.
+ *
+ * The memory for capacity device and event log entries is allocated up front and reused, so
+ * the logger's memory use doesn't grow however long the app runs. Once a log is full, each
+ * new entry replaces the oldest one.
+ *
+ * init uses a capacity of 1024, which holds over eight minutes of device logs at the
+ * Overview's two logs a second.
+ */
+- (id)initWithCapacity:(NSUInteger)capacity;
+
 #pragma mark Configuration Settings /** @name Configuration Settings */
 
 /**
@@ -61,7 +152,7 @@ extern NSString* const NIOverviewLoggerDidAddConsoleLog;
  *
  * This method will first prune expired entries and then add the new entry to the log.
  */
-- (void)addDeviceLog:(NIOverviewDeviceLogEntry *)logEntry;
+- (void)addDeviceLog:(NIOverviewDeviceLog)logEntry;
 
 /**
  * Add a console log.
@@ -75,17 +166,30 @@ extern NSString* const NIOverviewLoggerDidAddConsoleLog;
  *
  * This method will first prune expired entries and then add the new entry to the log.
  */
-- (void)addEventLog:(NIOverviewEventLogEntry *)logEntry;
+- (void)addEventLog:(NIOverviewEventLog)logEntry;
 
 
 #pragma mark Accessing Logs /** @name Accessing Logs */
 
 /**
- * The linked list of device logs.
+ * The number of device logs.
+ */
+- (NSUInteger)numberOfDeviceLogs;
+
+/**
+ * The device log at the given index.
  *
- * Log entries are in increasing chronological order.
+ * Log entries are in increasing chronological order. The entry is only valid until the next
+ * device log is added.
  */
-@property (nonatomic, readonly, retain) NILinkedList* deviceLogs;
+- (const NIOverviewDeviceLog *)deviceLogAtIndex:(NSUInteger)index;
+
+/**
+ * The index of the first device log with a timestamp later than the given one.
+ *
+ * Returns numberOfDeviceLogs if there is no such log. Found by binary search.
+ */
+- (NSUInteger)indexOfFirstDeviceLogAfterTimestamp:(NSTimeInterval)timestamp;
 
 /**
  * The linked list of console logs.
@@ -95,11 +199,17 @@ extern NSString* const NIOverviewLoggerDidAddConsoleLog;
 @property (nonatomic, readonly, retain) NILinkedList* consoleLogs;
 
 /**
- * The linked list of events.
+ * The number of events.
+ */
+- (NSUInteger)numberOfEventLogs;
+
+/**
+ * The event at the given index.
  *
- * Log entries are in increasing chronological order.
+ * Log entries are in increasing chronological order. The entry is only valid until the next
+ * event is added.
  */
-@property (nonatomic, readonly, retain) NILinkedList* eventLogs;
+- (const NIOverviewEventLog *)eventLogAtIndex:(NSUInteger)index;
 
 @end
 
@@ -134,57 +244,6 @@ extern NSString* const NIOverviewLoggerDidAddConsoleLog;
 @end
 
 
-/**
- * A device log entry.
- *
- *      @ingroup Overview-Logger-Entries
- */
-@interface NIOverviewDeviceLogEntry : NIOverviewLogEntry {
-@private
-  unsigned long long _bytesOfFreeMemory;
-  unsigned long long _bytesOfTotalMemory;
-  unsigned long long _bytesOfTotalDiskSpace;
-  unsigned long long _bytesOfFreeDiskSpace;
-
-  CGFloat _batteryLevel;
-  UIDeviceBatteryState _batteryState;
-}
-
-#pragma mark Entry Information /** @name Entry Information */
-
-/**
- * The number of bytes of free memory.
- */
-@property (nonatomic, readwrite, assign) unsigned long long bytesOfFreeMemory;
-
-/**
- * The number of bytes of total memory.
- */
-@property (nonatomic, readwrite, assign) unsigned long long bytesOfTotalMemory;
-
-/**
- * The number of bytes of free disk space.
- */
-@property (nonatomic, readwrite, assign) unsigned long long bytesOfFreeDiskSpace;
-
-/**
- * The number of bytes of total disk space.
- */
-@property (nonatomic, readwrite, assign) unsigned long long bytesOfTotalDiskSpace;
-
-/**
- * The battery level.
- */
-@property (nonatomic, readwrite, assign) CGFloat batteryLevel;
-
-/**
- * The state of the battery.
- */
-@property (nonatomic, readwrite, assign) UIDeviceBatteryState batteryState;
-
-@end
-
-
 /**
  * A console log entry.
  *
@@ -211,35 +270,3 @@ extern NSString* const NIOverviewLoggerDidAddConsoleLog;
 @property (nonatomic, readwrite, copy) NSString* log;
 
 @end
-
-
-typedef enum {
-  NIOverviewEventDidReceiveMemoryWarning,
-} NIOverviewEventType;
-
-/**
- * An event log entry.
- *
- *      @ingroup Overview-Logger-Entries
- */
-@interface NIOverviewEventLogEntry : NIOverviewLogEntry {
-@private
-  NSInteger _eventType;
-}
-
-#pragma mark Creating an Entry /** @name Creating an Entry */
-
-/**
- * Designated initializer.
- */
-- (id)initWithType:(NSInteger)type;
-
-
-#pragma mark Entry Information /** @name Entry Information */
-
-/**
- * The type of event.
- */
-@property (nonatomic, readwrite, assign) NSInteger type;
-
-@end
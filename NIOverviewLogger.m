@@ -18,6 +18,104 @@
 
 NSString* const NIOverviewLoggerDidAddConsoleLog = @"NIOverviewLoggerDidAddConsoleLog";
 
+static const NSUInteger kDefaultCapacity = 1024;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSTimeInterval NIOverviewLogTimestamp(void) {
+  return [[NSProcessInfo processInfo] systemUptime];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Log Buffers
+
+// The capacity is a power of two so that wrapping an index around is a mask rather than a
+// division. Each entry starts with its timestamp.
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+BOOL NIOverviewLogBufferInit(NIOverviewLogBuffer* buffer, size_t entrySize, NSUInteger capacity) {
+  NSUInteger roundedCapacity = 1;
+  while (roundedCapacity < capacity) {
+    roundedCapacity <<= 1;
+  }
+
+  buffer->entries = calloc(roundedCapacity, entrySize);
+  buffer->entrySize = entrySize;
+  buffer->mask = roundedCapacity - 1;
+  buffer->first = 0;
+  buffer->count = 0;
+  return (NULL != buffer->entries);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NIOverviewLogBufferFree(NIOverviewLogBuffer* buffer) {
+  free(buffer->entries);
+  buffer->entries = NULL;
+  buffer->count = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NIOverviewLogBufferRemoveAllEntries(NIOverviewLogBuffer* buffer) {
+  buffer->first = 0;
+  buffer->count = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void* NIOverviewLogBufferEntryAtIndex(const NIOverviewLogBuffer* buffer, NSUInteger index) {
+  return buffer->entries + ((buffer->first + index) & buffer->mask) * buffer->entrySize;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NIOverviewLogBufferPruneEntriesBefore(NIOverviewLogBuffer* buffer,
+                                           NSTimeInterval cutoffTimestamp) {
+  while (buffer->count > 0
+         && *(NSTimeInterval *)NIOverviewLogBufferEntryAtIndex(buffer, 0) < cutoffTimestamp) {
+    buffer->first = (buffer->first + 1) & buffer->mask;
+    buffer->count--;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSUInteger NIOverviewLogBufferIndexOfFirstEntryAfter(const NIOverviewLogBuffer* buffer,
+                                                     NSTimeInterval timestamp) {
+  NSUInteger low = 0;
+  NSUInteger high = buffer->count;
+  while (low < high) {
+    NSUInteger middle = low + (high - low) / 2;
+    if (*(NSTimeInterval *)NIOverviewLogBufferEntryAtIndex(buffer, middle) > timestamp) {
+      high = middle;
+
+    } else {
+      low = middle + 1;
+    }
+  }
+  return low;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NIOverviewLogBufferAppend(NIOverviewLogBuffer* buffer, const void* entry) {
+  if (NULL == buffer->entries) {
+    return;
+  }
+  if (buffer->count > buffer->mask) {
+    // Full. The new entry takes the oldest one's place.
+    buffer->first = (buffer->first + 1) & buffer->mask;
+    buffer->count--;
+  }
+  memcpy(NIOverviewLogBufferEntryAtIndex(buffer, buffer->count), entry, buffer->entrySize);
+  buffer->count++;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -25,28 +123,29 @@ NSString* const NIOverviewLoggerDidAddConsoleLog = @"NIOverviewLoggerDidAddConso
 @implementation NIOverviewLogger
 
 @synthesize oldestLogAge = _oldestLogAge;
-@synthesize deviceLogs = _deviceLogs;
 @synthesize consoleLogs = _consoleLogs;
-@synthesize eventLogs = _eventLogs;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)dealloc {
-  NI_RELEASE_SAFELY(_deviceLogs);
+  NIOverviewLogBufferFree(&_deviceLogs);
   NI_RELEASE_SAFELY(_consoleLogs);
-  NI_RELEASE_SAFELY(_eventLogs);
+  NIOverviewLogBufferFree(&_eventLogs);
 
   [super dealloc];
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (id)init {
+- (id)initWithCapacity:(NSUInteger)capacity {
   if ((self = [super init])) {
-    _deviceLogs = [[NILinkedList alloc] init];
+    if (!NIOverviewLogBufferInit(&_deviceLogs, sizeof(NIOverviewDeviceLog), capacity)
+        || !NIOverviewLogBufferInit(&_eventLogs, sizeof(NIOverviewEventLog), capacity)) {
+      [self release];
+      return nil;
+    }
     _consoleLogs = [[NILinkedList alloc] init];
-    _eventLogs = [[NILinkedList alloc] init];
-    
+
     _oldestLogAge = 60;
   }
   return self;
@@ -54,20 +153,16 @@ NSString* const NIOverviewLoggerDidAddConsoleLog = @"NIOverviewLoggerDidAddConso
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)pruneEntriesFromLinkedList:(NILinkedList *)ll {
-  NSDate* cutoffDate = [NSDate dateWithTimeIntervalSinceNow:-_oldestLogAge];
-  while ([[((NIOverviewLogEntry *)[ll firstObject])
-           timestamp] compare:cutoffDate] == NSOrderedAscending) {
-    [ll removeFirstObject];
-  }
+- (id)init {
+  return [self initWithCapacity:kDefaultCapacity];
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)addDeviceLog:(NIOverviewDeviceLogEntry *)logEntry {
-  [self pruneEntriesFromLinkedList:_deviceLogs];
+- (void)addDeviceLog:(NIOverviewDeviceLog)logEntry {
+  NIOverviewLogBufferPruneEntriesBefore(&_deviceLogs, NIOverviewLogTimestamp() - _oldestLogAge);
 
-  [_deviceLogs addObject:logEntry];
+  NIOverviewLogBufferAppend(&_deviceLogs, &logEntry);
 }
 
 
@@ -83,10 +178,42 @@ NSString* const NIOverviewLoggerDidAddConsoleLog = @"NIOverviewLoggerDidAddConso
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)addEventLog:(NIOverviewEventLogEntry *)logEntry {
-  [self pruneEntriesFromLinkedList:_eventLogs];
+- (void)addEventLog:(NIOverviewEventLog)logEntry {
+  NIOverviewLogBufferPruneEntriesBefore(&_eventLogs, NIOverviewLogTimestamp() - _oldestLogAge);
+
+  NIOverviewLogBufferAppend(&_eventLogs, &logEntry);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)numberOfDeviceLogs {
+  return _deviceLogs.count;
+}
+
 
-  [_eventLogs addObject:logEntry];
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (const NIOverviewDeviceLog *)deviceLogAtIndex:(NSUInteger)index {
+  NIDASSERT(index < _deviceLogs.count);
+  return NIOverviewLogBufferEntryAtIndex(&_deviceLogs, index);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)indexOfFirstDeviceLogAfterTimestamp:(NSTimeInterval)timestamp {
+  return NIOverviewLogBufferIndexOfFirstEntryAfter(&_deviceLogs, timestamp);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)numberOfEventLogs {
+  return _eventLogs.count;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (const NIOverviewEventLog *)eventLogAtIndex:(NSUInteger)index {
+  NIDASSERT(index < _eventLogs.count);
+  return NIOverviewLogBufferEntryAtIndex(&_eventLogs, index);
 }
 
 
@@ -121,21 +248,6 @@ NSString* const NIOverviewLoggerDidAddConsoleLog = @"NIOverviewLoggerDidAddConso
 @end
 
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////
-@implementation NIOverviewDeviceLogEntry
-
-@synthesize bytesOfFreeMemory = _bytesOfFreeMemory;
-@synthesize bytesOfTotalMemory = _bytesOfTotalMemory;
-@synthesize bytesOfTotalDiskSpace = _bytesOfTotalDiskSpace;
-@synthesize bytesOfFreeDiskSpace = _bytesOfFreeDiskSpace;
-@synthesize batteryLevel = _batteryLevel;
-@synthesize batteryState = _batteryState;
-
-@end
-
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -162,25 +274,4 @@ NSString* const NIOverviewLoggerDidAddConsoleLog = @"NIOverviewLoggerDidAddConso
 }
 
 
-@end
-
-
-///////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////
-@implementation NIOverviewEventLogEntry
-
-@synthesize type = _eventType;
-
-
-///////////////////////////////////////////////////////////////////////////////////////////////////
-- (id)initWithType:(NSInteger)type {
-  if ((self = [super initWithTimestamp:[NSDate date]])) {
-    _eventType = type;
-  }
-  
-  return self;
-}
-
-
 @end
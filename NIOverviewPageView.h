@@ -20,6 +20,8 @@
 
 #import "NIOverviewGraphView.h"
 
+#import "NIOverviewLogger.h"
+
 /**
  * A page in the Overview.
  *
@@ -90,7 +92,7 @@
   UILabel* _label1;
   UILabel* _label2;
   NIOverviewGraphView* _graphView;
-  NSEnumerator* _eventEnumerator;
+  NSUInteger _nextEventIndex;
 }
 
 @property (nonatomic, readonly, retain) UILabel* label1;
@@ -109,7 +111,7 @@
  */
 @interface NIOverviewMemoryPageView : NIOverviewGraphPageView {
 @private
-  NSEnumerator* _enumerator;
+  NSUInteger _nextLogIndex;
   unsigned long long _minMemory;
 }
 
@@ -125,13 +127,65 @@
  */
 @interface NIOverviewDiskPageView : NIOverviewGraphPageView {
 @private
-  NSEnumerator* _enumerator;
+  NSUInteger _nextLogIndex;
   unsigned long long _minDiskUse;
 }
 
 @end
 
 
+/**
+ * A page that renders a graph of a memory cache's hit ratio.
+ *
+ * The cache is sampled each time the page updates. The labels show the hit ratio and the
+ * number of evictions over the time shown in the graph, and the bytes the cache holds now.
+ *
+ * The cache may be an NIMemoryCache or an NIConcurrentMemoryCache. The Overview adds a page
+ * for Nimbus::imageMemoryCache; add pages for your own caches with
+ * NIOverview::addMemoryCache:withTitle:.
+ *
+ *      @ingroup Overview-Pages
+ */
+@interface NIOverviewMemoryCachePageView : NIOverviewGraphPageView {
+@private
+  id _cache;
+  NIOverviewLogBuffer _history;
+  NSUInteger _nextLogIndex;
+  CGFloat _previousHitRatio;
+}
+
+/**
+ * Returns an autoreleased page for the given cache.
+ */
++ (NIOverviewMemoryCachePageView *)pageWithCache:(id)cache;
+
+/**
+ * The cache being graphed. Retained.
+ */
+@property (nonatomic, readwrite, retain) id cache;
+
+@end
+
+
+/**
+ * A page that graphs how long the recent frames took.
+ *
+ * The page starts Nimbus::frameMonitor if it isn't running yet. The labels show the number of
+ * stalls and the work most of them were blamed on. Tap the page to copy
+ * NIFrameMonitor::histogramDescription to the pasteboard.
+ *
+ *      @ingroup Overview-Pages
+ */
+@interface NIOverviewFramePageView : NIOverviewGraphPageView {
+@private
+  NSUInteger _nextFrameIndex;
+  BOOL _didStartFrameMonitor;
+  UITapGestureRecognizer* _exportGesture;
+}
+
+@end
+
+
 /**
  * A page that shows all of the logs sent to the console.
  *
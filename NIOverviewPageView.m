@@ -25,6 +25,7 @@
 
 static UIEdgeInsets kPagePadding;
 static const CGFloat kGraphRightMargin = 5;
+static const NSUInteger kMemoryCacheHistoryCapacity = 1024;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -204,10 +205,13 @@ static const CGFloat kGraphRightMargin = 5;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (CGFloat)graphViewXRange:(NIOverviewGraphView *)graphView {
-  NILinkedList* deviceLogs = [[NIOverview logger] deviceLogs];
-  NIOverviewLogEntry* firstEntry = [deviceLogs firstObject];
-  NIOverviewLogEntry* lastEntry = [deviceLogs lastObject];
-  NSTimeInterval interval = [lastEntry.timestamp timeIntervalSinceDate:firstEntry.timestamp];
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfLogs = [logger numberOfDeviceLogs];
+  if (0 == numberOfLogs) {
+    return 0;
+  }
+  NSTimeInterval interval = ([logger deviceLogAtIndex:numberOfLogs - 1]->timestamp
+                             - [logger deviceLogAtIndex:0]->timestamp);
   return (CGFloat)interval;
 }
 
@@ -218,6 +222,18 @@ static const CGFloat kGraphRightMargin = 5;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (double)graphViewXOrigin:(NIOverviewGraphView *)graphView {
+  return [self initialTimestamp];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (double)graphViewYOrigin:(NIOverviewGraphView *)graphView {
+  return 0;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)resetPointIterator {
 }
@@ -231,15 +247,18 @@ static const CGFloat kGraphRightMargin = 5;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (NSDate *)initialTimestamp {
-  return nil;
+- (NSTimeInterval)initialTimestamp {
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (0 == [logger numberOfDeviceLogs]) {
+    return 0;
+  }
+  return [logger deviceLogAtIndex:0]->timestamp;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)resetEventIterator {
-  NI_RELEASE_SAFELY(_eventEnumerator);
-  _eventEnumerator = [[[[NIOverview logger] eventLogs] objectEnumerator] retain];
+  _nextEventIndex = 0;
 }
 
 
@@ -253,13 +272,14 @@ static const CGFloat kGraphRightMargin = 5;
                      [UIColor redColor], // NIOverviewEventDidReceiveMemoryWarning
                      nil] retain];
   }
-  NIOverviewEventLogEntry* entry = [_eventEnumerator nextObject];
-  if (nil != entry) {
-    NSTimeInterval interval = [entry.timestamp timeIntervalSinceDate:[self initialTimestamp]];
-    *xValue = (CGFloat)interval;
-    *color = [sEventColors objectAtIndex:entry.type];
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (_nextEventIndex >= [logger numberOfEventLogs]) {
+    return NO;
   }
-  return nil != entry;
+  const NIOverviewEventLog* entry = [logger eventLogAtIndex:_nextEventIndex++];
+  *xValue = (CGFloat)(entry->timestamp - [self initialTimestamp]);
+  *color = [sEventColors objectAtIndex:entry->type];
+  return YES;
 }
 
 
@@ -272,14 +292,6 @@ static const CGFloat kGraphRightMargin = 5;
 @implementation NIOverviewMemoryPageView
 
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)dealloc {
-  NI_RELEASE_SAFELY(_enumerator);
-
-  [super dealloc];
-}
-
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (id)initWithFrame:(CGRect)frame {
   if ((self = [super initWithFrame:frame])) {
@@ -317,16 +329,18 @@ static const CGFloat kGraphRightMargin = 5;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
-  NILinkedList* deviceLogs = [[NIOverview logger] deviceLogs];
-  if ([deviceLogs count] == 0) {
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfLogs = [logger numberOfDeviceLogs];
+  if (numberOfLogs == 0) {
     return 0;
   }
 
   unsigned long long minY = (unsigned long long)-1;
   unsigned long long maxY = 0;
-  for (NIOverviewDeviceLogEntry* entry in deviceLogs) {
-    minY = MIN(entry.bytesOfFreeMemory, minY);
-    maxY = MAX(entry.bytesOfFreeMemory, maxY);
+  for (NSUInteger ix = 0; ix < numberOfLogs; ++ix) {
+    const NIOverviewDeviceLog* entry = [logger deviceLogAtIndex:ix];
+    minY = MIN(entry->bytesOfFreeMemory, minY);
+    maxY = MAX(entry->bytesOfFreeMemory, maxY);
   }
   unsigned long long range = maxY - minY;
   _minMemory = minY;
@@ -334,32 +348,38 @@ static const CGFloat kGraphRightMargin = 5;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (double)graphViewYOrigin:(NIOverviewGraphView *)graphView {
+  return (double)_minMemory / 1024.0 / 1024.0;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)resetPointIterator {
-  NI_RELEASE_SAFELY(_enumerator);
-  _enumerator = [[[[NIOverview logger] deviceLogs] objectEnumerator] retain];
+  _nextLogIndex = 0;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (NSDate *)initialTimestamp {
-  NILinkedList* deviceLogs = [[NIOverview logger] deviceLogs];
-  NIOverviewLogEntry* firstEntry = [deviceLogs firstObject];
-  return firstEntry.timestamp;
+- (void)resetPointIteratorAfterXValue:(double)xValue {
+  _nextLogIndex = [[NIOverview logger] indexOfFirstDeviceLogAfterTimestamp:
+                   [self initialTimestamp] + xValue];
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
                        point: (CGPoint *)point {
-  NIOverviewDeviceLogEntry* entry = [_enumerator nextObject];
-  if (nil != entry) {
-    NSTimeInterval interval = [entry.timestamp timeIntervalSinceDate:[self initialTimestamp]];
-    *point = CGPointMake((CGFloat)interval,
-                         (CGFloat)(((double)(entry.bytesOfFreeMemory - _minMemory))
-                                   / 1024.0 / 1024.0));
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (_nextLogIndex >= [logger numberOfDeviceLogs]) {
+    return NO;
   }
-  return nil != entry;
+  const NIOverviewDeviceLog* entry = [logger deviceLogAtIndex:_nextLogIndex++];
+  NSTimeInterval interval = entry->timestamp - [self initialTimestamp];
+  *point = CGPointMake((CGFloat)interval,
+                       (CGFloat)(((double)(entry->bytesOfFreeMemory - _minMemory))
+                                 / 1024.0 / 1024.0));
+  return YES;
 }
 
 
@@ -372,14 +392,6 @@ static const CGFloat kGraphRightMargin = 5;
 @implementation NIOverviewDiskPageView
 
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)dealloc {
-  NI_RELEASE_SAFELY(_enumerator);
-  
-  [super dealloc];
-}
-
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (id)initWithFrame:(CGRect)frame {
   if ((self = [super initWithFrame:frame])) {
@@ -417,16 +429,18 @@ static const CGFloat kGraphRightMargin = 5;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
-  NILinkedList* deviceLogs = [[NIOverview logger] deviceLogs];
-  if ([deviceLogs count] == 0) {
+  NIOverviewLogger* logger = [NIOverview logger];
+  NSUInteger numberOfLogs = [logger numberOfDeviceLogs];
+  if (numberOfLogs == 0) {
     return 0;
   }
   
   unsigned long long minY = (unsigned long long)-1;
   unsigned long long maxY = 0;
-  for (NIOverviewDeviceLogEntry* entry in deviceLogs) {
-    minY = MIN(entry.bytesOfFreeDiskSpace, minY);
-    maxY = MAX(entry.bytesOfFreeDiskSpace, maxY);
+  for (NSUInteger ix = 0; ix < numberOfLogs; ++ix) {
+    const NIOverviewDeviceLog* entry = [logger deviceLogAtIndex:ix];
+    minY = MIN(entry->bytesOfFreeDiskSpace, minY);
+    maxY = MAX(entry->bytesOfFreeDiskSpace, maxY);
   }
   unsigned long long range = maxY - minY;
   _minDiskUse = minY;
@@ -434,31 +448,388 @@ static const CGFloat kGraphRightMargin = 5;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (double)graphViewYOrigin:(NIOverviewGraphView *)graphView {
+  return (double)_minDiskUse / 1024.0 / 1024.0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)resetPointIterator {
+  _nextLogIndex = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)resetPointIteratorAfterXValue:(double)xValue {
+  _nextLogIndex = [[NIOverview logger] indexOfFirstDeviceLogAfterTimestamp:
+                   [self initialTimestamp] + xValue];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
+                       point: (CGPoint *)point {
+  NIOverviewLogger* logger = [NIOverview logger];
+  if (_nextLogIndex >= [logger numberOfDeviceLogs]) {
+    return NO;
+  }
+  const NIOverviewDeviceLog* entry = [logger deviceLogAtIndex:_nextLogIndex++];
+  NSTimeInterval interval = entry->timestamp - [self initialTimestamp];
+  double difference = ((double)entry->bytesOfFreeDiskSpace / 1024.0 / 1024.0
+                       - (double)_minDiskUse / 1024.0 / 1024.0);
+  *point = CGPointMake((CGFloat)interval, (CGFloat)difference);
+  return YES;
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Counters only grow, unless someone resets the cache's statistics in between.
+static unsigned long long NIOverviewCounterDelta(unsigned long long from, unsigned long long to) {
+  return (to > from) ? to - from : 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIOverviewMemoryCachePageView
+
+@synthesize cache = _cache;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_cache);
+  NIOverviewLogBufferFree(&_history);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NIOverviewMemoryCachePageView *)pageWithCache:(id)cache {
+  NIOverviewMemoryCachePageView* page = (NIOverviewMemoryCachePageView *)[self page];
+  page.cache = cache;
+  return page;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"Cache", @"Overview Page Title: Cache");
+
+    // Without the history the page still shows the current size; it just never graphs.
+    NIOverviewLogBufferInit(&_history, sizeof(NIOverviewMemoryCacheLog),
+                            kMemoryCacheHistoryCapacity);
+
+    self.graphView.dataSource = self;
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setCache:(id)cache {
+  if (_cache != cache) {
+    [_cache release];
+    _cache = [cache retain];
+
+    NIOverviewLogBufferRemoveAllEntries(&_history);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NIOverviewMemoryCacheLog *)logAtIndex:(NSUInteger)index {
+  return NIOverviewLogBufferEntryAtIndex(&_history, index);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGFloat)hitRatioFromLog:(const NIOverviewMemoryCacheLog *)fromLog
+                     toLog:(const NIOverviewMemoryCacheLog *)toLog {
+  const NIMemoryCacheStatistics* from = &fromLog->statistics;
+  const NIMemoryCacheStatistics* to = &toLog->statistics;
+  unsigned long long hits = NIOverviewCounterDelta(from->numberOfHits, to->numberOfHits);
+  unsigned long long misses = NIOverviewCounterDelta(from->numberOfMisses, to->numberOfMisses);
+  if (0 == hits + misses) {
+    return -1;
+  }
+  return (CGFloat)((double)hits * 100.0 / (double)(hits + misses));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)update {
+  if (nil == _cache) {
+    return;
+  }
+
+  // Each page samples its own cache, and keeps as much history as the logger does.
+  NSTimeInterval timestamp = NIOverviewLogTimestamp();
+  NIOverviewLogBufferPruneEntriesBefore(&_history, timestamp - [[NIOverview logger] oldestLogAge]);
+  NIOverviewMemoryCacheLog log;
+  log.timestamp = timestamp;
+  log.statistics = [_cache statistics];
+  NIOverviewLogBufferAppend(&_history, &log);
+
+  [super update];
+
+  const NIMemoryCacheStatistics* last = &log.statistics;
+  if (_history.count > 0) {
+    const NIOverviewMemoryCacheLog* firstLog = [self logAtIndex:0];
+    const NIMemoryCacheStatistics* first = &firstLog->statistics;
+
+    CGFloat hitRatio = [self hitRatioFromLog:firstLog toLog:&log];
+    if (hitRatio >= 0) {
+      self.label1.text = [NSString stringWithFormat:@"%.0f%% hits", hitRatio];
+
+    } else {
+      self.label1.text = NSLocalizedString(@"No lookups", @"Overview: Cache had no lookups");
+    }
+
+    unsigned long long evictions =
+    (NIOverviewCounterDelta(first->numberOfRemovals[NIMemoryCacheRemovalReasonCapacity],
+                            last->numberOfRemovals[NIMemoryCacheRemovalReasonCapacity])
+     + NIOverviewCounterDelta(first->numberOfRemovals[NIMemoryCacheRemovalReasonMemoryPressure],
+                              last->numberOfRemovals[NIMemoryCacheRemovalReasonMemoryPressure]));
+    self.label2.text = [NSString stringWithFormat:@"%@, %llu evicted",
+                        NIStringFromBytes(last->numberOfBytes), evictions];
+
+  } else {
+    self.label1.text = nil;
+    self.label2.text = NIStringFromBytes(last->numberOfBytes);
+  }
+
+  [self setNeedsLayout];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark NIOverviewGraphViewDataSource
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGFloat)graphViewXRange:(NIOverviewGraphView *)graphView {
+  if (0 == _history.count) {
+    return 0;
+  }
+  NIOverviewMemoryCacheLog* firstLog = [self logAtIndex:0];
+  NIOverviewMemoryCacheLog* lastLog = [self logAtIndex:_history.count - 1];
+  return (CGFloat)(lastLog->timestamp - firstLog->timestamp);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
+  // Percent.
+  return (_history.count > 1) ? 100 : 0;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)resetPointIterator {
-  _enumerator = [[[NIOverview logger] deviceLogs] objectEnumerator];
+  // The first point is the hit ratio between the first two samples.
+  _nextLogIndex = 1;
+  _previousHitRatio = 0;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (NSDate *)initialTimestamp {
-  NILinkedList* deviceLogs = [[NIOverview logger] deviceLogs];
-  NIOverviewLogEntry* firstEntry = [deviceLogs firstObject];
-  return firstEntry.timestamp;
+- (void)resetPointIteratorAfterXValue:(double)xValue {
+  // _previousHitRatio still holds the last point's value, which carries over to the new points.
+  NSUInteger index = NIOverviewLogBufferIndexOfFirstEntryAfter(&_history,
+                                                               [self initialTimestamp] + xValue);
+  _nextLogIndex = MAX(1, index);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSTimeInterval)initialTimestamp {
+  if (0 == _history.count) {
+    return 0;
+  }
+  return [self logAtIndex:0]->timestamp;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
                        point: (CGPoint *)point {
-  NIOverviewDeviceLogEntry* entry = [_enumerator nextObject];
-  if (nil != entry) {
-    NSTimeInterval interval = [entry.timestamp timeIntervalSinceDate:[self initialTimestamp]];
-    double difference = ((double)entry.bytesOfFreeDiskSpace / 1024.0 / 1024.0
-                         - (double)_minDiskUse / 1024.0 / 1024.0);
-    *point = CGPointMake((CGFloat)interval, (CGFloat)difference);
-  }
-  return nil != entry;
+  if (_nextLogIndex >= _history.count) {
+    return NO;
+  }
+  const NIOverviewMemoryCacheLog* previousLog = [self logAtIndex:_nextLogIndex - 1];
+  const NIOverviewMemoryCacheLog* log = [self logAtIndex:_nextLogIndex++];
+
+  // Each point is the hit ratio since the previous sample. Without lookups in between,
+  // the line stays where it was.
+  CGFloat hitRatio = [self hitRatioFromLog:previousLog toLog:log];
+  if (hitRatio >= 0) {
+    _previousHitRatio = hitRatio;
+  }
+
+  NSTimeInterval interval = log->timestamp - [self initialTimestamp];
+  *point = CGPointMake((CGFloat)interval, _previousHitRatio);
+  return YES;
+}
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIOverviewFramePageView
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  if (_didStartFrameMonitor) {
+    [[Nimbus frameMonitor] stopMonitoring];
+  }
+  NI_RELEASE_SAFELY(_exportGesture);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.pageTitle = NSLocalizedString(@"Frames", @"Overview Page Title: Frames");
+
+    self.graphView.dataSource = self;
+
+    _exportGesture = [[UITapGestureRecognizer alloc] initWithTarget: self
+                                                             action: @selector(didTapToExport:)];
+    [self addGestureRecognizer:_exportGesture];
+
+    NIFrameMonitor* frameMonitor = [Nimbus frameMonitor];
+    if (![frameMonitor isMonitoring]) {
+      [frameMonitor startMonitoring];
+      _didStartFrameMonitor = YES;
+    }
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)update {
+  [super update];
+
+  NIFrameMonitor* frameMonitor = [Nimbus frameMonitor];
+
+  self.label1.text = [NSString stringWithFormat:@"%lu stalls",
+                      (unsigned long)frameMonitor.numberOfStalls];
+
+  NIFrameWork mostStalledWork = NIFrameWorkOther;
+  for (NSInteger work = 0; work < NIFrameWorkCount; ++work) {
+    if ([frameMonitor numberOfStallsDuringWork:(NIFrameWork)work]
+        > [frameMonitor numberOfStallsDuringWork:mostStalledWork]) {
+      mostStalledWork = (NIFrameWork)work;
+    }
+  }
+  if ([frameMonitor numberOfStallsDuringWork:mostStalledWork] > 0) {
+    self.label2.text = [NSString stringWithFormat:@"most in %@",
+                        NIStringFromFrameWork(mostStalledWork)];
+
+  } else {
+    self.label2.text = [NSString stringWithFormat:@"%.0f ms longest",
+                        frameMonitor.longestFrameDuration * 1000];
+  }
+
+  [self setNeedsLayout];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didTapToExport:(UITapGestureRecognizer *)gesture {
+  NSString* histogram = [[Nimbus frameMonitor] histogramDescription];
+  [[UIPasteboard generalPasteboard] setString:histogram];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark NIOverviewGraphViewDataSource
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGFloat)graphViewXRange:(NIOverviewGraphView *)graphView {
+  NSUInteger numberOfRecentFrames = [[Nimbus frameMonitor] numberOfRecentFrames];
+  return (numberOfRecentFrames > 1) ? (CGFloat)(numberOfRecentFrames - 1) : 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGFloat)graphViewYRange:(NIOverviewGraphView *)graphView {
+  // Milliseconds.
+  NIFrameMonitor* frameMonitor = [Nimbus frameMonitor];
+  CFTimeInterval longestDuration = 0;
+  NSUInteger numberOfRecentFrames = [frameMonitor numberOfRecentFrames];
+  for (NSUInteger ix = 0; ix < numberOfRecentFrames; ++ix) {
+    longestDuration = MAX(longestDuration, [frameMonitor durationOfRecentFrameAtIndex:ix]);
+  }
+  return (CGFloat)(longestDuration * 1000);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (double)graphViewXOrigin:(NIOverviewGraphView *)graphView {
+  // Frames are numbered from the first one recorded.
+  NIFrameMonitor* frameMonitor = [Nimbus frameMonitor];
+  return (double)(frameMonitor.numberOfFrames - [frameMonitor numberOfRecentFrames]);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)resetPointIterator {
+  _nextFrameIndex = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)resetPointIteratorAfterXValue:(double)xValue {
+  // Points are plotted at their index among the recent frames.
+  _nextFrameIndex = (xValue < 0) ? 0 : (NSUInteger)floor(xValue) + 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)nextPointInGraphView: (NIOverviewGraphView *)graphView
+                       point: (CGPoint *)point {
+  NIFrameMonitor* frameMonitor = [Nimbus frameMonitor];
+  if (_nextFrameIndex >= [frameMonitor numberOfRecentFrames]) {
+    return NO;
+  }
+  CFTimeInterval duration = [frameMonitor durationOfRecentFrameAtIndex:_nextFrameIndex];
+  *point = CGPointMake((CGFloat)_nextFrameIndex, (CGFloat)(duration * 1000));
+  _nextFrameIndex++;
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)resetEventIterator {
+  // Events are logged against time, not frames.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)nextEventInGraphView: (NIOverviewGraphView *)graphView
+                      xValue: (CGFloat *)xValue
+                       color: (UIColor **)color {
+  return NO;
 }
 
 
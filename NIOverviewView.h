@@ -47,6 +47,11 @@
  */
 - (void)addPageView:(NIOverviewPageView *)page;
 
+/**
+ * Removes a page from the Overview.
+ */
+- (void)removePageView:(NIOverviewPageView *)page;
+
 /**
  * Update all of the views.
  */
@@ -188,6 +188,15 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removePageView:(NIOverviewPageView *)page {
+  [page removeFromSuperview];
+  [_pageViews removeObjectIdenticalTo:page];
+
+  [self layoutPages];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)updatePages {
   for (NIOverviewPageView* pageView in _pageViews) {
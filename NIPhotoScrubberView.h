@@ -47,13 +47,17 @@
 @interface NIPhotoScrubberView : UIView {
 @private
   NSMutableArray* _visiblePhotoViews;
-  NSMutableSet* _recycledPhotoViews;
+  NSMutableArray* _recycledPhotoViews;
+
+  // Thumbnails requested from the data source that haven't loaded yet.
+  NSMutableIndexSet* _pendingThumbnailIndexes;
   
   UIView* _containerView;
   UIImageView* _selectionView;
   
   // State
   NSInteger _selectedPhotoIndex;
+  BOOL _isScrubbing;
 
   // Cached data source values
   NSInteger _numberOfPhotos;
@@ -78,8 +82,9 @@
  * This must be called at least once after dataSource has been set in order for the view
  * to gather any presentable information.
  *
- * This method is expensive. It will reset the state of the view and remove all existing
- * thumbnails before requesting the new information from the data source.
+ * This resets the thumbnails and cancels any outstanding thumbnail requests before requesting
+ * the new information from the data source. The thumbnail views themselves are kept and
+ * reused.
  */
 - (void)reloadData;
 
@@ -88,6 +93,9 @@
  *
  * This method is cheap, so do not be afraid to call it whenever a thumbnail loads.
  * It will only modify visible thumbnails.
+ *
+ * If the data source implements photoScrubberView:requestThumbnailAtIndex:, this is how each
+ * requested thumbnail must be delivered, either right away or once it has loaded.
  */
 - (void)didLoadThumbnail: (UIImage *)image
                  atIndex: (NSInteger)photoIndex;
@@ -113,6 +121,13 @@
  */
 - (void)setSelectedPhotoIndex:(NSInteger)photoIndex animated:(BOOL)animated;
 
+/**
+ * Whether the user is dragging the selection across the scrubber.
+ *
+ * The scrub ends when the finger lifts, or when it rests on one photo for a moment.
+ */
+@property (nonatomic, readonly, assign, getter=isScrubbing) BOOL scrubbing;
+
 @end
 
 /**
@@ -130,6 +145,11 @@
  * and return nil. Once the thumbnail is loaded, call didLoadThumbnail:atIndex: to notify
  * the scrubber that it can display the thumbnail now.
  *
+ * Better still, implement photoScrubberView:requestThumbnailAtIndex: and
+ * photoScrubberView:cancelThumbnailRequestAtIndex:. The scrubber then tells you which
+ * thumbnails it wants and which it no longer needs, so that while the user drags across a
+ * large album you only load the thumbnails that are still on screen.
+ *
  * It is not recommended to use high-res images for your scrubber thumbnails. This is because
  * the scrubber will keep a large set of images in memory and if you're giving it
  * high-resolution images then you'll find that your app quickly burns through memory.
@@ -152,14 +172,39 @@
  */
 - (NSInteger)numberOfPhotosInScrubberView:(NIPhotoScrubberView *)photoScrubberView;
 
+@optional
+
+#pragma mark Fetching Thumbnails /** @name Fetching Thumbnails */
+
 /**
  * Fetch the thumbnail image for the given photo index.
  *
  * Please read and understand the performance considerations for this data source.
+ *
+ * Not called if the data source implements photoScrubberView:requestThumbnailAtIndex:. One of
+ * the two must be implemented.
  */
 - (UIImage *)photoScrubberView: (NIPhotoScrubberView *)photoScrubberView
               thumbnailAtIndex: (NSInteger)thumbnailIndex;
 
+/**
+ * Asks for the thumbnail at the given photo index.
+ *
+ * Deliver the thumbnail with didLoadThumbnail:atIndex:. If it is already in memory you may do
+ * so before returning. A thumbnail is not requested again while its request is outstanding.
+ */
+- (void)photoScrubberView: (NIPhotoScrubberView *)photoScrubberView
+  requestThumbnailAtIndex: (NSInteger)thumbnailIndex;
+
+/**
+ * The thumbnail at the given photo index is no longer on screen.
+ *
+ * Sent for outstanding requests only. Stop loading the thumbnail if you can; delivering it
+ * anyway is harmless.
+ */
+- (void)photoScrubberView: (NIPhotoScrubberView *)photoScrubberView
+cancelThumbnailRequestAtIndex: (NSInteger)thumbnailIndex;
+
 @end
 
 /**
@@ -184,4 +229,21 @@
  */
 - (void)photoScrubberViewDidChangeSelection:(NIPhotoScrubberView *)photoScrubberView;
 
+#pragma mark Scrubbing /** @name Scrubbing */
+
+/**
+ * The user has started dragging the selection.
+ *
+ * Selection changes until photoScrubberViewDidEndScrubbing: pass over photos the user is
+ * unlikely to stop at. Show only what is already in memory for them and defer loading.
+ */
+- (void)photoScrubberViewDidBeginScrubbing:(NIPhotoScrubberView *)photoScrubberView;
+
+/**
+ * The selection has settled, either because the finger lifted or because it stopped moving.
+ *
+ * This is the time to load the selected photo.
+ */
+- (void)photoScrubberViewDidEndScrubbing:(NIPhotoScrubberView *)photoScrubberView;
+
 @end
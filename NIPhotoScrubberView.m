@@ -22,6 +22,9 @@
 
 static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 
+// How long the selection must stay on one photo during a drag for the scrub to end.
+static const NSTimeInterval NIPhotoScrubberViewSettleDelay = 0.2;
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +52,20 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
  */
 - (UIImageView *)photoView;
 
+/**
+ * @internal
+ *
+ * Asks the data source for a thumbnail, unless it has already been asked and hasn't answered.
+ */
+- (void)requestThumbnailAtIndex:(NSInteger)photoIndex;
+
+/**
+ * @internal
+ *
+ * Cancels the outstanding requests for thumbnails that are neither visible nor selected.
+ */
+- (void)cancelUnneededThumbnailRequests;
+
 @end
 
 
@@ -60,12 +77,16 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 @synthesize dataSource = _dataSource;
 @synthesize delegate = _delegate;
 @synthesize selectedPhotoIndex = _selectedPhotoIndex;
+@synthesize scrubbing = _isScrubbing;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)dealloc {
+  [NSObject cancelPreviousPerformRequestsWithTarget:self];
+
   NI_RELEASE_SAFELY(_visiblePhotoViews);
   NI_RELEASE_SAFELY(_recycledPhotoViews);
+  NI_RELEASE_SAFELY(_pendingThumbnailIndexes);
   
   NI_RELEASE_SAFELY(_containerView);
   NI_RELEASE_SAFELY(_selectionView);
@@ -91,6 +112,10 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
     [self addSubview:_selectionView];
 
     _selectedPhotoIndex = -1;
+
+    _visiblePhotoViews = [[NSMutableArray alloc] init];
+    _recycledPhotoViews = [[NSMutableArray alloc] init];
+    _pendingThumbnailIndexes = [[NSMutableIndexSet alloc] init];
   }
 
   return self;
@@ -290,62 +315,104 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)updateVisiblePhotos {
-  if (nil == self.dataSource) {
-    return;
+- (void)assignPhotoViewsToSlots {
+  NSInteger numberOfSlots = (NSInteger)_numberOfVisiblePhotos;
+
+  // Every view we have is a candidate for the new slots, on screen or not.
+  NSMutableArray* candidates = [NSMutableArray arrayWithArray:_visiblePhotoViews];
+  [candidates addObjectsFromArray:_recycledPhotoViews];
+  [_recycledPhotoViews removeAllObjects];
+
+  NSMutableArray* photoViews = [NSMutableArray arrayWithCapacity:numberOfSlots];
+  for (NSInteger ix = 0; ix < numberOfSlots; ++ix) {
+    [photoViews addObject:[NSNull null]];
   }
 
-  // This will update the number of visible photos if the layout did indeed change.
-  [self layoutIfNeeded];
+  // Views are matched to slots by the photo they show, so a view that already has a slot's
+  // thumbnail keeps it and nothing needs to be requested. A view whose thumbnail never arrived
+  // is only a match while its request is still pending; otherwise it would stay blank.
+  for (NSInteger ix = 0; ix < numberOfSlots; ++ix) {
+    NSInteger photoIndex = [self photoIndexAtScrubberIndex:ix];
+    for (UIImageView* candidate in candidates) {
+      if (candidate.tag == photoIndex
+          && (nil != candidate.image || [_pendingThumbnailIndexes containsIndex:photoIndex])) {
+        [photoViews replaceObjectAtIndex:ix withObject:candidate];
+        [candidates removeObjectIdenticalTo:candidate];
+        break;
+      }
+    }
+  }
 
-  // Recycle any views that we no longer need.
-  while ([_visiblePhotoViews count] > _numberOfVisiblePhotos) {
-    UIView* photoView = [_visiblePhotoViews lastObject];
-    [photoView removeFromSuperview];
+  // The remaining slots take whatever views are left, or new ones.
+  NSMutableArray* reassignedViews = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < numberOfSlots; ++ix) {
+    if ([NSNull null] != [photoViews objectAtIndex:ix]) {
+      continue;
+    }
 
-    [_recycledPhotoViews addObject:photoView];
+    UIImageView* photoView = [[[candidates lastObject] retain] autorelease];
+    if (nil == photoView) {
+      photoView = [self photoView];
+
+    } else {
+      [candidates removeLastObject];
+    }
 
-    [_visiblePhotoViews removeLastObject];
+    photoView.tag = [self photoIndexAtScrubberIndex:ix];
+    photoView.image = nil;
+    [photoViews replaceObjectAtIndex:ix withObject:photoView];
+    [reassignedViews addObject:photoView];
   }
 
-  // Lay out the visible photos.
-  for (NSInteger ix = 0; ix < _numberOfVisiblePhotos; ++ix) {
-    UIImageView* photoView = nil;
+  // Views without a slot keep their thumbnails in case their photos come back. Their requests
+  // are about to be canceled, so views still waiting for a thumbnail forget their photo.
+  for (UIImageView* photoView in candidates) {
+    if (nil == photoView.image) {
+      photoView.tag = NIPhotoScrubberViewUnknownTag;
+    }
+    [photoView removeFromSuperview];
+    [_recycledPhotoViews addObject:photoView];
+  }
 
-    // We must first get the photo view at this index.
+  for (UIView* photoView in photoViews) {
+    if (photoView.superview != _containerView) {
+      [_containerView addSubview:photoView];
+    }
+  }
+  [_visiblePhotoViews setArray:photoViews];
 
-    // If there aren't enough visible photo views then try to recycle another view.
-    if (ix >= [_visiblePhotoViews count]) {
-      photoView = [[[_recycledPhotoViews anyObject] retain] autorelease];
-      if (nil == photoView) {
-        // Couldn't recycle the view, so create a new one.
-        photoView = [self photoView];
+  [self cancelUnneededThumbnailRequests];
 
-      } else {
-        [_recycledPhotoViews removeObject:photoView];
-      }
-      [_containerView addSubview:photoView];
-      [_visiblePhotoViews addObject:photoView];
+  for (UIImageView* photoView in reassignedViews) {
+    [self requestThumbnailAtIndex:photoView.tag];
+  }
+}
 
-    } else {
-      photoView = [_visiblePhotoViews objectAtIndex:ix];
-    }
 
-    NSInteger photoIndex = [self photoIndexAtScrubberIndex:ix];
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)updateVisiblePhotos {
+  if (nil == self.dataSource) {
+    return;
+  }
 
-    // Only request the thumbnail if this thumbnail's photo index has changed. Otherwise
-    // we assume that this photo either already has the thumbnail or it's still loading.
-    if (photoView.tag != photoIndex) {
-      photoView.tag = photoIndex;
+  // This will update the number of visible photos if the layout did indeed change.
+  [self layoutIfNeeded];
 
-      UIImage* image = [self.dataSource photoScrubberView:self thumbnailAtIndex:photoIndex];
-      photoView.image = image;
+  NSInteger numberOfSlots = (NSInteger)_numberOfVisiblePhotos;
 
-      if (_selectedPhotoIndex == photoIndex) {
-        _selectionView.image = image;
-      }
-    }
+  // Most layouts don't change which photos are shown, so only reassign the views when needed.
+  BOOL slotsHaveChanged = ((NSInteger)[_visiblePhotoViews count] != numberOfSlots);
+  for (NSInteger ix = 0; !slotsHaveChanged && ix < numberOfSlots; ++ix) {
+    UIView* photoView = [_visiblePhotoViews objectAtIndex:ix];
+    slotsHaveChanged = (photoView.tag != [self photoIndexAtScrubberIndex:ix]);
+  }
+  if (slotsHaveChanged) {
+    [self assignPhotoViewsToSlots];
+  }
 
+  // Lay out the visible photos.
+  for (NSInteger ix = 0; ix < numberOfSlots; ++ix) {
+    UIView* photoView = [_visiblePhotoViews objectAtIndex:ix];
     photoView.frame = [self frameForThumbAtIndex:ix];
   }
 }
@@ -379,16 +446,54 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)beginScrubbing {
+  if (!_isScrubbing) {
+    _isScrubbing = YES;
+
+    if ([self.delegate respondsToSelector:@selector(photoScrubberViewDidBeginScrubbing:)]) {
+      [self.delegate photoScrubberViewDidBeginScrubbing:self];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)endScrubbing {
+  [NSObject cancelPreviousPerformRequestsWithTarget: self
+                                           selector: @selector(endScrubbing)
+                                             object: nil];
+
+  if (_isScrubbing) {
+    _isScrubbing = NO;
+
+    if ([self.delegate respondsToSelector:@selector(photoScrubberViewDidEndScrubbing:)]) {
+      [self.delegate photoScrubberViewDidEndScrubbing:self];
+    }
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)updateSelectionWithPoint:(CGPoint)point {
   NSInteger photoIndex = [self photoIndexAtPoint:point];
   
   if (photoIndex != _selectedPhotoIndex) {
+    [self beginScrubbing];
+
     [self setSelectedPhotoIndex:photoIndex];
     
     if ([self.delegate respondsToSelector:@selector(photoScrubberViewDidChangeSelection:)]) {
       [self.delegate photoScrubberViewDidChangeSelection:self];
     }
+
+    // The scrub ends once the selection stops changing, even if the finger stays down.
+    [NSObject cancelPreviousPerformRequestsWithTarget: self
+                                             selector: @selector(endScrubbing)
+                                               object: nil];
+    [self performSelector: @selector(endScrubbing)
+               withObject: nil
+               afterDelay: NIPhotoScrubberViewSettleDelay];
   }
 }
 
@@ -421,6 +526,22 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)touchesEnded:(NSSet *)touches withEvent:(UIEvent *)event {
+  [super touchesEnded:touches withEvent:event];
+
+  [self endScrubbing];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)touchesCancelled:(NSSet *)touches withEvent:(UIEvent *)event {
+  [super touchesCancelled:touches withEvent:event];
+
+  [self endScrubbing];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -430,6 +551,10 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)didLoadThumbnail: (UIImage *)image
                  atIndex: (NSInteger)photoIndex {
+  if (photoIndex >= 0) {
+    [_pendingThumbnailIndexes removeIndex:photoIndex];
+  }
+
   for (UIImageView* thumbView in _visiblePhotoViews) {
     if (thumbView.tag == photoIndex) {
       thumbView.image = image;
@@ -445,25 +570,85 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)reloadData {
-  NIDASSERT(nil != _dataSource);
+- (void)requestThumbnailAtIndex:(NSInteger)photoIndex {
+  if (photoIndex < 0 || [_pendingThumbnailIndexes containsIndex:photoIndex]) {
+    return;
+  }
+
+  if ([self.dataSource respondsToSelector:@selector(photoScrubberView:requestThumbnailAtIndex:)]) {
+    // Marked first because the data source may deliver the thumbnail before returning.
+    [_pendingThumbnailIndexes addIndex:photoIndex];
+    [self.dataSource photoScrubberView:self requestThumbnailAtIndex:photoIndex];
+
+  } else {
+    NIDASSERT([self.dataSource respondsToSelector:@selector(photoScrubberView:thumbnailAtIndex:)]);
+    UIImage* image = [self.dataSource photoScrubberView:self thumbnailAtIndex:photoIndex];
+    [self didLoadThumbnail:image atIndex:photoIndex];
+  }
+}
+
 
-  // Remove any visible photos from the view before we release the sets.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelThumbnailRequestsInIndexSet:(NSIndexSet *)photoIndexes {
+  BOOL canCancel = [self.dataSource respondsToSelector:
+                    @selector(photoScrubberView:cancelThumbnailRequestAtIndex:)];
+  for (NSUInteger photoIndex = [photoIndexes firstIndex];
+       NSNotFound != photoIndex;
+       photoIndex = [photoIndexes indexGreaterThanIndex:photoIndex]) {
+    [_pendingThumbnailIndexes removeIndex:photoIndex];
+    if (canCancel) {
+      [self.dataSource photoScrubberView:self cancelThumbnailRequestAtIndex:photoIndex];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelUnneededThumbnailRequests {
+  if (0 == [_pendingThumbnailIndexes count]) {
+    return;
+  }
+
+  NSMutableIndexSet* unneededIndexes = [[_pendingThumbnailIndexes mutableCopy] autorelease];
   for (UIView* photoView in _visiblePhotoViews) {
-    [photoView removeFromSuperview];
+    if (photoView.tag >= 0) {
+      [unneededIndexes removeIndex:photoView.tag];
+    }
+  }
+  if (_selectedPhotoIndex >= 0) {
+    [unneededIndexes removeIndex:_selectedPhotoIndex];
   }
 
-  NI_RELEASE_SAFELY(_visiblePhotoViews);
-  NI_RELEASE_SAFELY(_recycledPhotoViews);
+  [self cancelThumbnailRequestsInIndexSet:unneededIndexes];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reloadData {
+  NIDASSERT(nil != _dataSource);
+
+  // The photos may have changed, so no view's thumbnail can be trusted anymore. The views
+  // themselves are kept for the new slots.
+  for (UIImageView* photoView in _visiblePhotoViews) {
+    photoView.tag = NIPhotoScrubberViewUnknownTag;
+    photoView.image = nil;
+  }
+  for (UIImageView* photoView in _recycledPhotoViews) {
+    photoView.tag = NIPhotoScrubberViewUnknownTag;
+    photoView.image = nil;
+  }
+  [self cancelThumbnailRequestsInIndexSet:[[_pendingThumbnailIndexes copy] autorelease]];
 
   // If there is no data source then we can't do anything particularly interesting.
   if (nil == _dataSource) {
+    for (UIView* photoView in _visiblePhotoViews) {
+      [photoView removeFromSuperview];
+    }
+    [_recycledPhotoViews addObjectsFromArray:_visiblePhotoViews];
+    [_visiblePhotoViews removeAllObjects];
     return;
   }
 
-  _visiblePhotoViews = [[NSMutableArray alloc] init];
-  _recycledPhotoViews = [[NSMutableSet alloc] init];
-
   // Cache the number of photos.
   _numberOfPhotos = [_dataSource numberOfPhotosInScrubberView:self];
 
@@ -496,8 +681,21 @@ static const NSInteger NIPhotoScrubberViewUnknownTag = -1;
       [UIView commitAnimations];
     }
 
-    _selectionView.image = [self.dataSource photoScrubberView: self
-                                             thumbnailAtIndex: _selectedPhotoIndex];
+    // A visible thumbnail may already have the photo.
+    UIImage* image = nil;
+    for (UIImageView* thumbView in _visiblePhotoViews) {
+      if (thumbView.tag == photoIndex) {
+        image = thumbView.image;
+        break;
+      }
+    }
+    _selectionView.image = image;
+    if (nil == image) {
+      [self requestThumbnailAtIndex:photoIndex];
+    }
+
+    // While scrubbing, the selection passes over many photos that are never seen again.
+    [self cancelUnneededThumbnailRequests];
   }
 }
 
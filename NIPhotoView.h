@@ -21,7 +21,9 @@
 #import <UIKit/UIKit.h>
 
 @protocol NIPhotoViewDelegate;
+@protocol NIPhotoViewTileSource;
 @class NICenteringScrollView;
+@class NIPhotoTilingView;
 
 /**
  * A single photo view that supports zooming and rotation.
@@ -36,10 +38,20 @@
   UIImageView* _imageView;
   // The scroll view.
   NICenteringScrollView* _scrollView;
+  // Draws the visible tiles of a tiled photo over the image view.
+  NIPhotoTilingView* _tilingView;
 
   // Photo Information
   NIPhotoViewPhotoSize _photoSize;
   CGSize _photoDimensions;
+  CGSize _tiledImageSize;
+
+  // What the scroll view's zoom scales were last calculated from.
+  CGSize _appliedContentSize;
+  CGSize _appliedBoundsSize;
+  CGSize _appliedPhotoDimensions;
+  NIPhotoViewPhotoSize _appliedPhotoSize;
+  BOOL _appliedZoomingAboveOriginalSize;
 
   // Configurable State
   BOOL _zoomingIsEnabled;
@@ -63,9 +75,16 @@
 - (NIPhotoViewPhotoSize)photoSize;
 - (void)setImage:(UIImage *)image photoSize:(NIPhotoViewPhotoSize)photoSize;
 
+- (id<NIPhotoViewTileSource>)tileSource;
+- (void)setTileSource:(id<NIPhotoViewTileSource>)tileSource imageSize:(CGSize)imageSize;
+
 @property (nonatomic, readwrite, assign) NSInteger itemIndex;
 @property (nonatomic, readwrite, assign) CGSize photoDimensions;
 
+#pragma mark Measuring Performance
+
+- (NSUInteger)numberOfLayoutPasses;
+
 @end
 
 /** @name Configuring Functionality */
@@ -128,11 +147,34 @@
  *
  * If image is nil then the photoSize will be overridden as NIPhotoViewPhotoSizeUnknown.
  *
- * Resets the current zoom levels and zooms to fit the image.
+ * Resets the current zoom levels and zooms to fit the image. The exception is replacing a
+ * NIPhotoViewPhotoSizeReduced image with its NIPhotoViewPhotoSizeOriginal, which keeps the
+ * same part of the photo on screen at the same zoom.
  *
  *      @fn NIPhotoView::setImage:photoSize:
  */
 
+/**
+ * Shows a very large photo as tiles from a tile pyramid.
+ *
+ * imageSize is the size of the original image in pixels. The photo view zooms as though it
+ * were showing an image of that size, and draws only the tiles that intersect the visible
+ * part of the photo, at the level of the pyramid that matches the current zoom scale. Tiles
+ * are requested and drawn on background threads as the user pans and zooms, and tiles that
+ * scroll out of view are discarded, so the memory used by the photo is bounded by the size of
+ * the screen rather than the size of the image.
+ *
+ * The image set with setImage:photoSize: is stretched to imageSize and shown behind the tiles
+ * until they have been drawn. It should be a screen-sized version of the photo.
+ *
+ * Pass a nil tileSource to go back to showing only the image. The tile source is retained until
+ * it is replaced, the photo view is prepared for reuse, or the photo view is deallocated, so
+ * that tiles still drawing on background threads never use a released source. To avoid a
+ * retain cycle, the source should not own the photo view.
+ *
+ *      @fn NIPhotoView::setTileSource:imageSize:
+ */
+
 /**
  * The index of this photo within a photo album.
  *
@@ -160,3 +202,17 @@
  *
  *      @fn NIPhotoView::photoDimensions
  */
+
+
+/** @name Measuring Performance */
+
+/**
+ * The number of times the photo's scroll view has laid out its subviews.
+ *
+ * Setting an image whose size, photo size and bounds match the previous one while the photo
+ * is zoomed out does not reconfigure the scroll view, so recycled items showing the loading
+ * image again cost no layout. Compare this count before and after scrolling through the strip
+ * to see how many layout passes were caused.
+ *
+ *      @fn NIPhotoView::numberOfLayoutPasses
+ */
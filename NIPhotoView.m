@@ -15,15 +15,26 @@
 //
 
 #import "NIPhotoView.h"
+#import "NIPhotoViewTileSource.h"
 #import "NimbusCore.h"
 
+#import <QuartzCore/QuartzCore.h>
+
+static const CGFloat kDefaultTileDimension = 256;
+
 /**
  * A UIScrollView that centers the zooming view's frame as the user zooms.
  *
  * We must update the zooming view's frame within the scroll view's layoutSubviews,
  * thus why we've subclassed UIScrollView.
  */
-@interface NICenteringScrollView : UIScrollView
+@interface NICenteringScrollView : UIScrollView {
+@private
+  NSUInteger _numberOfLayoutPasses;
+}
+
+@property (nonatomic, readonly, assign) NSUInteger numberOfLayoutPasses;
+
 @end
 
 
@@ -32,6 +43,8 @@
 
 @implementation NICenteringScrollView
 
+@synthesize numberOfLayoutPasses = _numberOfLayoutPasses;
+
 
 
 
@@ -43,6 +56,8 @@
 - (void)layoutSubviews {
   [super layoutSubviews];
 
+  ++_numberOfLayoutPasses;
+
   // Center the image as it becomes smaller than the size of the screen.
 
   UIView* zoomingSubview = [self.delegate viewForZoomingInScrollView:self];
@@ -74,9 +89,123 @@
 
 
 
+/**
+ * Draws the tiles of a tiled photo.
+ *
+ * The view's bounds are the size of the original image, in pixels. CATiledLayer asks for the
+ * visible tiles only, on background threads, and at the level of detail that matches the
+ * current zoom scale.
+ */
+@interface NIPhotoTilingView : UIView {
+@private
+  id<NIPhotoViewTileSource> _tileSource;
+  NIPhotoView* _photoView;
+}
+
+// Atomic because they are read while drawing on background threads. The atomic getter hands
+// the drawing thread its own retained reference, so the source outlives any draw in progress.
+@property (readwrite, retain) id<NIPhotoViewTileSource> tileSource;
+@property (readwrite, assign) NIPhotoView* photoView;
+
+@end
+
+
+
+
+
+@implementation NIPhotoTilingView
+
+@synthesize tileSource = _tileSource;
+@synthesize photoView = _photoView;
+
+
+
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_tileSource);
+
+  [super dealloc];
+}
+
+
+
++ (Class)layerClass {
+  return [CATiledLayer class];
+}
+
+
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    // The image view shows through until the tiles have been drawn.
+    self.opaque = NO;
+    self.userInteractionEnabled = NO;
+  }
+  return self;
+}
+
+
+
+- (void)drawRect:(CGRect)rect {
+  id<NIPhotoViewTileSource> tileSource = self.tileSource;
+  if (nil == tileSource) {
+    return;
+  }
+
+  CATiledLayer* tiledLayer = (CATiledLayer *)self.layer;
+  CGContextRef context = UIGraphicsGetCurrentContext();
+
+  // The context is scaled to the level of detail being drawn, in device pixels per image pixel.
+  // Pick the pyramid level with at least that many pixels. Above the original size there are
+  // no more pixels to be had, so the original tiles are stretched.
+  CGFloat scale = CGContextGetCTM(context).a;
+  scale = MIN(1, powf(2, ceilf(log2f(scale))));
+  CGFloat smallestScale = powf(2, -(CGFloat)(tiledLayer.levelsOfDetail - 1));
+  scale = MAX(smallestScale, scale);
+
+  // The tile size in the view's coordinates, which are the original image's pixels.
+  CGSize tileSize = tiledLayer.tileSize;
+  tileSize.width /= scale;
+  tileSize.height /= scale;
+
+  NSInteger firstColumn = (NSInteger)floorf(CGRectGetMinX(rect) / tileSize.width);
+  NSInteger lastColumn = (NSInteger)floorf((CGRectGetMaxX(rect) - 1) / tileSize.width);
+  NSInteger firstRow = (NSInteger)floorf(CGRectGetMinY(rect) / tileSize.height);
+  NSInteger lastRow = (NSInteger)floorf((CGRectGetMaxY(rect) - 1) / tileSize.height);
+
+  NIPhotoView* photoView = self.photoView;
+  CGRect bounds = self.bounds;
+  for (NSInteger row = firstRow; row <= lastRow; ++row) {
+    for (NSInteger column = firstColumn; column <= lastColumn; ++column) {
+      UIImage* tile = [tileSource photoView: photoView
+                               tileForScale: scale
+                                        row: row
+                                     column: column];
+      if (nil == tile) {
+        continue;
+      }
+
+      // Tiles along the right and bottom edges are cut short by the edge of the image.
+      CGRect tileRect = CGRectMake(tileSize.width * column, tileSize.height * row,
+                                   tileSize.width, tileSize.height);
+      tileRect = CGRectIntersection(bounds, tileRect);
+      [tile drawInRect:tileRect];
+    }
+  }
+}
+
+@end
+
+
+
+
+
 @interface NIPhotoView()
 @property (nonatomic, readwrite, assign) NIPhotoViewPhotoSize photoSize;
 - (void)setMaxMinZoomScalesForCurrentBounds;
+- (void)layoutContentAndResetZoom;
+- (CGPoint)pointToCenterAfterRotation;
+- (CGFloat)scaleToRestoreAfterRotation;
+- (void)restoreCenterPoint:(CGPoint)oldCenter scale:(CGFloat)oldScale;
 @end
 
 
@@ -97,6 +226,9 @@
 
 
 - (void)dealloc {
+  _tilingView.tileSource = nil;
+  _tilingView.photoView = nil;
+  NI_RELEASE_SAFELY(_tilingView);
   NI_RELEASE_SAFELY(_doubleTapGestureRecognizer);
   NI_RELEASE_SAFELY(_reuseIdentifier);
 
@@ -162,6 +294,21 @@
 
 
 
+- (void)scrollViewDidEndZooming:(UIScrollView *)scrollView withView:(UIView *)view atScale:(float)scale {
+  if (NIPhotoViewPhotoSizeReduced != self.photoSize || nil != _tilingView) {
+    return;
+  }
+
+  // Past this scale each pixel of the reduced image covers more than one pixel of the screen.
+  if (scale > (1.0f / NIScreenScale()) + FLT_EPSILON
+      && [self.photoStripViewDelegate respondsToSelector:
+          @selector(photoScrollViewDidZoomPastImageResolution:)]) {
+    [self.photoStripViewDelegate photoScrollViewDidZoomPastImageResolution:self];
+  }
+}
+
+
+
 
 #pragma mark -
 #pragma mark Gesture Recognizers
@@ -238,10 +385,12 @@
 
 
 - (void)prepareForReuse {
+  [self setTileSource:nil imageSize:CGSizeZero];
   _imageView.image = nil;
   self.photoSize = NIPhotoViewPhotoSizeUnknown;
-  _scrollView.zoomScale = 1;
-  _scrollView.contentSize = self.bounds.size;
+
+  // The scroll view is left as it is. The next image is often the loading image again, in
+  // which case it is already configured for it.
 }
 
 
@@ -259,8 +408,24 @@
 
 
 - (void)setImage:(UIImage *)image photoSize:(NIPhotoViewPhotoSize)photoSize {
+  NIFrameWork previousWork = NIFrameMonitorBeginWork(NIFrameWorkSetImage);
+
+  // When a reduced image is replaced by its original the user has zoomed in to see more
+  // detail, so keep the same part of the photo on screen rather than zooming back out.
+  BOOL isReplacingReducedImage = (NIPhotoViewPhotoSizeReduced == self.photoSize
+                                  && NIPhotoViewPhotoSizeOriginal == photoSize
+                                  && nil != image && nil == _tilingView
+                                  && _imageView.bounds.size.width > 0);
+  CGPoint restorePoint = CGPointZero;
+  CGFloat restoreScale = 0;
+  CGFloat relativeSize = 1;
+  if (isReplacingReducedImage) {
+    restorePoint = [self pointToCenterAfterRotation];
+    restoreScale = [self scaleToRestoreAfterRotation];
+    relativeSize = image.size.width / _imageView.bounds.size.width;
+  }
+
   _imageView.image = image;
-  [_imageView sizeToFit];
 
   if (nil == image) {
     self.photoSize = NIPhotoViewPhotoSizeUnknown;
@@ -269,36 +434,165 @@
     self.photoSize = photoSize;
   }
 
+  [self layoutContentAndResetZoom];
+
+  if (isReplacingReducedImage) {
+    [self restoreCenterPoint: CGPointMake(restorePoint.x * relativeSize,
+                                          restorePoint.y * relativeSize)
+                       scale: restoreScale / relativeSize];
+  }
+
+  NIFrameMonitorEndWork(previousWork);
+}
+
+
+
+- (BOOL)isConfiguredForContentSize:(CGSize)contentSize {
+  NIPhotoViewPhotoSize photoSize = ((nil != _tilingView)
+                                    ? NIPhotoViewPhotoSizeOriginal
+                                    : self.photoSize);
+  return (CGSizeEqualToSize(contentSize, _appliedContentSize)
+          && CGSizeEqualToSize(_scrollView.bounds.size, _appliedBoundsSize)
+          && CGSizeEqualToSize(self.photoDimensions, _appliedPhotoDimensions)
+          && photoSize == _appliedPhotoSize
+          && _zoomingAboveOriginalSizeIsEnabled == _appliedZoomingAboveOriginalSize
+          && _scrollView.zoomScale <= _scrollView.minimumZoomScale + FLT_EPSILON
+          && _scrollView.zoomScale + FLT_EPSILON >= _scrollView.minimumZoomScale);
+}
+
+
+
+- (void)layoutContentAndResetZoom {
+  UIImage* image = _imageView.image;
+
+  CGSize contentSize = self.bounds.size;
+  if (nil != _tilingView) {
+    contentSize = _tiledImageSize;
+
+  } else if (nil != image) {
+    contentSize = image.size;
+  }
+
+  // Nothing the zoom scales are calculated from has changed and the photo is still zoomed out
+  // to fit, so the scroll view would be configured exactly as it already is.
+  if ([self isConfiguredForContentSize:contentSize]) {
+    return;
+  }
+
   // The min/max zoom values assume that the content size is the image size. The max zoom will
   // be a value that allows the image to be seen at a 1-to-1 pixel resolution, while the min
   // zoom will be small enough to fit the image on the screen perfectly.
-  if (nil != image) {
+  if (nil != _tilingView) {
+    // The image is only a stand-in for the tiles, so it is stretched to the original size.
+    _imageView.bounds = CGRectMake(0, 0, _tiledImageSize.width, _tiledImageSize.height);
+    _scrollView.contentSize = _tiledImageSize;
+
+  } else if (nil != image) {
+    [_imageView sizeToFit];
     _scrollView.contentSize = image.size;
 
   } else {
+    [_imageView sizeToFit];
     _scrollView.contentSize = self.bounds.size;
   }
 
   [self setMaxMinZoomScalesForCurrentBounds];
 
+  if (nil != _tilingView) {
+    // One level of detail for each halving of the image until it fits the screen at the
+    // minimum zoom scale.
+    CATiledLayer* tiledLayer = (CATiledLayer *)_tilingView.layer;
+    CGFloat detail = _scrollView.minimumZoomScale * NIScreenScale();
+    size_t levelsOfDetail = 1;
+    while (detail < 1 && levelsOfDetail < 16) {
+      detail *= 2;
+      ++levelsOfDetail;
+    }
+    tiledLayer.levelsOfDetail = levelsOfDetail;
+  }
+
   // Start off with the image fully-visible on the screen.
   _scrollView.zoomScale = _scrollView.minimumZoomScale;
 
+  _appliedContentSize = contentSize;
+  _appliedBoundsSize = _scrollView.bounds.size;
+  _appliedPhotoDimensions = self.photoDimensions;
+  _appliedPhotoSize = (nil != _tilingView) ? NIPhotoViewPhotoSizeOriginal : self.photoSize;
+  _appliedZoomingAboveOriginalSize = _zoomingAboveOriginalSizeIsEnabled;
+
   [self setNeedsLayout];
 }
 
 
 
+- (NSUInteger)numberOfLayoutPasses {
+  return _scrollView.numberOfLayoutPasses;
+}
+
+
+
 - (UIImage *)image {
   return _imageView.image;
 }
 
 
 
+- (void)setTileSource:(id<NIPhotoViewTileSource>)tileSource imageSize:(CGSize)imageSize {
+  if (nil == tileSource || imageSize.width <= 0 || imageSize.height <= 0) {
+    if (nil == _tilingView) {
+      return;
+    }
+    // Tiles may still be drawing on another thread, so cut them off from the source first.
+    _tilingView.tileSource = nil;
+    _tilingView.photoView = nil;
+    [_tilingView removeFromSuperview];
+    NI_RELEASE_SAFELY(_tilingView);
+    _tiledImageSize = CGSizeZero;
+
+  } else {
+    if (nil == _tilingView) {
+      _tilingView = [[NIPhotoTilingView alloc] initWithFrame:CGRectZero];
+      _tilingView.autoresizingMask = (UIViewAutoresizingFlexibleWidth
+                                      | UIViewAutoresizingFlexibleHeight);
+      _tilingView.photoView = self;
+      [_imageView addSubview:_tilingView];
+    }
+
+    CGSize tileSize = CGSizeMake(kDefaultTileDimension, kDefaultTileDimension);
+    if ([tileSource respondsToSelector:@selector(tileSizeForPhotoView:)]) {
+      tileSize = [tileSource tileSizeForPhotoView:self];
+    }
+    ((CATiledLayer *)_tilingView.layer).tileSize = tileSize;
+
+    _tilingView.tileSource = tileSource;
+    _tiledImageSize = imageSize;
+
+    // Throw away tiles drawn from the previous source.
+    _tilingView.layer.contents = nil;
+    [_tilingView setNeedsDisplay];
+  }
+
+  [self layoutContentAndResetZoom];
+
+  _tilingView.frame = _imageView.bounds;
+}
+
+
+
+- (id<NIPhotoViewTileSource>)tileSource {
+  return _tilingView.tileSource;
+}
+
+
+
 - (void)setZoomingIsEnabled:(BOOL)enabled {
+  // Setting the same value again would only reset the zoom.
+  if (enabled == _zoomingIsEnabled && nil != _scrollView) {
+    return;
+  }
   _zoomingIsEnabled = enabled;
 
-  if (nil != _imageView.image) {
+  if (nil != _imageView.image || nil != _tilingView) {
     [self setMaxMinZoomScalesForCurrentBounds];
 
     // Fit the image on screen.
@@ -439,17 +733,22 @@
   CGFloat minScale = 0;
   CGFloat maxScale = 0;
   
+  // A tiled photo is always shown at its original size, whatever image stands in for it.
+  NIPhotoViewPhotoSize photoSize = ((nil != _tilingView)
+                                    ? NIPhotoViewPhotoSizeOriginal
+                                    : self.photoSize);
+
   // Calculate the min/max scale for the image to be presented.
   [self minAndMaxScaleForDimensions: imageSize
                          boundsSize: boundsSize
-                          photoSize: self.photoSize
+                          photoSize: photoSize
                            minScale: &minScale
                            maxScale: &maxScale];
   
   // When we show thumbnails for images that are too small for the bounds, we try to use
   // the known photo dimensions to scale the minimum scale to match what the final image
   // would be. This avoids any "snapping" effects from stretching the thumbnail too large.
-  if ((NIPhotoViewPhotoSizeThumbnail == self.photoSize)
+  if ((NIPhotoViewPhotoSizeThumbnail == photoSize)
       && !CGSizeEqualToSize(self.photoDimensions, CGSizeZero)) {
     CGFloat scaleToFitOriginal = 0;
     CGFloat originalMaxScale = 0;
@@ -470,6 +769,23 @@
     }
   }
   
+  // A reduced image only has the pixels needed to fit the bounds, but the user may zoom in as
+  // far as the original image allows. Zooming past the reduced image's own resolution is what
+  // tells the delegate to load the original.
+  if ((NIPhotoViewPhotoSizeReduced == photoSize)
+      && !CGSizeEqualToSize(self.photoDimensions, CGSizeZero)) {
+    CGFloat originalMinScale = 0;
+    CGFloat originalMaxScale = 0;
+    [self minAndMaxScaleForDimensions: self.photoDimensions
+                           boundsSize: boundsSize
+                            photoSize: NIPhotoViewPhotoSizeOriginal
+                             minScale: &originalMinScale
+                             maxScale: &originalMaxScale];
+
+    CGFloat relativeSize = self.photoDimensions.width / imageSize.width;
+    maxScale = MAX(maxScale, originalMaxScale * relativeSize);
+  }
+
   // If zooming is disabled then we flatten the range for zooming to only allow the min zoom.
   _scrollView.maximumZoomScale = [self isZoomingEnabled] ? maxScale : minScale;
   _scrollView.minimumZoomScale = minScale;
@@ -559,6 +875,7 @@
   self.frame = frame;
   [self setMaxMinZoomScalesForCurrentBounds];
   [self restoreCenterPoint:restorePoint scale:restoreScale];
+  _appliedBoundsSize = _scrollView.bounds.size;
 
   [_scrollView setNeedsLayout];
 }
@@ -38,5 +38,17 @@
 - (void)photoScrollViewDidDoubleTapToZoom: (NIPhotoView *)photoScrollView
                                 didZoomIn: (BOOL)didZoomIn;
 
+/**
+ * The user has zoomed a reduced photo in past the resolution of its image.
+ *
+ * Sent when zooming ends while the photo is NIPhotoViewPhotoSizeReduced and the image no
+ * longer has a pixel for every pixel on the screen. This is the time to decode the original
+ * image and show it with NIPhotoViewPhotoSizeOriginal. The photo view keeps the zoomed-in
+ * area on screen when the image is replaced.
+ *
+ *      @param photoScrollView  The photo scroll view that was zoomed.
+ */
+- (void)photoScrollViewDidZoomPastImageResolution:(NIPhotoView *)photoScrollView;
+
 @end
 
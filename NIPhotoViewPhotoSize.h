@@ -25,6 +25,9 @@ typedef enum {
   
   // A smaller version of the image.
   NIPhotoViewPhotoSizeThumbnail,
+
+  // The full-size image, decoded at only the resolution needed to fit the view.
+  NIPhotoViewPhotoSizeReduced,
   
   // The full-size image.
   NIPhotoViewPhotoSizeOriginal,
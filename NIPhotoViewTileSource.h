@@ -0,0 +1,67 @@
+//
+// Copyright 2012 Amos Elmaliah
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+@class NIPhotoView;
+
+/**
+ * Provides the pre-cut tiles of a very large photo.
+ *
+ * The tiles form a pyramid. Level 1 is the original image, level 0.5 is the image at half of
+ * its size, level 0.25 at a quarter, and so on. Each level is cut into a grid of tiles of
+ * tileSizeForPhotoView: pixels, starting from the top left corner. Tiles on the right and
+ * bottom edges may be smaller than the rest.
+ *
+ *      @ingroup Photos-Protocols
+ */
+@protocol NIPhotoViewTileSource <NSObject>
+
+@required
+
+#pragma mark Tiles /** @name [NIPhotoViewTileSource] Tiles */
+
+/**
+ * Returns the tile at the given row and column of the given level of the pyramid.
+ *
+ * This is called on background threads while the tiles are being drawn, often for several
+ * tiles at once, so it must be thread-safe. Load the tile from disk with
+ * imageWithContentsOfFile: rather than imageNamed: so that UIKit does not keep it cached;
+ * the photo view keeps only the tiles it is showing.
+ *
+ * Return nil to leave the tile empty.
+ *
+ *      @param photoView  The photo view asking for the tile.
+ *      @param scale      The level of the pyramid, a power of two no greater than 1.
+ *      @param row        The row of the tile, counted from the top of the level.
+ *      @param column     The column of the tile, counted from the left of the level.
+ */
+- (UIImage *)photoView: (NIPhotoView *)photoView
+          tileForScale: (CGFloat)scale
+                   row: (NSInteger)row
+                column: (NSInteger)column;
+
+@optional
+
+/**
+ * The size of the tiles, in pixels.
+ *
+ * By default this is 256x256.
+ */
+- (CGSize)tileSizeForPhotoView:(NIPhotoView *)photoView;
+
+@end
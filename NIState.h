@@ -16,7 +16,9 @@
 
 #import <Foundation/Foundation.h>
 
+#import "NIFrameMonitor.h"
 #import "NIInMemoryCache.h"
+#import "NIMemoryGovernor.h"
 
 /**
  * For modifying Nimbus state information.
@@ -63,6 +65,22 @@
  */
 + (NSOperationQueue *)networkOperationQueue;
 
+/**
+ * Access the global memory governor.
+ *
+ * Nimbus caches and view recyclers register with this governor when they are created. One
+ * will be created automatically if one hasn't been assigned via Nimbus::setMemoryGovernor:.
+ */
++ (NIMemoryGovernor *)memoryGovernor;
+
+/**
+ * Access the global frame monitor.
+ *
+ * One will be created automatically, but not started, if one hasn't been assigned via
+ * Nimbus::setFrameMonitor:.
+ */
++ (NIFrameMonitor *)frameMonitor;
+
 
 #pragma mark Modifying Global State /** @name Modifying Global State */
 
@@ -80,6 +98,22 @@
  */
 + (void)setNetworkOperationQueue:(NSOperationQueue *)queue;
 
+/**
+ * Set the global memory governor.
+ *
+ * The governor will be retained and the old governor released. Objects registered with the
+ * old governor stay registered with it.
+ */
++ (void)setMemoryGovernor:(NIMemoryGovernor *)memoryGovernor;
+
+/**
+ * Set the global frame monitor.
+ *
+ * The monitor will be retained and the old monitor released. The old monitor keeps
+ * monitoring until it is stopped.
+ */
++ (void)setFrameMonitor:(NIFrameMonitor *)frameMonitor;
+
 @end
 
 
@@ -20,6 +20,8 @@
 
 static NIImageMemoryCache* sNimbusGlobalMemoryCache = nil;
 static NSOperationQueue* sNimbusGlobalOperationQueue = nil;
+static NIMemoryGovernor* sNimbusGlobalMemoryGovernor = nil;
+static NIFrameMonitor* sNimbusGlobalFrameMonitor = nil;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -64,4 +66,40 @@ static NSOperationQueue* sNimbusGlobalOperationQueue = nil;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (void)setMemoryGovernor:(NIMemoryGovernor *)memoryGovernor {
+  if (sNimbusGlobalMemoryGovernor != memoryGovernor) {
+    [sNimbusGlobalMemoryGovernor release];
+    sNimbusGlobalMemoryGovernor = [memoryGovernor retain];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NIMemoryGovernor *)memoryGovernor {
+  if (nil == sNimbusGlobalMemoryGovernor) {
+    sNimbusGlobalMemoryGovernor = [[NIMemoryGovernor alloc] init];
+  }
+  return sNimbusGlobalMemoryGovernor;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (void)setFrameMonitor:(NIFrameMonitor *)frameMonitor {
+  if (sNimbusGlobalFrameMonitor != frameMonitor) {
+    [sNimbusGlobalFrameMonitor release];
+    sNimbusGlobalFrameMonitor = [frameMonitor retain];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NIFrameMonitor *)frameMonitor {
+  if (nil == sNimbusGlobalFrameMonitor) {
+    sNimbusGlobalFrameMonitor = [[NIFrameMonitor alloc] init];
+  }
+  return sNimbusGlobalFrameMonitor;
+}
+
+
 @end
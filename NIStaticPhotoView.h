@@ -0,0 +1,78 @@
+//
+// Copyright 2012 Amos Elmaliah
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIStripViewItem.h"
+#import "NIPhotoViewPhotoSize.h"
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * A photo strip item that shows a photo without any zooming.
+ *
+ * NIPhotoView is a view, a scroll view, an image view and a gesture recognizer. When a strip
+ * shows many items per page and zooming is off, all of that is wasted. This item is a single
+ * image view that scales its photo to fit, and takes the same messages NIPhotoView does for
+ * setting the photo.
+ *
+ *      @ingroup Photos-Views
+ */
+@interface NIStaticPhotoView : UIImageView <NIStripViewItem> {
+@private
+  NIPhotoViewPhotoSize _photoSize;
+  CGSize _photoDimensions;
+  NSInteger _itemIndex;
+}
+
+#pragma mark State
+
+- (NIPhotoViewPhotoSize)photoSize;
+- (void)setImage:(UIImage *)image photoSize:(NIPhotoViewPhotoSize)photoSize;
+
+@property (nonatomic, readwrite, assign) NSInteger itemIndex;
+@property (nonatomic, readwrite, assign) CGSize photoDimensions;
+
+@end
+
+/** @name State */
+
+/**
+ * Set a new photo with a specific size.
+ *
+ * If image is nil then the photoSize will be overridden as NIPhotoViewPhotoSizeUnknown.
+ *
+ * Photos are scaled to fit the view. Images of NIPhotoViewPhotoSizeUnknown, such as a loading
+ * image, are shown at their own size when they fit.
+ *
+ *      @fn NIStaticPhotoView::setImage:photoSize:
+ */
+
+/**
+ * The current size of the photo.
+ *
+ * This is used to replace the photo only with successively higher-quality versions.
+ *
+ *      @fn NIStaticPhotoView::photoSize
+ */
+
+/**
+ * The largest dimensions of the photo.
+ *
+ * Kept so that the photo view that replaces this item when it is opened can be configured
+ * the same way.
+ *
+ *      @fn NIStaticPhotoView::photoDimensions
+ */
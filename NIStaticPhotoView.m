@@ -0,0 +1,109 @@
+//
+// Copyright 2012 Amos Elmaliah
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIStaticPhotoView.h"
+#import "NimbusCore.h"
+
+@implementation NIStaticPhotoView
+
+@synthesize itemIndex = _itemIndex;
+@synthesize reuseIdentifier = _reuseIdentifier;
+@synthesize photoDimensions = _photoDimensions;
+
+
+
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_reuseIdentifier);
+
+  [super dealloc];
+}
+
+
+
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [super initWithFrame:frame])) {
+    self.contentMode = UIViewContentModeScaleAspectFit;
+    self.clipsToBounds = YES;
+    self.backgroundColor = [UIColor blackColor];
+  }
+  return self;
+}
+
+
+
+- (void)updateContentMode {
+  UIImage* image = self.image;
+  CGSize boundsSize = self.bounds.size;
+
+  // The loading image is drawn at its own size, as NIPhotoView does, unless it doesn't fit.
+  if (NIPhotoViewPhotoSizeUnknown == _photoSize
+      && image.size.width <= boundsSize.width
+      && image.size.height <= boundsSize.height) {
+    self.contentMode = UIViewContentModeCenter;
+
+  } else {
+    self.contentMode = UIViewContentModeScaleAspectFit;
+  }
+}
+
+
+
+- (void)layoutSubviews {
+  [super layoutSubviews];
+
+  [self updateContentMode];
+}
+
+
+
+
+#pragma mark -
+#pragma mark NIStripViewItem
+
+
+
+- (void)prepareForReuse {
+  self.image = nil;
+  _photoSize = NIPhotoViewPhotoSizeUnknown;
+}
+
+
+
+
+#pragma mark -
+#pragma mark Public Methods
+
+
+
+- (void)setImage:(UIImage *)image photoSize:(NIPhotoViewPhotoSize)photoSize {
+  NIFrameWork previousWork = NIFrameMonitorBeginWork(NIFrameWorkSetImage);
+
+  self.image = image;
+  _photoSize = (nil == image) ? NIPhotoViewPhotoSizeUnknown : photoSize;
+
+  [self updateContentMode];
+
+  NIFrameMonitorEndWork(previousWork);
+}
+
+
+
+- (NIPhotoViewPhotoSize)photoSize {
+  return _photoSize;
+}
+
+
+@end
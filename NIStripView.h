@@ -76,6 +76,8 @@ extern const CGFloat NIScrollViewDefaultItemHorizontalMargin;
 // It is highly recommended that you use this method to manage view recycling.
 - (UIView<NIStripViewItem> *)dequeueReusableItemWithIdentifier:(NSString *)identifier;
 
+- (void)reloadItemAtIndex:(NSInteger)itemIndex;
+
 #pragma mark State
 
 @property (nonatomic, readwrite, assign) NSInteger lastItemIndex; // Use moveToItemAtIndex:animated: to animate to a given item.
@@ -151,6 +153,18 @@ extern const CGFloat NIScrollViewDefaultItemHorizontalMargin;
  *      @fn NIScrollView::dequeueReusablePageWithIdentifier:
  */
 
+/**
+ * Replaces the view of a visible item with a new one from the data source.
+ *
+ * The old view is recycled without telling the delegate, since the item is still on screen.
+ * Does nothing if the item is not visible.
+ *
+ * Use this to swap an item for a different kind of view in place, for example a
+ * NIStaticPhotoView for a zoomable NIPhotoView once the user opens it.
+ *
+ *      @fn NIStripView::reloadItemAtIndex:
+ */
+
 /**
  * The delegate for this paging view.
  *
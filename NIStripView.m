@@ -128,8 +128,10 @@ const CGFloat NIScrollViewDefaultItemHorizontalMargin = 10;
     BOOL wasModifyingContentOffset = _isModifyingContentOffset;
     _isModifyingContentOffset = YES;
     if (self.frame.size.height && self.frame.size.width) {
+        NIDTRACEBEGIN("NIStripView.layoutSubviews");
         self.scrollView.contentSize = [self contentSizeForScrollView];
         [self layoutVisibleItems];
+        NIDTRACEEND("NIStripView.layoutSubviews");
     }
     _isModifyingContentOffset = wasModifyingContentOffset;
 }
@@ -315,7 +317,9 @@ const CGFloat NIScrollViewDefaultItemHorizontalMargin = 10;
 
     [self willDisplayItem:itemView];
     if ([self.delegate respondsToSelector:@selector(stripView:willDisplayItem:)]) {
+        NIFrameWork previousWork = NIFrameMonitorBeginWork(NIFrameWorkWillDisplayItem);
         [self.delegate stripView:self willDisplayItem:itemView];
+        NIFrameMonitorEndWork(previousWork);
     }
 
 }
@@ -352,7 +356,9 @@ const CGFloat NIScrollViewDefaultItemHorizontalMargin = 10;
 
 
 - (void)displayItemAtIndex:(NSInteger)itemIndex {
+    NIFrameWork previousWork = NIFrameMonitorBeginWork(NIFrameWorkItemViewForIndex);
     UIView<NIStripViewItem>* item = [self.dataSource stripView:self itemViewForIndex:itemIndex];
+    NIFrameMonitorEndWork(previousWork);
     NIDASSERT([item isKindOfClass:[UIView class]]);
     NIDASSERT([item conformsToProtocol:@protocol(NIStripViewItem)]);
     if (nil == item || ![item isKindOfClass:[UIView class]]
@@ -370,7 +376,31 @@ const CGFloat NIScrollViewDefaultItemHorizontalMargin = 10;
 
 
 
+- (void)reloadItemAtIndex:(NSInteger)itemIndex {
+    UIView<NIStripViewItem>* oldItem = nil;
+    for (UIView<NIStripViewItem>* item in _visibleItems) {
+        if (item.itemIndex == itemIndex) {
+            oldItem = item;
+            break;
+        }
+    }
+    if (nil == oldItem) {
+        return;
+    }
+    
+    [_viewRecycler recycleView:oldItem];
+    [oldItem removeFromSuperview];
+    [_visibleItems removeObject:oldItem];
+    
+    [self displayItemAtIndex:itemIndex];
+}
+
+
+
 - (void)updateVisibleItems {
+    NIFrameWork previousWork = NIFrameMonitorBeginWork(NIFrameWorkUpdateVisibleItems);
+    NIDTRACEBEGIN("NIStripView.updateVisibleItems");
+    
     NSRange visiblePageRange = [self calculateVisibleItemRange];
     
     // Recycle no-longer-visible items. We copy _visibleItems because we may modify it while we're
@@ -413,6 +443,9 @@ const CGFloat NIScrollViewDefaultItemHorizontalMargin = 10;
         && [self.delegate respondsToSelector:@selector(stripViewDidChangeItems:)]) {
         [self.delegate stripViewDidChangeItems:self];
     }
+    
+    NIDTRACEEND("NIStripView.updateVisibleItems");
+    NIFrameMonitorEndWork(previousWork);
 }
 
 
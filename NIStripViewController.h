@@ -64,6 +64,13 @@ NIStripViewDataSource
     
     BOOL _animateMovingToNextAndPreviousPhotos;
     
+    // The item shown as a zoomable photo while zooming is disabled, or -1.
+    NSInteger _openedItemIndex;
+    UITapGestureRecognizer* _openItemGesture;
+    
+    // While the scrubber is being dragged, items only show what is already in memory.
+    BOOL _isScrubbing;
+    
 }
 #pragma mark Views
 
@@ -78,4 +85,11 @@ NIStripViewDataSource
 
 -(CGRect)photoAlbumFrameForOrientation:(UIInterfaceOrientation)toInterfaceOrientation;
 
+/**
+ * While zooming is disabled the items are lightweight NIStaticPhotoViews. Tapping one opens it,
+ * replacing it in place with a zoomable NIPhotoView until it scrolls away or another item is
+ * opened.
+ */
+-(void)openItemAtIndex:(NSInteger)itemIndex;
+
 @end
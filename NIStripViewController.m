@@ -29,6 +29,7 @@
 #define kCacheKeyForThumbs @"kCacheKeyForThumbs"
 
 @interface NIStripViewController () <NIPhotoViewDelegate, NetworkPhotoAlbumQueueDelegate>
+-(BOOL)isZoomingEnabledForItem:(UIView<NIStripViewItem>*)item;
 @end
 
 @implementation NIStripViewController
@@ -67,6 +68,7 @@
 - (id)initWithNibName:(NSString *)nibNameOrNil bundle:(NSBundle *)nibBundleOrNil {
     if ((self = [super initWithNibName:nibNameOrNil bundle:nibBundleOrNil])) {
         self.animateMovingToNextAndPreviousPhotos = NO;
+        _openedItemIndex = -1;
     }
     return self;
 }
@@ -109,6 +111,7 @@
     [_queue cancelAllOperations];
     
     NI_RELEASE_SAFELY(_tapGesture);
+    NI_RELEASE_SAFELY(_openItemGesture);
 }
 
 
@@ -142,7 +145,22 @@
     _queue = [[NetworkPhotosDownloadQueue alloc] initWithImageCacheKeys:cacheKeys];
     _queue.delegate = self;
 
+    // Thumbnails are cheap and stay visible in the scrubber; off-screen high-res photos go first.
+    NIMemoryGovernor* memoryGovernor = [Nimbus memoryGovernor];
+    [memoryGovernor setPriority: NIMemoryPriorityHigh
+                      forObject: [_queue cacheWithKey:kCacheKeyForThumbs]];
+    [memoryGovernor setPriority: NIMemoryPriorityLow
+                      forObject: [_queue cacheWithKey:kCacheKeyForHighRes]];
+
     //[self addTapGestureToView];
+
+    // One recognizer for the whole strip rather than one for every static item.
+    if (nil != NIUITapGestureRecognizerClass()
+        && [_photoAlbumView respondsToSelector:@selector(addGestureRecognizer:)]) {
+        _openItemGesture = [[NIUITapGestureRecognizerClass() alloc] initWithTarget: self
+                                                                            action: @selector(didTapToOpenItem:)];
+        [_photoAlbumView addGestureRecognizer:_openItemGesture];
+    }
 }
 
 
@@ -154,8 +172,28 @@
 
 
 
+- (void)updateMaxPixelDimension {
+    // Decode photos at no more than the size they fit the strip at. The original is only
+    // decoded when the user zooms past that. The strip's size is only final once it has been
+    // laid out, and it changes with the orientation.
+    CGSize stripSize = _photoAlbumView.bounds.size;
+    [_queue setMaxPixelDimension: MAX(stripSize.width, stripSize.height) * NIScreenScale()
+                     forCacheKey: kCacheKeyForHighRes];
+}
+
+
+
 - (void)viewWillAppear:(BOOL)animated {
     [super viewWillAppear:animated];
+    [self updateMaxPixelDimension];
+}
+
+
+
+- (void)viewDidLayoutSubviews {
+    // Not called before iOS 5; viewWillAppear: and the rotation callbacks cover those versions.
+    [super viewDidLayoutSubviews];
+    [self updateMaxPixelDimension];
 }
 
 
@@ -190,6 +228,7 @@
                                             duration:duration];
     
     self.photoAlbumView.frame = [self photoAlbumFrameForOrientation:toInterfaceOrientation];;
+    [self updateMaxPixelDimension];
 }
 
 #pragma mark -
@@ -211,24 +250,44 @@
     }
 }
 
+-(NIPhotoViewPhotoSize)photoSizeForImage:(UIImage*)image atIndex:(NSInteger)photoIndex cacheKey:(NSString*)cacheKey
+{
+    NIPhotoViewPhotoSize photoSize = [self PhotoSizeFromCacheKey:cacheKey];
+    if (NIPhotoViewPhotoSizeOriginal == photoSize) {
+        // High-res images are decoded at the size of the strip, so they may have fewer pixels
+        // than the photo.
+        NSDictionary* photo = [_photos objectAtIndex:photoIndex];
+        CGSize dimensions = [[photo objectForKey:@"dimensions"] CGSizeValue];
+        CGFloat imageDimension = MAX(image.size.width, image.size.height) * image.scale;
+        if (imageDimension + 1 < MAX(dimensions.width, dimensions.height)) {
+            photoSize = NIPhotoViewPhotoSizeReduced;
+        }
+    }
+    return photoSize;
+}
+
 -(void)queue: (NetworkPhotosDownloadQueue*)queue 
 didLoadPhoto: (UIImage*) image
      atIndex: (NSInteger) photoIndex
     cacheKey: (NSString*) cacheKey;
 {
-    NIPhotoViewPhotoSize photoSize = [self PhotoSizeFromCacheKey:cacheKey];
-    for (NIPhotoView* item in _photoAlbumView.visibleItems) {
+    NIPhotoViewPhotoSize photoSize = [self photoSizeForImage:image atIndex:photoIndex cacheKey:cacheKey];
+    for (UIView<NIStripViewItem>* item in _photoAlbumView.visibleItems) {
         if (item.itemIndex == photoIndex) {
+            // NIPhotoView and NIStaticPhotoView both take the photo the same way.
+            id photoItem = item;
             
             // Only replace the photo if it's of a higher quality than one we're already showing.
-            if (photoSize > item.photoSize) {
-                [item setImage:image photoSize:photoSize];
+            if (photoSize > [photoItem photoSize]) {
+                [photoItem setImage:image photoSize:photoSize];
                 
-                item.zoomingIsEnabled = ([self isZoomingEnabled]
-                                         && (NIPhotoViewPhotoSizeOriginal == photoSize));
+                if ([item isKindOfClass:[NIPhotoView class]]) {
+                    [(NIPhotoView *)item setZoomingIsEnabled:([self isZoomingEnabledForItem:item]
+                                                              && (NIPhotoViewPhotoSizeReduced <= photoSize))];
+                }
                 
                 // Notify the delegate that the photo has been loaded.
-                if (NIPhotoViewPhotoSizeOriginal == photoSize) {
+                if (NIPhotoViewPhotoSizeReduced <= photoSize) {
                     [_photoAlbumView notifyDelegatePhotoDidLoadAtIndex:photoIndex];
                 }
             }
@@ -252,8 +311,11 @@ didLoadPhoto: (UIImage*) image
 
 - (void)stripView:(NIStripView*)stripView willDisplayItem:(UIView<NIStripViewItem> *)theItemView
 {
-    if ([theItemView isKindOfClass:[NIPhotoView class]]) {
-        NIPhotoView * viewItem = (NIPhotoView*)theItemView;
+    if ([theItemView isKindOfClass:[NIPhotoView class]]
+        || [theItemView isKindOfClass:[NIStaticPhotoView class]]) {
+        // NIPhotoView and NIStaticPhotoView both take the photo the same way.
+        id viewItem = theItemView;
+        BOOL isZoomable = [theItemView isKindOfClass:[NIPhotoView class]];
 
         // When we ask the data source for the image we expect the following to happen:
         // 1) If the data source has any image at this index, it should return it and set the
@@ -267,7 +329,7 @@ didLoadPhoto: (UIImage*) image
         NIPhotoViewPhotoSize photoSize = NIPhotoViewPhotoSizeUnknown;
         BOOL isLoading = NO;
         CGSize originalPhotoDimensions = CGSizeZero;
-        NSUInteger photoIndex = viewItem.itemIndex;
+        NSUInteger photoIndex = theItemView.itemIndex;
         
         UIImage* image = nil;
         
@@ -276,10 +338,18 @@ didLoadPhoto: (UIImage*) image
         // Let the photo album view know how large the photo will be once it's fully loaded.
         originalPhotoDimensions = [[photo objectForKey:@"dimensions"] CGSizeValue];
         
-        image = [_queue imageAtPhotoIndex:photoIndex
-                             withCacheKey:kCacheKeyForHighRes];
-        if (nil != image) {
-            photoSize = NIPhotoViewPhotoSizeOriginal;
+        if (_isScrubbing) {
+            // Most of the photos passed while scrubbing are only on screen for a moment, so
+            // show the thumbnail if it's in memory and leave the loading until the scrub ends.
+            image = [_queue cachedImageAtPhotoIndex:photoIndex
+                                       withCacheKey:kCacheKeyForThumbs];
+            if (nil != image) {
+                photoSize = NIPhotoViewPhotoSizeThumbnail;
+            }
+            
+        } else if (nil != (image = [_queue imageAtPhotoIndex:photoIndex
+                                                withCacheKey:kCacheKeyForHighRes])) {
+            photoSize = [self photoSizeForImage:image atIndex:photoIndex cacheKey:kCacheKeyForHighRes];
             
         } else {
             NSString* source = [photo objectForKey:@"originalSource"];
@@ -305,20 +375,22 @@ didLoadPhoto: (UIImage*) image
             }
         }
 
-        viewItem.photoDimensions = originalPhotoDimensions;
+        [viewItem setPhotoDimensions:originalPhotoDimensions];
         
         if (nil == image) {
             //viewItem.zoomingIsEnabled = NO;
             [viewItem setImage:self.loadingImage photoSize:NIPhotoViewPhotoSizeUnknown];
             
         } else {
-            viewItem.zoomingIsEnabled = ([self isZoomingEnabled]
-                                     && (NIPhotoViewPhotoSizeOriginal == photoSize));
-            if (photoSize > viewItem.photoSize) {
+            if (isZoomable) {
+                [viewItem setZoomingIsEnabled:([self isZoomingEnabledForItem:theItemView]
+                                               && (NIPhotoViewPhotoSizeReduced <= photoSize))];
+            }
+            if (photoSize > [viewItem photoSize]) {
                 [viewItem setImage:image photoSize:photoSize];
                 
-                if (NIPhotoViewPhotoSizeOriginal == photoSize) {
-                    [_photoAlbumView notifyDelegatePhotoDidLoadAtIndex:viewItem.itemIndex];
+                if (NIPhotoViewPhotoSizeReduced <= photoSize) {
+                    [_photoAlbumView notifyDelegatePhotoDidLoadAtIndex:photoIndex];
                 }
             }
         }
@@ -328,6 +400,11 @@ didLoadPhoto: (UIImage*) image
 
 - (void)stripView:(NIStripView*)stripView didRecycleItem:(UIView<NIStripViewItem> *)item
 {
+    // An opened item closes once it scrolls away.
+    if (item.itemIndex == _openedItemIndex) {
+        _openedItemIndex = -1;
+    }
+    
     // Give the data source the opportunity to kill any asynchronous operations for this
     // now-recycled item.
     if ([stripView.dataSource respondsToSelector:
@@ -365,6 +442,19 @@ didLoadPhoto: (UIImage*) image
                       itemViewForIndex:(NSInteger)itemIndex 
 {
     UIView<NIStripViewItem>* itemView = nil;
+    
+    // Without zooming a plain image view is all an item needs, until the user opens it.
+    if (![self isZoomingEnabled] && itemIndex != _openedItemIndex) {
+        NSString* reuseIdentifier = @"staticPhoto";
+        itemView = [stripView dequeueReusableItemWithIdentifier:reuseIdentifier];
+        if (nil == itemView) {
+            itemView = [[[NIStaticPhotoView alloc] init] autorelease];
+            itemView.reuseIdentifier = reuseIdentifier;
+            itemView.backgroundColor = self.photoViewBackgroundColor;
+        }
+        return itemView;
+    }
+    
     NSString* reuseIdentifier = @"photo";
     itemView = [stripView dequeueReusableItemWithIdentifier:reuseIdentifier];
     if (nil == itemView) {
@@ -380,6 +470,42 @@ didLoadPhoto: (UIImage*) image
     return itemView;
 }
 
+#pragma mark -
+#pragma mark Opening Items
+
+-(BOOL)isZoomingEnabledForItem:(UIView<NIStripViewItem>*)item
+{
+    return [self isZoomingEnabled] || item.itemIndex == _openedItemIndex;
+}
+
+-(void)openItemAtIndex:(NSInteger)itemIndex
+{
+    if ([self isZoomingEnabled] || itemIndex == _openedItemIndex) {
+        return;
+    }
+    
+    // Only one item is zoomable at a time; the last one goes back to being a static view.
+    NSInteger previousItemIndex = _openedItemIndex;
+    _openedItemIndex = itemIndex;
+    if (previousItemIndex >= 0) {
+        [_photoAlbumView reloadItemAtIndex:previousItemIndex];
+    }
+    [_photoAlbumView reloadItemAtIndex:itemIndex];
+}
+
+- (void)didTapToOpenItem:(UITapGestureRecognizer *)gesture
+{
+    UIScrollView* scrollView = _photoAlbumView.scrollView;
+    CGPoint location = [gesture locationInView:scrollView];
+    for (UIView<NIStripViewItem>* item in _photoAlbumView.visibleItems) {
+        if ([item isKindOfClass:[NIStaticPhotoView class]]
+            && CGRectContainsPoint(item.frame, location)) {
+            [self openItemAtIndex:item.itemIndex];
+            break;
+        }
+    }
+}
+
 #pragma mark -
 #pragma mark NIPhotoViewDelegate
 
@@ -389,6 +515,25 @@ didLoadPhoto: (UIImage*) image
     
 }
 
+- (void)photoScrollViewDidZoomPastImageResolution:(NIPhotoView *)photoScrollView
+{
+    // The original is kept in the high-res cache once it has been decoded.
+    NSInteger photoIndex = photoScrollView.itemIndex;
+    UIImage* image = [_queue cachedImageAtPhotoIndex:photoIndex withCacheKey:kCacheKeyForHighRes];
+    if (nil != image
+        && NIPhotoViewPhotoSizeOriginal == [self photoSizeForImage: image
+                                                           atIndex: photoIndex
+                                                          cacheKey: kCacheKeyForHighRes]) {
+        [photoScrollView setImage:image photoSize:NIPhotoViewPhotoSizeOriginal];
+        return;
+    }
+
+    // Decoded in the background and delivered through queue:didLoadPhoto:atIndex:cacheKey:.
+    // If the downloaded data has been evicted the reduced image stays until the photo is
+    // shown again.
+    [_queue requestOriginalImageAtPhotoIndex:photoIndex withCacheKey:kCacheKeyForHighRes];
+}
+
 #pragma mark -
 #pragma mark UIGestureRecognizer
 
@@ -433,6 +578,26 @@ didLoadPhoto: (UIImage*) image
     
 }
 
+- (void)photoScrubberViewDidBeginScrubbing:(NIPhotoScrubberView *)photoScrubberView {
+    _isScrubbing = YES;
+}
+
+- (void)photoScrubberViewDidEndScrubbing:(NIPhotoScrubberView *)photoScrubberView {
+    _isScrubbing = NO;
+    
+    // Drop the downloads of the photos that were skipped over.
+    NSMutableIndexSet* visibleIndexes = [NSMutableIndexSet indexSet];
+    for (UIView<NIStripViewItem>* itemView in self.photoAlbumView.visibleItems) {
+        [visibleIndexes addIndex:itemView.itemIndex];
+    }
+    [_queue cancelRequestsForPhotoIndexesNotInSet:visibleIndexes];
+    
+    // Now load the photos the scrub settled on.
+    for (UIView<NIStripViewItem>* itemView in self.photoAlbumView.visibleItems) {
+        [self stripView:self.photoAlbumView willDisplayItem:itemView];
+    }
+}
+
 
 
 
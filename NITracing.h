@@ -0,0 +1,50 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "NIDebuggingTools.h"
+
+/**
+ * For exporting the events recorded with the NIDTRACE macros.
+ *
+ *      @ingroup Debugging-Tools
+ *
+ * The export is in the Chrome trace event format. Open it in chrome://tracing, or read it from
+ * a script to compare runs without Instruments.
+ *
+ * These functions only exist when NI_TRACING is defined.
+ */
+
+#ifdef NI_TRACING
+
+/**
+ * Returns every recorded event as Chrome trace event JSON.
+ *
+ * Safe to call while other threads are recording; events they record during the export may
+ * be left out.
+ */
+NSData* NITraceChromeJSONData(void);
+
+/**
+ * Forgets every recorded event.
+ *
+ * Call this only while no other thread is recording, for example before the work to be traced
+ * begins.
+ */
+void NITraceReset(void);
+
+#endif // #ifdef NI_TRACING
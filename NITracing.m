@@ -0,0 +1,190 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NITracing.h"
+
+#ifdef NI_TRACING
+
+#import "JSONKit.h"
+
+#import <libkern/OSAtomic.h>
+#import <mach/mach.h>
+#import <mach/mach_time.h>
+#import <pthread.h>
+#import <unistd.h>
+
+// Once a thread's buffer is full, its later events are dropped and counted.
+static const int32_t kNumberOfEventsPerBuffer = 8192;
+
+typedef struct {
+  uint64_t    time;
+  const char* name;
+  const void* identifier;
+  char        phase;
+} NITraceEvent;
+
+// Only the owning thread writes to a buffer. It fills an event before publishing the new count,
+// so an exporting thread reads only complete events.
+typedef struct NITraceBuffer {
+  NITraceEvent*         events;
+  volatile int32_t      numberOfEvents;
+  volatile int32_t      numberOfDroppedEvents;
+  mach_port_t           threadID;
+  BOOL                  isMainThread;
+  struct NITraceBuffer* next;
+} NITraceBuffer;
+
+// Buffers are never freed, so that the events of threads that have exited can still be
+// exported. New buffers are pushed onto the front of the list.
+static NITraceBuffer* volatile sFirstBuffer = NULL;
+static pthread_key_t sBufferKey;
+static pthread_once_t sBufferKeyOnce = PTHREAD_ONCE_INIT;
+
+// Events dropped because their thread's buffer could not be allocated.
+static volatile int32_t sNumberOfUnbufferedDroppedEvents = 0;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NITraceCreateBufferKey(void) {
+  pthread_key_create(&sBufferKey, NULL);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Returns NULL if the buffer could not be allocated.
+static NITraceBuffer* NITraceBufferForCurrentThread(void) {
+  pthread_once(&sBufferKeyOnce, NITraceCreateBufferKey);
+  NITraceBuffer* buffer = pthread_getspecific(sBufferKey);
+  if (NULL == buffer) {
+    buffer = calloc(1, sizeof(NITraceBuffer));
+    if (NULL == buffer) {
+      return NULL;
+    }
+    buffer->events = malloc(kNumberOfEventsPerBuffer * sizeof(NITraceEvent));
+    if (NULL == buffer->events) {
+      free(buffer);
+      return NULL;
+    }
+    buffer->threadID = pthread_mach_thread_np(pthread_self());
+    buffer->isMainThread = (0 != pthread_main_np());
+    do {
+      buffer->next = sFirstBuffer;
+    } while (!OSAtomicCompareAndSwapPtrBarrier(buffer->next, buffer, (void* volatile *)&sFirstBuffer));
+    pthread_setspecific(sBufferKey, buffer);
+  }
+  return buffer;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NITraceRecordEvent(char phase, const char* name, const void* identifier) {
+  uint64_t time = mach_absolute_time();
+  NITraceBuffer* buffer = NITraceBufferForCurrentThread();
+  if (NULL == buffer) {
+    OSAtomicIncrement32(&sNumberOfUnbufferedDroppedEvents);
+    return;
+  }
+
+  int32_t numberOfEvents = buffer->numberOfEvents;
+  if (numberOfEvents >= kNumberOfEventsPerBuffer) {
+    buffer->numberOfDroppedEvents++;
+    return;
+  }
+
+  NITraceEvent* event = &buffer->events[numberOfEvents];
+  event->time = time;
+  event->name = name;
+  event->identifier = identifier;
+  event->phase = phase;
+
+  OSMemoryBarrier();
+  buffer->numberOfEvents = numberOfEvents + 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NITraceReset(void) {
+  for (NITraceBuffer* buffer = sFirstBuffer; NULL != buffer; buffer = buffer->next) {
+    buffer->numberOfEvents = 0;
+    buffer->numberOfDroppedEvents = 0;
+  }
+  sNumberOfUnbufferedDroppedEvents = 0;
+  OSMemoryBarrier();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSData* NITraceChromeJSONData(void) {
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  // Chrome trace timestamps are in microseconds.
+  double microsecondsPerTick = (double)timebase.numer / (double)timebase.denom / 1000.0;
+
+  NSNumber* processID = [NSNumber numberWithInt:getpid()];
+  NSMutableArray* traceEvents = [NSMutableArray array];
+  NSInteger numberOfDroppedEvents = 0;
+
+  OSMemoryBarrier();
+  numberOfDroppedEvents += sNumberOfUnbufferedDroppedEvents;
+  for (NITraceBuffer* buffer = sFirstBuffer; NULL != buffer; buffer = buffer->next) {
+    int32_t numberOfEvents = buffer->numberOfEvents;
+    OSMemoryBarrier();
+    numberOfDroppedEvents += buffer->numberOfDroppedEvents;
+
+    NSNumber* threadID = [NSNumber numberWithUnsignedInt:buffer->threadID];
+    if (buffer->isMainThread) {
+      [traceEvents addObject:
+       [NSDictionary dictionaryWithObjectsAndKeys:
+        @"thread_name", @"name",
+        @"M", @"ph",
+        processID, @"pid",
+        threadID, @"tid",
+        [NSDictionary dictionaryWithObject:@"main" forKey:@"name"], @"args",
+        nil]];
+    }
+
+    for (int32_t ix = 0; ix < numberOfEvents; ++ix) {
+      const NITraceEvent* event = &buffer->events[ix];
+      NSMutableDictionary* traceEvent =
+      [NSMutableDictionary dictionaryWithObjectsAndKeys:
+       [NSString stringWithUTF8String:event->name], @"name",
+       @"nimbus", @"cat",
+       [NSString stringWithFormat:@"%c", event->phase], @"ph",
+       [NSNumber numberWithDouble:(double)event->time * microsecondsPerTick], @"ts",
+       processID, @"pid",
+       threadID, @"tid",
+       nil];
+      if ('i' == event->phase) {
+        [traceEvent setObject:@"t" forKey:@"s"];
+
+      } else if ('b' == event->phase || 'e' == event->phase) {
+        [traceEvent setObject:[NSString stringWithFormat:@"%p", event->identifier] forKey:@"id"];
+      }
+      [traceEvents addObject:traceEvent];
+    }
+  }
+
+  NSDictionary* trace =
+  [NSDictionary dictionaryWithObjectsAndKeys:
+   traceEvents, @"traceEvents",
+   @"ms", @"displayTimeUnit",
+   [NSDictionary dictionaryWithObject: [NSNumber numberWithInteger:numberOfDroppedEvents]
+                               forKey: @"droppedEvents"], @"otherData",
+   nil];
+  return [trace JSONData];
+}
+
+#endif // #ifdef NI_TRACING
@@ -17,6 +17,8 @@
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 
+#import "NIMemoryGovernor.h"
+
 /**
  * For recycling views in scroll views.
  *
@@ -68,7 +70,7 @@ if (nil == view) {
  *
  * This sort of object is what UITableView and NIScrollView use to recycle their views.
  */
-@interface NIViewRecycler : NSObject {
+@interface NIViewRecycler : NSObject <NIMemoryGovernedObject> {
 @private
   NSMutableDictionary* _reuseIdentifiersToRecycledViews;
 }
@@ -77,6 +79,10 @@ if (nil == view) {
 - (void)recycleView:(UIView<NIRecyclableView> *)view;
 - (void)removeAllViews;
 
+- (unsigned long long)memoryCost;
+- (void)reduceMemoryCostTo:(unsigned long long)memoryCost;
+- (void)reduceMemoryUsage;
+
 @end
 
 /**
@@ -124,3 +130,24 @@ if (nil == view) {
  *
  *      @fn NIViewRecycler::removeAllViews
  */
+
+/**
+ * An estimate of the bytes held by the recycled views' backing stores.
+ *
+ * Each view is counted as a 32-bit bitmap the size of its bounds at the screen's scale.
+ *
+ *      @fn NIViewRecycler::memoryCost
+ */
+
+/**
+ * Removes recycled views until memoryCost is at most the given number of bytes.
+ *
+ *      @fn NIViewRecycler::reduceMemoryCostTo:
+ */
+
+/**
+ * Removes all of the recycled views. Called by Nimbus::memoryGovernor at the hard and critical
+ * pressure levels.
+ *
+ *      @fn NIViewRecycler::reduceMemoryUsage
+ */
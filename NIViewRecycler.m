@@ -27,7 +27,7 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)dealloc {
-  [[NSNotificationCenter defaultCenter] removeObserver:self];
+  [[Nimbus memoryGovernor] unregisterObject:self];
 
   NI_RELEASE_SAFELY(_reuseIdentifiersToRecycledViews);
 
@@ -40,11 +40,7 @@
   if ((self = [super init])) {
     _reuseIdentifiersToRecycledViews = [[NSMutableDictionary alloc] init];
 
-    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
-    [nc addObserver: self
-           selector: @selector(reduceMemoryUsage)
-               name: UIApplicationDidReceiveMemoryWarningNotification
-             object: nil];
+    [[Nimbus memoryGovernor] registerObject:self withPriority:NIMemoryPriorityNormal];
   }
   return self;
 }
@@ -62,6 +58,51 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static unsigned long long NIMemoryCostOfView(UIView* view) {
+  CGFloat scale = [[UIScreen mainScreen] scale];
+  CGSize size = view.bounds.size;
+  return (unsigned long long)(size.width * scale) * (unsigned long long)(size.height * scale) * 4;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (unsigned long long)memoryCost {
+  unsigned long long memoryCost = 0;
+  for (NSArray* views in [_reuseIdentifiersToRecycledViews objectEnumerator]) {
+    for (UIView* view in views) {
+      memoryCost += NIMemoryCostOfView(view);
+    }
+  }
+  return memoryCost;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryCostTo:(unsigned long long)memoryCost {
+  unsigned long long currentMemoryCost = [self memoryCost];
+
+  // Drop views from each pool in turn so that no single kind of view is emptied first.
+  BOOL didRemoveView = YES;
+  while (currentMemoryCost > memoryCost && didRemoveView) {
+    didRemoveView = NO;
+    for (NSMutableArray* views in [_reuseIdentifiersToRecycledViews objectEnumerator]) {
+      UIView* view = [views lastObject];
+      if (nil == view) {
+        continue;
+      }
+      currentMemoryCost -= MIN(currentMemoryCost, NIMemoryCostOfView(view));
+      [views removeLastObject];
+      didRemoveView = YES;
+
+      if (currentMemoryCost <= memoryCost) {
+        break;
+      }
+    }
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark - Public Methods
@@ -54,12 +54,16 @@
 
 #import "NIBlocks.h"
 #import "NICommonMetrics.h"
+#import "NIConcurrentMemoryCache.h"
 #import "NIDataStructures.h"
 #import "NIDebuggingTools.h"
 #import "NIDeviceOrientation.h"
 #import "NIError.h"
+#import "NIFrameMonitor.h"
 #import "NIFoundationMethods.h"
 #import "NIInMemoryCache.h"
+#import "NIMemoryCacheEvictionPolicy.h"
+#import "NIMemoryGovernor.h"
 #import "NINavigationAppearance.h"
 #import "NINetworkActivity.h"
 #import "NINonEmptyCollectionTesting.h"
@@ -70,4 +74,5 @@
 #import "NIRuntimeClassModifications.h"
 #import "NISDKAvailability.h"
 #import "NIState.h"
+#import "NITracing.h"
 #import "NIViewRecycler.h"
@@ -130,7 +130,9 @@
 
 #import "NIPhotoView.h"
 #import "NIPhotoViewDelegate.h"
+#import "NIPhotoViewTileSource.h"
 #import "NIPhotoViewPhotoSize.h"
+#import "NIStaticPhotoView.h"
 #import "NIPhotoScrubberView.h"
 #import "NIStripViewController.h"
 
@@ -18,6 +18,8 @@
 #import "NIStripViewController.h"
 #import "NimbusOperations.h"
 #import "NINetworkJSONRequest.h"
+#import "NSString+NimbusCore.h"
+#import "PhotoListSnapshot.h"
 
 @interface CatalogTableViewController () <NIOperationDelegate>
 
@@ -93,6 +95,15 @@
     return self;
 }
 
+/**
+ * Where the pruned photo list for an album url is snapshotted between launches.
+ */
+-(NSString*)snapshotPathForURL:(NSURL*)url
+{
+    NSString* fileName = [[[url absoluteString] md5Hash] stringByAppendingPathExtension:@"photos"];
+    return NIPathForCachesResource([@"PhotoLists" stringByAppendingPathComponent:fileName]);
+}
+
 -(void)loadContent
 {
     [self.queue cancelAllOperations];
@@ -103,6 +114,14 @@
             NSDictionary* response = [object objectForKey:@"response-data"];
             if (!response) {
                 NSURL* url = [NSURL URLWithString:[object objectForKey:@"url"]];
+                
+                // Serve last launch's photo list straight from the mapped snapshot. The request
+                // below still refreshes it, but nothing is decoded on the way to the first screen.
+                PhotoListSnapshot* snapshot = [PhotoListSnapshot snapshotWithContentsOfFile:[self snapshotPathForURL:url]];
+                if (snapshot) {
+                    [object setObject:snapshot forKey:@"response-data"];
+                }
+                
                 NINetworkJSONRequest* request = [[[NINetworkJSONRequest alloc] initWithURL:url] autorelease];
                 
                 // For request that are swlower
@@ -308,6 +327,11 @@
         }
     }
     operation.processedObject = photos;
+    
+    // Still on the processing thread, so next launch can skip the fetch/decode/prune above.
+    [PhotoListSnapshot writePhotos: photos
+                            toFile: [self snapshotPathForURL:operation.url]
+                             error: nil];
 }
 
 
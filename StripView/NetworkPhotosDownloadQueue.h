@@ -8,9 +8,16 @@
 
 #import <Foundation/Foundation.h>
 #import "NIInMemoryCache.h"
+#import "NIConcurrentMemoryCache.h"
 
 #define kHighQualityImageCacheNumberOfPixelsUnderStress 1024*1024*3
 
+// Default budget shared by all of the queue's image caches.
+#define kImageCachesMaxNumberOfBytes (24 * 1024 * 1024)
+
+// Default budget for the downloaded, still compressed, image data.
+#define kCompressedImageCacheMaxNumberOfBytes (8 * 1024 * 1024)
+
 /**
  * The operation queue that runs all of the network and processing operations.
  *
@@ -35,6 +42,11 @@ didLoadPhoto: (UIImage*) image
     NSMutableDictionary* _activeRequests;
     NSMutableDictionary* _imageCaches;
     id<NetworkPhotoAlbumQueueDelegate>_delegate;
+    NSUInteger _maxNumberOfBytes;
+    NIDataMemoryCache* _compressedImageCache;
+    NSMutableDictionary* _maxPixelDimensions;
+    NSMutableSet* _originalImageLoads;
+    NSMutableSet* _queuedRequests;
 }
 
 -(id)initWithImageCacheKeys:(NSSet*)types;
@@ -44,10 +56,68 @@ didLoadPhoto: (UIImage*) image
  */
 -(NIImageMemoryCache*)defaultCache;
 
--(NIImageMemoryCache*)cacheWithKey:(NSString*)cacheKey;
+/**
+ * The caches added with addImageCacheTypeWithKey: are thread safe, so images are decoded and
+ * stored from the download operations' threads.
+ */
+-(NIConcurrentImageMemoryCache*)cacheWithKey:(NSString*)cacheKey;
 
+/**
+ * If the decoded image has been evicted but its downloaded data is still in the
+ * compressedImageCache, the image is decoded again and stored back in its cache.
+ */
 -(UIImage*)imageAtPhotoIndex:(NSUInteger)photoIndex withCacheKey:(NSString*)cacheKey;
 
+/**
+ * Returns the image only if it is decoded in memory; nothing is decoded or downloaded.
+ *
+ * The lookup is a peek: it doesn't count as a hit or make the image look recently or
+ * frequently used to the cache.
+ */
+-(UIImage*)cachedImageAtPhotoIndex:(NSUInteger)photoIndex withCacheKey:(NSString*)cacheKey;
+
+/**
+ * Decodes the original image from the compressedImageCache at full resolution, ignoring the
+ * cache's maxPixelDimension.
+ *
+ * The image is decoded on a background thread and stored in the cache for cacheKey in place of
+ * the reduced image, so zooming into the same photo again doesn't decode it again. It is
+ * delivered to the delegate on the main thread like a downloaded photo. Nothing happens if the
+ * data has been evicted, or if the same original is already being decoded.
+ *
+ * Only call this from the main thread.
+ */
+-(void)requestOriginalImageAtPhotoIndex:(NSUInteger)photoIndex withCacheKey:(NSString*)cacheKey;
+
+/**
+ * Images stored in the cache for cacheKey are decoded with no more than this many pixels along
+ * their longer side, straight from the compressed data, so the full-size bitmap is never
+ * created. Smaller images are decoded as they are.
+ *
+ * Set it to the largest size the images are shown at, and use
+ * requestOriginalImageAtPhotoIndex:withCacheKey: when the user zooms in further. Takes effect
+ * for images requested afterwards.
+ *
+ * deafult: 0, which decodes images at full resolution.
+ */
+-(void)setMaxPixelDimension:(CGFloat)maxPixelDimension forCacheKey:(NSString*)cacheKey;
+-(CGFloat)maxPixelDimensionForCacheKey:(NSString*)cacheKey;
+
+/**
+ * Keeps the data of every downloaded image, so an image evicted from its cache can be decoded
+ * again instead of downloaded again.
+ *
+ * Only used from the main thread. Names have the form "%d-cacheKey".
+ */
+@property(nonatomic, readonly) NIDataMemoryCache* compressedImageCache;
+
+/**
+ * The budget for compressedImageCache, separate from maxNumberOfBytes. 0 means unlimited.
+ *
+ * deafult: kCompressedImageCacheMaxNumberOfBytes
+ */
+@property(nonatomic) NSUInteger maxNumberOfCompressedBytes;
+
 /**
  * creates a new new image cache for key.
  *
@@ -84,10 +154,31 @@ didLoadPhoto: (UIImage*) image
 - (void) cancelRequestWithWithCacheKey:(NSString*)cacheKey
                         andPhotoIndex:(NSInteger)photoIndex;
 
+/**
+ * Cancels the requests, of every cache key, for photos whose index is not in photoIndexes.
+ */
+- (void)cancelRequestsForPhotoIndexesNotInSet:(NSIndexSet*)photoIndexes;
+
 /*
  * deafult priority:NSOperationQueuePriorityNormal
  */
 
 @property(nonatomic) NSOperationQueuePriority defaultPriority;
 
+/**
+ * The number of bytes used by the decoded bitmaps in all of the image caches added with
+ * addImageCacheTypeWithKey:.
+ */
+-(NSUInteger)numberOfBytes;
+
+/**
+ * A memory budget shared by all of the image caches added with addImageCacheTypeWithKey:.
+ *
+ * When a loaded image takes the caches over budget, images are evicted from whichever cache
+ * is using the most memory until the total fits. 0 means unlimited.
+ *
+ * deafult: kImageCachesMaxNumberOfBytes
+ */
+@property(nonatomic) NSUInteger maxNumberOfBytes;
+
 @end
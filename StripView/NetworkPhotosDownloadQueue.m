@@ -7,11 +7,65 @@
 //
 
 #import "NetworkPhotosDownloadQueue.h"
+#import "NIDebuggingTools.h"
+#import "NIFrameMonitor.h"
+#import "NIMemoryCacheEvictionPolicy.h"
+#import "NIOverview.h"
+
+#import <ImageIO/ImageIO.h>
+
+/**
+ * Decodes data with no more than maxPixelDimension pixels along the longer side.
+ *
+ * ImageIO scales JPEGs down while decoding them, which takes a fraction of the time and
+ * memory of decoding the full image and scaling it afterwards.
+ */
+static UIImage* NetworkPhotosDecodeImageWithData(NSData* data, CGFloat maxPixelDimension)
+{
+    if (nil == data) {
+        return nil;
+    }
+    if (maxPixelDimension <= 0) {
+        return [UIImage imageWithData:data];
+    }
+    
+    CGImageSourceRef source = CGImageSourceCreateWithData((CFDataRef)data, NULL);
+    if (NULL == source) {
+        return nil;
+    }
+    
+    // The pixel size comes from the header; nothing has been decoded yet.
+    NSDictionary* properties = (NSDictionary*)CGImageSourceCopyPropertiesAtIndex(source, 0, NULL);
+    CGFloat width = [[properties objectForKey:(NSString*)kCGImagePropertyPixelWidth] floatValue];
+    CGFloat height = [[properties objectForKey:(NSString*)kCGImagePropertyPixelHeight] floatValue];
+    [properties release];
+    
+    UIImage* image = nil;
+    if (MAX(width, height) <= maxPixelDimension) {
+        image = [UIImage imageWithData:data];
+        
+    } else {
+        NSDictionary* options = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 (id)kCFBooleanTrue, (id)kCGImageSourceCreateThumbnailFromImageAlways,
+                                 (id)kCFBooleanTrue, (id)kCGImageSourceCreateThumbnailWithTransform,
+                                 [NSNumber numberWithFloat:maxPixelDimension], (id)kCGImageSourceThumbnailMaxPixelSize,
+                                 nil];
+        CGImageRef imageRef = CGImageSourceCreateThumbnailAtIndex(source, 0, (CFDictionaryRef)options);
+        if (NULL != imageRef) {
+            image = [UIImage imageWithCGImage:imageRef];
+            CGImageRelease(imageRef);
+        }
+    }
+    CFRelease(source);
+    return image;
+}
 
 @implementation NetworkPhotosDownloadQueue
 
 @synthesize delegate = _delegate;
 @synthesize defaultPriority;
+@synthesize maxNumberOfBytes = _maxNumberOfBytes;
+@synthesize compressedImageCache = _compressedImageCache;
 
 #pragma mark -
 #pragma mark NSObject
@@ -24,6 +78,13 @@
         _activeRequests = [[NSMutableDictionary alloc] init];
         _imageCaches = [[NSMutableDictionary alloc] init];
         self.defaultPriority = NSOperationQueuePriorityNormal;
+        _maxNumberOfBytes = kImageCachesMaxNumberOfBytes;
+        _compressedImageCache = [[NIDataMemoryCache alloc] init];
+        _compressedImageCache.maxNumberOfBytes = kCompressedImageCacheMaxNumberOfBytes;
+        [NIOverview addMemoryCache:_compressedImageCache withTitle:@"Compressed"];
+        _maxPixelDimensions = [[NSMutableDictionary alloc] init];
+        _originalImageLoads = [[NSMutableSet alloc] init];
+        _queuedRequests = [[NSMutableSet alloc] init];
         [self setMaxConcurrentOperationCount:5];
         
         [self addImageCacheTypeWithKeys:types
@@ -41,13 +102,24 @@
 }
 
 - (void)dealloc {
+    for (NIConcurrentImageMemoryCache* imageCache in [_imageCaches allValues]) {
+        [NIOverview removeMemoryCache:imageCache];
+    }
+    [NIOverview removeMemoryCache:_compressedImageCache];
     for (NINetworkRequestOperation* request in self.operations) {
         request.delegate = nil;
     }
+    for (NINetworkRequestOperation* request in [_queuedRequests allObjects]) {
+        [self endQueuedSpanOfRequest:request];
+    }
     [self cancelAllOperations];
     
     NI_RELEASE_SAFELY(_activeRequests);
     NI_RELEASE_SAFELY(_imageCaches);
+    NI_RELEASE_SAFELY(_compressedImageCache);
+    NI_RELEASE_SAFELY(_maxPixelDimensions);
+    NI_RELEASE_SAFELY(_originalImageLoads);
+    NI_RELEASE_SAFELY(_queuedRequests);
     [super dealloc];
 }
 
@@ -61,15 +133,24 @@
     
     number = MIN(kHighQualityImageCacheNumberOfPixelsUnderStress, number);
     
-    NIImageMemoryCache* newImageCache = [_imageCaches objectForKey:imageCacheTypeKey];
+    NIConcurrentImageMemoryCache* newImageCache = [_imageCaches objectForKey:imageCacheTypeKey];
     if (!newImageCache) {
         
-        newImageCache = [[[NIImageMemoryCache alloc] init] autorelease];
+        newImageCache = [[[NIConcurrentImageMemoryCache alloc] init] autorelease];
         if (NSNotFound != number) {
             [newImageCache setMaxNumberOfPixelsUnderStress:number];
         }
         
+        // Flinging through the strip touches every photo once; keep the ones the user returns to.
+        NSUInteger expectedNumberOfImagesPerShard = 256 / [newImageCache numberOfShards];
+        [newImageCache enumerateShardsUsingBlock:^(id shard) {
+            NIWTinyLFUEvictionPolicy* policy = [[NIWTinyLFUEvictionPolicy alloc] initWithExpectedNumberOfObjects:expectedNumberOfImagesPerShard];
+            [shard setEvictionPolicy:policy];
+            [policy release];
+        }];
+        
         [_imageCaches setObject:newImageCache forKey:imageCacheTypeKey];
+        [NIOverview addMemoryCache:newImageCache withTitle:[imageCacheTypeKey description]];
     }
 }
 
@@ -82,14 +163,96 @@
     }
 }
 
+static UIImage* NetworkPhotosImageWithData(NSData* data, CGFloat maxPixelDimension)
+{
+    // Decoding on the main thread stalls whatever frame it lands in.
+    NIFrameWork previousWork = NIFrameMonitorBeginWork(NIFrameWorkDecode);
+    NIDTRACEBEGIN("NetworkPhotosDownloadQueue.decode");
+    UIImage* image = NetworkPhotosDecodeImageWithData(data, maxPixelDimension);
+    NIDTRACEEND("NetworkPhotosDownloadQueue.decode");
+    NIFrameMonitorEndWork(previousWork);
+    return image;
+}
+
 -(UIImage*)imageAtPhotoIndex:(NSUInteger)photoIndex withCacheKey:(NSString*)cacheKey
 {
-    NIImageMemoryCache* cache = [_imageCaches objectForKey:cacheKey];
+    NSString* name = [self cacheKeyForPhotoIndex:photoIndex];
+    NIConcurrentImageMemoryCache* cache = [_imageCaches objectForKey:cacheKey];
     if (!cache) {
-        cache = [self defaultCache];
+        return [[self defaultCache] objectWithName:name];
     }
     
-    return [cache objectWithName:[self cacheKeyForPhotoIndex:photoIndex]];
+    UIImage* image = [cache objectWithName:name];
+    if (nil == image) {
+        // Decoding the downloaded data again is much quicker than downloading it again.
+        NSData* data = [_compressedImageCache objectWithName:[self identifierKeyWithCacheKey:cacheKey
+                                                                                       index:photoIndex]];
+        if (nil != data) {
+            image = NetworkPhotosImageWithData(data, [self maxPixelDimensionForCacheKey:cacheKey]);
+            [cache storeObject:image withName:name];
+            [self reduceImageCachesToMaxNumberOfBytes:self.maxNumberOfBytes];
+        }
+    }
+    return image;
+}
+
+-(UIImage*)cachedImageAtPhotoIndex:(NSUInteger)photoIndex withCacheKey:(NSString*)cacheKey
+{
+    NSString* name = [self cacheKeyForPhotoIndex:photoIndex];
+    NIConcurrentImageMemoryCache* cache = [_imageCaches objectForKey:cacheKey];
+    if (!cache) {
+        return [[self defaultCache] peekObjectWithName:name];
+    }
+    // A peek, so that photos flicked past don't look popular to the cache.
+    return [cache peekObjectWithName:name];
+}
+
+-(void)requestOriginalImageAtPhotoIndex:(NSUInteger)photoIndex withCacheKey:(NSString*)cacheKey
+{
+    NIDASSERT([NSThread isMainThread]);
+    NSString* identifierKey = [self identifierKeyWithCacheKey:cacheKey index:photoIndex];
+    NSData* data = [_compressedImageCache objectWithName:identifierKey];
+    if (nil == data || [_originalImageLoads containsObject:identifierKey]) {
+        return;
+    }
+    [_originalImageLoads addObject:identifierKey];
+    
+    NSString* name = [self cacheKeyForPhotoIndex:photoIndex];
+    NIConcurrentImageMemoryCache* cache = [_imageCaches objectForKey:cacheKey];
+    
+    // Decoding the full original takes long enough to stall the zoom gesture that asked for it.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+        UIImage* image = NetworkPhotosImageWithData(data, 0);
+        [cache storeObject:image withName:name];
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [_originalImageLoads removeObject:identifierKey];
+            if (nil != image) {
+                [self reduceImageCachesToMaxNumberOfBytes:self.maxNumberOfBytes];
+                [self.delegate queue:self didLoadPhoto:image atIndex:photoIndex cacheKey:cacheKey];
+            }
+        });
+    });
+}
+
+-(void)setMaxPixelDimension:(CGFloat)maxPixelDimension forCacheKey:(NSString*)cacheKey
+{
+    [_maxPixelDimensions setObject:[NSNumber numberWithFloat:maxPixelDimension] forKey:cacheKey];
+}
+
+-(CGFloat)maxPixelDimensionForCacheKey:(NSString*)cacheKey
+{
+    return [[_maxPixelDimensions objectForKey:cacheKey] floatValue];
+}
+
+-(NSUInteger)maxNumberOfCompressedBytes
+{
+    return _compressedImageCache.maxNumberOfBytes;
+}
+
+-(void)setMaxNumberOfCompressedBytes:(NSUInteger)maxNumberOfCompressedBytes
+{
+    _compressedImageCache.maxNumberOfBytes = maxNumberOfCompressedBytes;
 }
 
             
@@ -98,11 +261,47 @@
     return [Nimbus imageMemoryCache];
 }
 
--(NIImageMemoryCache*)cacheWithKey:(NSString*)cacheKey
+-(NIConcurrentImageMemoryCache*)cacheWithKey:(NSString*)cacheKey
 {
     return [_imageCaches objectForKey:cacheKey];
 }
 
+-(NSUInteger)numberOfBytes
+{
+    NSUInteger numberOfBytes = 0;
+    for (NIConcurrentImageMemoryCache* cache in [_imageCaches objectEnumerator]) {
+        numberOfBytes += cache.numberOfBytes;
+    }
+    return numberOfBytes;
+}
+
+-(void)reduceImageCachesToMaxNumberOfBytes:(NSUInteger)maxNumberOfBytes
+{
+    if (0 == maxNumberOfBytes) {
+        return;
+    }
+    
+    // Take from the tier using the most memory, so the high-res images go before the
+    // thumbnails that are cheap to keep.
+    while ([self numberOfBytes] > maxNumberOfBytes) {
+        NIConcurrentImageMemoryCache* largestCache = nil;
+        for (NIConcurrentImageMemoryCache* cache in [_imageCaches objectEnumerator]) {
+            if (nil == largestCache || cache.numberOfBytes > largestCache.numberOfBytes) {
+                largestCache = cache;
+            }
+        }
+        if (nil == largestCache || ![largestCache evictObject]) {
+            break;
+        }
+    }
+}
+
+-(void)setMaxNumberOfBytes:(NSUInteger)maxNumberOfBytes
+{
+    _maxNumberOfBytes = maxNumberOfBytes;
+    [self reduceImageCachesToMaxNumberOfBytes:maxNumberOfBytes];
+}
+
 
 -(NSString*) identifierKeyWithCacheKey:(NSString*)cacheKey index:(NSUInteger) photoIndex
 {
@@ -126,7 +325,7 @@
                       priority:(NSOperationQueuePriority)priorty
 {
     
-    NIImageMemoryCache* imageCache = [_imageCaches objectForKey:cacheKey];
+    NIConcurrentImageMemoryCache* imageCache = [_imageCaches objectForKey:cacheKey];
     NSAssert1(imageCache, @"didn't find image cache with cache key %@", cacheKey);
 
     // Do not load the thumbnail if it's already in memory, or is already downloading 
@@ -143,22 +342,53 @@
     // __block is used here to avoid retain cycle. self is retained on the imageDownloadOperation compltion blocks.
     __block NINetworkRequestOperation* imageDownloadOperation = [[[NINetworkRequestOperation alloc] initWithURL:url] autorelease];
     imageDownloadOperation.timeout = 30;
+    imageDownloadOperation.tag = photoIndex;
         
     NSString* photoIndexKey = [self cacheKeyForPhotoIndex:photoIndex];
+    CGFloat maxPixelDimension = [self maxPixelDimensionForCacheKey:cacheKey];
+    
+    // The operation is the trace identifier, so the time spent waiting in the queue and the time
+    // spent downloading show up as separate spans for each request. An operation that is canceled
+    // before it starts never runs any of its blocks, so the cancel methods end its "queued" span
+    // instead. The "download" span is only begun if the "queued" span was still open when the
+    // operation started. The blocks and the cancel methods all run on the main thread.
+    __block BOOL didStart = NO;
+    [imageDownloadOperation setDidStartBlock:^(NIOperation* operation) {
+        if ([self endQueuedSpanOfRequest:operation]) {
+            didStart = YES;
+            NIDTRACEASYNCBEGIN("NetworkPhotosDownloadQueue.download", operation);
+        }
+    }];
+    
+    // The image cache is thread safe, so the image is created and stored on the operation's
+    // thread instead of waiting for the main thread.
+    [imageDownloadOperation setWillFinishBlock:^(NIOperation* operation) {
+        UIImage* image = NetworkPhotosImageWithData(imageDownloadOperation.data, maxPixelDimension);
+        [imageCache storeObject:image withName:photoIndexKey];
+    }];
     
     [imageDownloadOperation setDidFinishBlock:^(NIOperation* operation) {
 
         // this is the main thread.
         assert([NSThread isMainThread]);
+        if (didStart) {
+            NIDTRACEASYNCEND("NetworkPhotosDownloadQueue.download", operation);
+        }
         
-        UIImage* image = [UIImage imageWithData:imageDownloadOperation.data];
+        // The image may already have been evicted by another store. Peeking doesn't count the
+        // image that was just stored as a hit.
+        UIImage* image = [imageCache peekObjectWithName:photoIndexKey];
+        if (nil == image) {
+            image = NetworkPhotosImageWithData(imageDownloadOperation.data, maxPixelDimension);
+        }
         
-        // Store the image in the correct image cache.
-        NIImageMemoryCache* imageCache = [_imageCaches objectForKey:cacheKey];
-        if (!imageCache) {
-            imageCache = [self defaultCache];
+        // Keep the compressed data around for when the decoded image is evicted.
+        if (nil != image) {
+            [_compressedImageCache storeObject:imageDownloadOperation.data
+                                      withName:imageDownloadOperationIdentifierKey];
         }
-        [imageCache storeObject:image withName:photoIndexKey];
+        
+        [self reduceImageCachesToMaxNumberOfBytes:self.maxNumberOfBytes];
         
         // this 
         [self.delegate queue:self didLoadPhoto:image atIndex:photoIndex cacheKey:cacheKey];
@@ -167,14 +397,21 @@
         //      [self.photoScrubberView didLoadThumbnail:image atIndex:photoIndex];
         //    }
         
-        [_activeRequests setObject:imageDownloadOperation
-                            forKey:imageDownloadOperationIdentifierKey];
+        // A newer request for the same photo may have replaced this one.
+        if ([_activeRequests objectForKey:imageDownloadOperationIdentifierKey] == operation) {
+            [_activeRequests removeObjectForKey:imageDownloadOperationIdentifierKey];
+        }
     }];
     
     // When this request is canceled (like when we're quickly flipping through an album)
     // the request will fail, so we must be careful to remove the request from the active set.
     [imageDownloadOperation setDidFailWithErrorBlock:^(NIOperation* operation, NSError* error) {
-        [_activeRequests removeObjectForKey:imageDownloadOperationIdentifierKey];
+        if (didStart) {
+            NIDTRACEASYNCEND("NetworkPhotosDownloadQueue.download", operation);
+        }
+        if ([_activeRequests objectForKey:imageDownloadOperationIdentifierKey] == operation) {
+            [_activeRequests removeObjectForKey:imageDownloadOperationIdentifierKey];
+        }
     }];
     
     
@@ -186,9 +423,23 @@
     [_activeRequests setObject:imageDownloadOperation
                         forKey:imageDownloadOperationIdentifierKey];
     
+    [_queuedRequests addObject:imageDownloadOperation];
+    NIDTRACEASYNCBEGIN("NetworkPhotosDownloadQueue.queued", imageDownloadOperation);
     [self addOperation:imageDownloadOperation];
 }
 
+// Ends the request's "queued" trace span if it is still open. Returns NO if the request has
+// already started or been canceled.
+- (BOOL)endQueuedSpanOfRequest:(NIOperation*)request
+{
+    if (![_queuedRequests containsObject:request]) {
+        return NO;
+    }
+    NIDTRACEASYNCEND("NetworkPhotosDownloadQueue.queued", request);
+    [_queuedRequests removeObject:request];
+    return YES;
+}
+
 - (void)requestImageFromSource:(NSString *)source
                       cacheKey:(NSString*)cacheKey
                     photoIndex:(NSInteger)photoIndex {
@@ -204,9 +455,24 @@
 {
     NSString* operationIdentifyer = [self identifierKeyWithCacheKey:cacheKey index:photoIndex];
     NINetworkRequestOperation* operation = [_activeRequests objectForKey:operationIdentifyer];
-    [_activeRequests removeObjectForKey:operation];
+    [_activeRequests removeObjectForKey:operationIdentifyer];
+    [self endQueuedSpanOfRequest:operation];
     [operation cancel];
 }
 
+- (void)cancelRequestsForPhotoIndexesNotInSet:(NSIndexSet*)photoIndexes
+{
+    // Each request is tagged with its photo index. Finished requests have already left
+    // _activeRequests, so only the pending ones are walked.
+    for (NSString* identifier in [_activeRequests allKeys]) {
+        NINetworkRequestOperation* operation = [_activeRequests objectForKey:identifier];
+        if (![photoIndexes containsIndex:operation.tag]) {
+            [_activeRequests removeObjectForKey:identifier];
+            [self endQueuedSpanOfRequest:operation];
+            [operation cancel];
+        }
+    }
+}
+
 
 @end
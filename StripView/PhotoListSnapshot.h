@@ -0,0 +1,66 @@
+//
+// Copyright 2012 Amos Elmaliah
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A read-only list of pruned photo info backed by a memory-mapped binary snapshot.
+ *
+ * The snapshot is a fixed header followed by a struct-of-arrays (widths, heights and
+ * string references for the original and thumbnail sources) and a UTF-8 string table.
+ * Nothing is decoded when the snapshot is opened; each photo's info dictionary is built
+ * the first time it is asked for.
+ *
+ * PhotoListSnapshot is an NSArray, so it can be handed straight to
+ * NIStripViewController's photos property. Each object is an NSDictionary with the same
+ * keys CatalogTableViewController produces from the JSON response:
+ *
+ * - @"originalSource": NSString
+ * - @"thumbnailSource": NSString
+ * - @"dimensions": NSValue wrapping a CGSize
+ *
+ * Snapshots are versioned. A snapshot written by a different version, or one that
+ * fails validation, is treated as missing.
+ */
+@interface PhotoListSnapshot : NSArray {
+@private
+    NSData* _data;
+    NSUInteger _count;
+    const float* _widths;
+    const float* _heights;
+    const void* _originalSources;
+    const void* _thumbnailSources;
+    const char* _stringTable;
+    id* _photoInfos;
+}
+
+/**
+ * Memory-maps and validates the snapshot at path.
+ *
+ *      @returns nil if the file does not exist, was written by another snapshot version,
+ *               or is malformed.
+ */
++ (id)snapshotWithContentsOfFile:(NSString *)path;
+
+/**
+ * Writes an array of pruned photo info dictionaries to path as a snapshot.
+ *
+ * The file is written atomically, so snapshots that are currently mapped stay valid.
+ * Intermediate directories are created as needed. Safe to call from a background thread.
+ */
++ (BOOL)writePhotos:(NSArray *)photos toFile:(NSString *)path error:(NSError **)error;
+
+@end
@@ -0,0 +1,302 @@
+//
+// Copyright 2012 Amos Elmaliah
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "PhotoListSnapshot.h"
+
+#import <UIKit/UIKit.h>
+#import <libkern/OSAtomic.h>
+#import "NimbusCore.h"
+
+// Bump the version whenever the layout below changes. Old snapshots are then ignored and
+// rewritten after the next successful fetch.
+static const uint32_t kPhotoListSnapshotMagic = 'NIPL';
+static const uint32_t kPhotoListSnapshotVersion = 1;
+static const uint32_t kPhotoListSnapshotNoString = UINT32_MAX;
+
+// All sections are 4-byte aligned and the offsets are relative to the start of the file.
+// Integers are in host byte order; a byte-swapped magic is rejected like any other mismatch.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t widthsOffset;            // float[count]
+    uint32_t heightsOffset;           // float[count]
+    uint32_t originalSourcesOffset;   // PhotoListSnapshotStringRef[count]
+    uint32_t thumbnailSourcesOffset;  // PhotoListSnapshotStringRef[count]
+    uint32_t stringTableOffset;
+    uint32_t stringTableLength;
+    uint32_t reserved;
+} PhotoListSnapshotHeader;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t length;                  // kPhotoListSnapshotNoString if the source was missing.
+} PhotoListSnapshotStringRef;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation PhotoListSnapshot
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+    if (NULL != _photoInfos) {
+        for (NSUInteger ix = 0; ix < _count; ++ix) {
+            [_photoInfos[ix] release];
+        }
+        free(_photoInfos);
+        _photoInfos = NULL;
+    }
+    NI_RELEASE_SAFELY(_data);
+
+    [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static BOOL PhotoListSnapshotSectionIsValid(uint32_t offset, size_t size, NSUInteger dataLength) {
+    return ((offset % sizeof(uint32_t)) == 0
+            && offset >= sizeof(PhotoListSnapshotHeader)
+            && offset <= dataLength
+            && size <= dataLength - offset);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static BOOL PhotoListSnapshotStringsAreValid(const PhotoListSnapshotStringRef* refs,
+                                             NSUInteger count,
+                                             uint32_t stringTableLength) {
+    for (NSUInteger ix = 0; ix < count; ++ix) {
+        if (kPhotoListSnapshotNoString == refs[ix].length) {
+            continue;
+        }
+        if (refs[ix].offset > stringTableLength
+            || refs[ix].length > stringTableLength - refs[ix].offset) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithMappedData:(NSData *)data {
+    self = [super init];
+    if (self) {
+        const unsigned char* bytes = [data bytes];
+        NSUInteger length = [data length];
+        const PhotoListSnapshotHeader* header = (const PhotoListSnapshotHeader *)bytes;
+
+        if (length < sizeof(PhotoListSnapshotHeader)
+            || header->magic != kPhotoListSnapshotMagic
+            || header->version != kPhotoListSnapshotVersion) {
+            [self release];
+            return nil;
+        }
+
+        size_t floatsSize = (size_t)header->count * sizeof(float);
+        size_t refsSize = (size_t)header->count * sizeof(PhotoListSnapshotStringRef);
+        if (!PhotoListSnapshotSectionIsValid(header->widthsOffset, floatsSize, length)
+            || !PhotoListSnapshotSectionIsValid(header->heightsOffset, floatsSize, length)
+            || !PhotoListSnapshotSectionIsValid(header->originalSourcesOffset, refsSize, length)
+            || !PhotoListSnapshotSectionIsValid(header->thumbnailSourcesOffset, refsSize, length)
+            || !PhotoListSnapshotSectionIsValid(header->stringTableOffset, header->stringTableLength, length)) {
+            [self release];
+            return nil;
+        }
+
+        _data = [data retain];
+        _count = header->count;
+        _widths = (const float *)(bytes + header->widthsOffset);
+        _heights = (const float *)(bytes + header->heightsOffset);
+        _originalSources = bytes + header->originalSourcesOffset;
+        _thumbnailSources = bytes + header->thumbnailSourcesOffset;
+        _stringTable = (const char *)(bytes + header->stringTableOffset);
+
+        if (!PhotoListSnapshotStringsAreValid(_originalSources, _count, header->stringTableLength)
+            || !PhotoListSnapshotStringsAreValid(_thumbnailSources, _count, header->stringTableLength)) {
+            [self release];
+            return nil;
+        }
+
+        if (_count > 0) {
+            _photoInfos = calloc(_count, sizeof(id));
+            if (NULL == _photoInfos) {
+                [self release];
+                return nil;
+            }
+        }
+    }
+    return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (id)snapshotWithContentsOfFile:(NSString *)path {
+    // Mapping means the first screen of photos only pages in the bytes it touches.
+    NSData* data = [NSData dataWithContentsOfFile: path
+                                          options: NSDataReadingMappedAlways
+                                            error: nil];
+    if (nil == data) {
+        return nil;
+    }
+    return [[[self alloc] initWithMappedData:data] autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark NSArray
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)count {
+    return _count;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSString *)stringForRef:(PhotoListSnapshotStringRef)ref {
+    if (kPhotoListSnapshotNoString == ref.length) {
+        return nil;
+    }
+    return [[[NSString alloc] initWithBytes: _stringTable + ref.offset
+                                     length: ref.length
+                                   encoding: NSUTF8StringEncoding] autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)objectAtIndex:(NSUInteger)index {
+    if (index >= _count) {
+        [NSException raise: NSRangeException
+                    format: @"index %lu beyond bounds [0 .. %lu]",
+         (unsigned long)index, (unsigned long)_count];
+    }
+
+    id photoInfo = _photoInfos[index];
+    if (nil == photoInfo) {
+        const PhotoListSnapshotStringRef* originalSources = _originalSources;
+        const PhotoListSnapshotStringRef* thumbnailSources = _thumbnailSources;
+
+        NSMutableDictionary* info = [[NSMutableDictionary alloc] initWithCapacity:3];
+        NSString* originalSource = [self stringForRef:originalSources[index]];
+        NSString* thumbnailSource = [self stringForRef:thumbnailSources[index]];
+        if (nil != originalSource) {
+            [info setObject:originalSource forKey:@"originalSource"];
+        }
+        if (nil != thumbnailSource) {
+            [info setObject:thumbnailSource forKey:@"thumbnailSource"];
+        }
+        [info setObject: [NSValue valueWithCGSize:CGSizeMake(_widths[index], _heights[index])]
+                 forKey: @"dimensions"];
+
+        photoInfo = [info copy];
+        [info release];
+
+        // Snapshots are handed to other threads like any NSArray, so two threads may build the
+        // same info at once. The first one to publish it wins and the other's copy is dropped.
+        if (!OSAtomicCompareAndSwapPtrBarrier(nil, photoInfo, (void* volatile *)&_photoInfos[index])) {
+            [photoInfo release];
+            photoInfo = _photoInfos[index];
+        }
+    }
+    return photoInfo;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Writing
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static PhotoListSnapshotStringRef PhotoListSnapshotAppendString(NSMutableData* stringTable, id string) {
+    PhotoListSnapshotStringRef ref = { 0, kPhotoListSnapshotNoString };
+    if ([string isKindOfClass:[NSString class]]) {
+        NSData* utf8 = [string dataUsingEncoding:NSUTF8StringEncoding];
+        ref.offset = (uint32_t)[stringTable length];
+        ref.length = (uint32_t)[utf8 length];
+        [stringTable appendData:utf8];
+    }
+    return ref;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (BOOL)writePhotos:(NSArray *)photos toFile:(NSString *)path error:(NSError **)error {
+    NSUInteger count = [photos count];
+    size_t floatsSize = count * sizeof(float);
+    size_t refsSize = count * sizeof(PhotoListSnapshotStringRef);
+
+    float* widths = malloc(floatsSize + 1);
+    float* heights = malloc(floatsSize + 1);
+    PhotoListSnapshotStringRef* originalSources = malloc(refsSize + 1);
+    PhotoListSnapshotStringRef* thumbnailSources = malloc(refsSize + 1);
+    NSMutableData* stringTable = [NSMutableData data];
+    BOOL didWrite = NO;
+
+    if (NULL != widths && NULL != heights && NULL != originalSources && NULL != thumbnailSources) {
+        for (NSUInteger ix = 0; ix < count; ++ix) {
+            NSDictionary* photo = [photos objectAtIndex:ix];
+            CGSize dimensions = [[photo objectForKey:@"dimensions"] CGSizeValue];
+            widths[ix] = dimensions.width;
+            heights[ix] = dimensions.height;
+            originalSources[ix] = PhotoListSnapshotAppendString(stringTable, [photo objectForKey:@"originalSource"]);
+            thumbnailSources[ix] = PhotoListSnapshotAppendString(stringTable, [photo objectForKey:@"thumbnailSource"]);
+        }
+
+        PhotoListSnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = kPhotoListSnapshotMagic;
+        header.version = kPhotoListSnapshotVersion;
+        header.count = (uint32_t)count;
+        header.widthsOffset = sizeof(PhotoListSnapshotHeader);
+        header.heightsOffset = header.widthsOffset + floatsSize;
+        header.originalSourcesOffset = header.heightsOffset + floatsSize;
+        header.thumbnailSourcesOffset = header.originalSourcesOffset + refsSize;
+        header.stringTableOffset = header.thumbnailSourcesOffset + refsSize;
+        header.stringTableLength = (uint32_t)[stringTable length];
+
+        NSMutableData* data = [NSMutableData dataWithCapacity:header.stringTableOffset + header.stringTableLength];
+        [data appendBytes:&header length:sizeof(header)];
+        [data appendBytes:widths length:floatsSize];
+        [data appendBytes:heights length:floatsSize];
+        [data appendBytes:originalSources length:refsSize];
+        [data appendBytes:thumbnailSources length:refsSize];
+        [data appendData:stringTable];
+
+        [[NSFileManager defaultManager] createDirectoryAtPath: [path stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories: YES
+                                                   attributes: nil
+                                                        error: nil];
+        didWrite = [data writeToFile:path options:NSDataWritingAtomic error:error];
+    }
+
+    free(widths);
+    free(heights);
+    free(originalSources);
+    free(thumbnailSources);
+
+    return didWrite;
+}
+
+
+@end